@@ -0,0 +1,111 @@
+#include "benchmark_utils.hpp"
+
+#include "libslic3r/Model.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/nowide/iostream.hpp>
+
+namespace Slic3r { namespace Benchmark {
+
+static const char* option_argument(const std::string &name)
+{
+    return name == "threads"    ? "1,2,4,8" :
+           name == "repeat"     ? "N" :
+           name == "technology" ? "FFF|SLA" :
+           name == "filter"     ? "substring" :
+           name == "data-dir"   ? "DIR" :
+           name == "output"     ? "results.json" : "value";
+}
+
+static bool usage(const char *program, const std::vector<std::string> &accepted)
+{
+    boost::nowide::cerr << "Usage: " << program;
+    for (const std::string &name : accepted)
+        boost::nowide::cerr << " [--" << name << " " << option_argument(name) << "]";
+    boost::nowide::cerr << std::endl;
+    return false;
+}
+
+bool parse_options(int argc, char **argv, const std::vector<std::string> &accepted, Options &options)
+{
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 == argc || strncmp(argv[i], "--", 2) != 0)
+            return usage(argv[0], accepted);
+        const std::string name  = argv[i] + 2;
+        const char       *value = argv[i + 1];
+        if (std::find(accepted.begin(), accepted.end(), name) == accepted.end())
+            return usage(argv[0], accepted);
+        if (name == "threads") {
+            std::vector<std::string> counts;
+            boost::split(counts, value, boost::is_any_of(","));
+            for (const std::string &count : counts)
+                options.threads.emplace_back(std::max(1, atoi(count.c_str())));
+        } else if (name == "repeat")
+            options.repeat = std::max(1, atoi(value));
+        else if (name == "technology")
+            options.technology = value;
+        else if (name == "filter")
+            options.filter = value;
+        else if (name == "data-dir")
+            options.data_dir = value;
+        else if (name == "output")
+            options.output = value;
+        else
+            return usage(argv[0], accepted);
+    }
+    return true;
+}
+
+std::vector<boost::filesystem::path> model_paths(const std::string &data_dir, const std::string &filter)
+{
+    std::vector<boost::filesystem::path> paths;
+    for (const boost::filesystem::directory_entry &entry : boost::filesystem::directory_iterator(data_dir))
+        if (boost::filesystem::is_regular_file(entry.status()) && boost::iequals(entry.path().extension().string(), ".obj") &&
+            (filter.empty() || entry.path().stem().string().find(filter) != std::string::npos))
+            paths.emplace_back(entry.path());
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+std::vector<ExPolygons> slice_model(const boost::filesystem::path &path, double layer_height)
+{
+    Model        model = Model::read_from_file(path.string());
+    TriangleMesh mesh  = model.mesh();
+    mesh.repair();
+    mesh.require_shared_vertices();
+    BoundingBoxf3 bbox = mesh.bounding_box();
+    std::vector<float> z;
+    for (double h = bbox.min.z() + 0.5 * layer_height; h < bbox.max.z(); h += layer_height)
+        z.emplace_back(float(h));
+    std::vector<ExPolygons> layers;
+    TriangleMeshSlicer(&mesh).slice(z, SlicingMode::Regular, 0.f, &layers, [](){});
+    return layers;
+}
+
+bool write_results(const std::string &output, const std::function<void(std::ostream&)> &write_json)
+{
+    if (output.empty()) {
+        write_json(boost::nowide::cout);
+        boost::nowide::cout.flush();
+        return true;
+    }
+    boost::nowide::ofstream out(output);
+    write_json(out);
+    out.close();
+    if (! out) {
+        boost::nowide::cerr << "Writing the benchmark results to " << output << " failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} } // namespace Slic3r::Benchmark
@@ -0,0 +1,55 @@
+#ifndef SLIC3R_BENCHMARK_UTILS_HPP
+#define SLIC3R_BENCHMARK_UTILS_HPP
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/ExPolygon.hpp"
+
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+namespace Slic3r { namespace Benchmark {
+
+// Command line options shared by the benchmarks, each benchmark accepts a subset of them.
+struct Options
+{
+    // --threads 1,2,4,8
+    std::vector<int>    threads;
+    // --repeat N
+    int                 repeat      = 1;
+    // --technology FFF|SLA
+    std::string         technology;
+    // --filter substring: Only the models with the substring in their name are benchmarked.
+    std::string         filter;
+    // --data-dir DIR
+    std::string         data_dir    = BENCHMARK_DATA_DIR;
+    // --output results.json: The JSON is written to stdout if not set.
+    std::string         output;
+};
+
+// Parses the "--name value" pairs of the options named in accepted (without the leading dashes).
+// Prints the usage to stderr and returns false on an unknown option or a missing value.
+bool parse_options(int argc, char **argv, const std::vector<std::string> &accepted, Options &options);
+
+template<typename Clock> double seconds_since(typename Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Paths of the .obj models in data_dir with the filter in their name, sorted by name.
+std::vector<boost::filesystem::path> model_paths(const std::string &data_dir, const std::string &filter);
+
+// Slices the mesh of the model stored at path into layers of layer_height, starting at the bottom of the mesh.
+std::vector<ExPolygons> slice_model(const boost::filesystem::path &path, double layer_height);
+
+// Writes the JSON by write_json into the output file, or to stdout if output is empty. The progress of the benchmarks
+// is reported to stderr, so that stdout only receives the JSON. Returns false if the output file could not be written.
+bool write_results(const std::string &output, const std::function<void(std::ostream&)> &write_json);
+
+} } // namespace Slic3r::Benchmark
+
+#endif /* SLIC3R_BENCHMARK_UTILS_HPP */
@@ -0,0 +1,329 @@
+// Slicing throughput benchmarks.
+//
+// Runs the FFF and the SLA pipelines with the default configurations over the models of tests/data
+// and a few large synthetic meshes, measures the wall clock time of each PrintObjectStep, PrintStep,
+// SLAPrintObjectStep and SLAPrintStep separately and writes the results as JSON.
+// The "Slicer" technology only slices the meshes by TriangleMeshSlicer at 0.05mm layers. Its slices
+// are checked to be identical for all the thread counts.
+// Each model is processed with each of the thread counts requested to evaluate the scaling.
+//
+// Usage:
+//     slic3r_benchmarks [--threads 1,2,4,8] [--repeat N] [--technology FFF|SLA|Slicer] [--filter substring]
+//                       [--data-dir DIR] [--output results.json]
+//
+// The results of two runs, for example before and after taking upstream updates, are to be compared per model,
+// technology, thread count and step.
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/Model.hpp"
+#include "libslic3r/ModelArrange.hpp"
+#include "libslic3r/Print.hpp"
+#include "libslic3r/SLAPrint.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+#include "libslic3r/Utils.hpp"
+#include "libslic3r/Format/SL1.hpp"
+
+#include "benchmark_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/args.hpp>
+#include <boost/nowide/iostream.hpp>
+
+#include <tbb/task_scheduler_init.h>
+
+using namespace Slic3r;
+using namespace Slic3r::Benchmark;
+
+namespace {
+
+struct BenchmarkModel
+{
+    std::string name;
+    Model       model;
+    size_t      facets = 0;
+};
+
+struct StepTime
+{
+    std::string name;
+    double      seconds;
+};
+
+struct BenchmarkResult
+{
+    std::string             technology;
+    std::string             model;
+    size_t                  facets;
+    int                     threads;
+    int                     repeat;
+    // Total wall clock time of the processing and of the export.
+    double                  total;
+    // Durations of the steps of the Print / SLAPrint.
+    std::vector<StepTime>   print_steps;
+    // Durations of the steps of the PrintObjects / SLAPrintObjects summed over the objects.
+    std::vector<StepTime>   object_steps;
+};
+
+const char *print_step_names[]       = { "psSkirt", "psBrim", "psWipeTower", "psGCodeExport" };
+const char *print_object_step_names[] = { "posSlice", "posPerimeters", "posPrepareInfill", "posInfill", "posIroning", "posSupportMaterial" };
+const char *sla_print_step_names[]   = { "slapsMergeSlicesAndEval", "slapsRasterize" };
+const char *sla_print_object_step_names[] = { "slaposHollowing", "slaposDrillHoles", "slaposObjectSlice", "slaposSupportPoints",
+                                              "slaposSupportTree", "slaposPad", "slaposSliceSupports" };
+static_assert(sizeof(print_step_names) / sizeof(print_step_names[0]) == psCount, "Missing PrintStep name");
+static_assert(sizeof(print_object_step_names) / sizeof(print_object_step_names[0]) == posCount, "Missing PrintObjectStep name");
+static_assert(sizeof(sla_print_step_names) / sizeof(sla_print_step_names[0]) == slapsCount, "Missing SLAPrintStep name");
+static_assert(sizeof(sla_print_object_step_names) / sizeof(sla_print_object_step_names[0]) == slaposCount, "Missing SLAPrintObjectStep name");
+
+BenchmarkModel model_from_mesh(const std::string &name, TriangleMesh &&mesh)
+{
+    BenchmarkModel out;
+    out.name = name;
+    mesh.repair();
+    ModelObject *object = out.model.add_object();
+    object->name = name;
+    object->add_volume(std::move(mesh));
+    object->add_instance();
+    return out;
+}
+
+// Large meshes stressing the slicing of many facets, the perimeter and infill generation of many islands and of many layers.
+std::vector<BenchmarkModel> synthetic_models()
+{
+    std::vector<BenchmarkModel> out;
+    out.emplace_back(model_from_mesh("synthetic_sphere_r40_fa0.5", make_sphere(40., 2. * PI / 720.)));
+    {
+        TriangleMesh grid;
+        for (int i = 0; i < 10; ++ i)
+            for (int j = 0; j < 10; ++ j) {
+                TriangleMesh cube = make_cube(8., 8., 20.);
+                cube.translate(float(10 * i), float(10 * j), 0.f);
+                grid.merge(cube);
+            }
+        out.emplace_back(model_from_mesh("synthetic_cube_grid_10x10", std::move(grid)));
+    }
+    out.emplace_back(model_from_mesh("synthetic_cylinder_r15_h150", make_cylinder(15., 150., 2. * PI / 1440.)));
+    return out;
+}
+
+std::vector<BenchmarkModel> load_models(const std::string &data_dir, const std::string &filter)
+{
+    std::vector<BenchmarkModel> out;
+    for (const boost::filesystem::path &path : model_paths(data_dir, filter)) {
+        BenchmarkModel model;
+        model.name  = path.stem().string();
+        model.model = Model::read_from_file(path.string());
+        out.emplace_back(std::move(model));
+    }
+    for (BenchmarkModel &model : synthetic_models())
+        if (filter.empty() || model.name.find(filter) != std::string::npos)
+            out.emplace_back(std::move(model));
+    for (BenchmarkModel &model : out)
+        for (const ModelObject *object : model.model.objects)
+            for (const ModelVolume *volume : object->volumes)
+                model.facets += volume->mesh().facets_count();
+    return out;
+}
+
+void arrange(Model &model, const DynamicPrintConfig &config)
+{
+    ArrangeParams params;
+    params.min_obj_distance = scaled(min_object_distance(config));
+    arrange_objects(model, InfiniteBed{ BoundingBox(get_bed_shape(config)).center() }, params);
+    for (ModelObject *object : model.objects)
+        object->ensure_on_bed();
+}
+
+BenchmarkResult run_fff(const BenchmarkModel &benchmark_model, const boost::filesystem::path &tmp_dir)
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    Model model = benchmark_model.model;
+    Print print;
+    arrange(model, config);
+    for (ModelObject *object : model.objects)
+        print.auto_assign_extruders(object);
+    print.apply(model, config);
+    std::string err = print.validate();
+    if (! err.empty())
+        throw std::runtime_error(err);
+    print.set_status_silent();
+
+    BenchmarkResult result;
+    result.technology = "FFF";
+    auto start = std::chrono::steady_clock::now();
+    print.process();
+    // GCode::do_export() runs as the psGCodeExport step, thus its duration is reported by the Print as the other steps.
+    print.export_gcode((tmp_dir / (benchmark_model.name + ".gcode")).string(), nullptr, nullptr);
+    result.total = seconds_since<std::chrono::steady_clock>(start);
+    for (int step = 0; step < int(psCount); ++ step)
+        result.print_steps.push_back({ print_step_names[step], print.step_duration(PrintStep(step)) });
+    for (int step = 0; step < int(posCount); ++ step) {
+        double seconds = 0.;
+        for (const PrintObject *object : print.objects())
+            seconds += object->step_duration(PrintObjectStep(step));
+        result.object_steps.push_back({ print_object_step_names[step], seconds });
+    }
+    return result;
+}
+
+BenchmarkResult run_sla(const BenchmarkModel &benchmark_model)
+{
+    // The default SLA configuration as set up by the command line slicer.
+    SLAFullPrintConfig sla_config;
+    sla_config.printer_technology.value = ptSLA;
+    double w = sla_config.display_width.getFloat();
+    double h = sla_config.display_height.getFloat();
+    sla_config.bed_shape.values = { Vec2d(0, 0), Vec2d(w, 0), Vec2d(w, h), Vec2d(0, h) };
+    DynamicPrintConfig config;
+    config.apply(sla_config, true);
+
+    Model model = benchmark_model.model;
+    SLAPrint   print;
+    SL1Archive archive(print.printer_config());
+    print.set_printer(&archive);
+    arrange(model, config);
+    print.apply(model, config);
+    std::string err = print.validate();
+    if (! err.empty())
+        throw std::runtime_error(err);
+    print.set_status_silent();
+
+    BenchmarkResult result;
+    result.technology = "SLA";
+    auto start = std::chrono::steady_clock::now();
+    print.process();
+    result.total = seconds_since<std::chrono::steady_clock>(start);
+    for (int step = 0; step < int(slapsCount); ++ step)
+        result.print_steps.push_back({ sla_print_step_names[step], print.step_duration(SLAPrintStep(step)) });
+    for (int step = 0; step < int(slaposCount); ++ step) {
+        double seconds = 0.;
+        for (const SLAPrintObject *object : print.objects())
+            seconds += object->step_duration(SLAPrintObjectStep(step));
+        result.object_steps.push_back({ sla_print_object_step_names[step], seconds });
+    }
+    return result;
+}
+
+// Slices the meshes of the model by TriangleMeshSlicer at 0.05mm layers, returns the slices in layers.
+BenchmarkResult run_slicer(const BenchmarkModel &benchmark_model, std::vector<Polygons> &layers)
+{
+    TriangleMesh mesh = benchmark_model.model.mesh();
+    mesh.require_shared_vertices();
+    BoundingBoxf3 bbox = mesh.bounding_box();
+    std::vector<float> z;
+    for (double h = bbox.min.z() + 0.025; h < bbox.max.z(); h += 0.05)
+        z.emplace_back(float(h));
+
+    BenchmarkResult result;
+    result.technology = "Slicer";
+    auto start = std::chrono::steady_clock::now();
+    TriangleMeshSlicer slicer(&mesh);
+    slicer.slice(z, SlicingMode::Regular, &layers, [](){});
+    result.total = seconds_since<std::chrono::steady_clock>(start);
+    return result;
+}
+
+void write_steps_json(std::ostream &out, const std::vector<StepTime> &steps)
+{
+    out << "{";
+    for (size_t i = 0; i < steps.size(); ++ i)
+        out << (i == 0 ? " " : ", ") << "\"" << steps[i].name << "\": " << steps[i].seconds;
+    out << " }";
+}
+
+void write_results_json(std::ostream &out, const std::vector<BenchmarkResult> &results)
+{
+    out.precision(6);
+    out << "{\n"
+        << "  \"version\": \"" << SLIC3R_VERSION << "\",\n"
+        << "  \"hardware_threads\": " << tbb::task_scheduler_init::default_num_threads() << ",\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++ i) {
+        const BenchmarkResult &result = results[i];
+        out << "    { \"technology\": \"" << result.technology << "\", \"model\": \"" << json_escape(result.model) << "\""
+            << ", \"facets\": " << result.facets << ", \"threads\": " << result.threads << ", \"repeat\": " << result.repeat
+            << ", \"total\": " << result.total << ",\n"
+            << "      \"print_steps\": ";
+        write_steps_json(out, result.print_steps);
+        out << ",\n      \"object_steps\": ";
+        write_steps_json(out, result.object_steps);
+        out << " }" << (i + 1 == results.size() ? "\n" : ",\n");
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    boost::nowide::args args(argc, argv);
+
+    Options options;
+    if (! parse_options(argc, argv, { "threads", "repeat", "technology", "filter", "data-dir", "output" }, options))
+        return 1;
+    std::vector<int> &threads = options.threads;
+    if (threads.empty()) {
+        // Single threaded and all the hardware threads by default.
+        threads.emplace_back(1);
+        if (tbb::task_scheduler_init::default_num_threads() > 1)
+            threads.emplace_back(tbb::task_scheduler_init::default_num_threads());
+    }
+
+    // Only report errors of the slicing core.
+    set_logging_level(1);
+
+    std::vector<BenchmarkModel>  models = load_models(options.data_dir, options.filter);
+    std::vector<BenchmarkResult> results;
+    boost::filesystem::path      tmp_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("slic3r_benchmarks-%%%%-%%%%");
+    boost::filesystem::create_directories(tmp_dir);
+    int                          num_failed = 0;
+    // Slices of the models by the first thread count, the other thread counts shall produce the same slices.
+    std::map<std::string, std::vector<Polygons>> reference_slices;
+    for (int num_threads : threads) {
+        tbb::task_scheduler_init scheduler(num_threads);
+        for (const BenchmarkModel &model : models)
+            for (const char *tech : { "FFF", "SLA", "Slicer" }) {
+                if (! options.technology.empty() && ! boost::iequals(options.technology, tech))
+                    continue;
+                for (int iteration = 0; iteration < options.repeat; ++ iteration) {
+                    try {
+                        BenchmarkResult result;
+                        if (strcmp(tech, "Slicer") == 0) {
+                            std::vector<Polygons> layers;
+                            result = run_slicer(model, layers);
+                            auto it_reference = reference_slices.find(model.name);
+                            if (it_reference == reference_slices.end())
+                                reference_slices.emplace(model.name, std::move(layers));
+                            else if (layers != it_reference->second)
+                                throw std::runtime_error("The slices differ from the slices of the first thread count");
+                        } else
+                            result = strcmp(tech, "FFF") == 0 ? run_fff(model, tmp_dir) : run_sla(model);
+                        result.model   = model.name;
+                        result.facets  = model.facets;
+                        result.threads = num_threads;
+                        result.repeat  = iteration;
+                        fprintf(stderr, "%s %-40s threads: %2d, repeat: %d, total: %8.3f s\n", tech, model.name.c_str(), num_threads, iteration, result.total);
+                        results.emplace_back(std::move(result));
+                    } catch (const std::exception &ex) {
+                        boost::nowide::cerr << tech << " " << model.name << " failed: " << ex.what() << std::endl;
+                        ++ num_failed;
+                        break;
+                    }
+                }
+            }
+    }
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(tmp_dir, ec);
+
+    if (! write_results(options.output, [&results](std::ostream &out) { write_results_json(out, results); }))
+        return 1;
+    return num_failed == 0 ? 0 : 1;
+}
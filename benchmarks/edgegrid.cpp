@@ -0,0 +1,194 @@
+// EdgeGrid micro benchmarks.
+//
+// Slices the models of tests/data, rasterizes the slices into EdgeGrid::Grid with the resolutions used by the seam placement
+// and by the support generator, calculates their signed distance fields and queries the distances around the contours.
+// The wall clock time of EdgeGrid::Grid::create(), calculate_sdf(), signed_distance(), signed_distance_bilinear()
+// and closest_point() is measured separately and written as JSON together with a checksum of the calculated distances,
+// so that two builds may be compared both for the speed and for the results.
+//
+// Usage:
+//     slic3r_benchmark_edgegrid [--repeat N] [--filter substring] [--data-dir DIR] [--output results.json]
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/EdgeGrid.hpp"
+#include "libslic3r/Utils.hpp"
+
+#include "benchmark_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/nowide/args.hpp>
+
+using namespace Slic3r;
+using namespace Slic3r::Benchmark;
+
+namespace {
+
+struct BenchmarkSlices
+{
+    std::string                 name;
+    std::vector<ExPolygons>     layers;
+    size_t                      points = 0;
+};
+
+struct BenchmarkResult
+{
+    std::string model;
+    double      resolution;
+    int         repeat;
+    size_t      layers;
+    size_t      points;
+    size_t      cells;
+    size_t      queries;
+    double      create;
+    double      calculate_sdf;
+    double      signed_distance;
+    double      signed_distance_bilinear;
+    double      closest_point;
+    // Sum of the distances calculated by the queries to compare the results of two builds.
+    double      checksum;
+};
+
+// Layer height of the slices, the seam placement and the supports work with the slices of all layers.
+const double layer_height = 0.2;
+
+std::vector<BenchmarkSlices> load_slices(const std::string &data_dir, const std::string &filter)
+{
+    std::vector<BenchmarkSlices> out;
+    for (const boost::filesystem::path &path : model_paths(data_dir, filter)) {
+        BenchmarkSlices slices;
+        slices.name   = path.stem().string();
+        slices.layers = slice_model(path, layer_height);
+        for (const ExPolygons &layer : slices.layers)
+            for (const ExPolygon &expoly : layer)
+                slices.points += expoly.contour.points.size() + std::accumulate(expoly.holes.begin(), expoly.holes.end(), size_t(0),
+                    [](size_t n, const Polygon &hole) { return n + hole.points.size(); });
+        out.emplace_back(std::move(slices));
+    }
+    return out;
+}
+
+// Query points around the contours: points close to the contour points, points offset from the midpoints of the contour edges
+// by a fraction of the grid resolution and points further away, where signed_distance() falls back to the distance field.
+Points query_points(const ExPolygons &layer, coord_t resolution)
+{
+    Points out;
+    auto add_polygon = [&out, resolution](const Polygon &polygon) {
+        for (size_t i = 0; i < polygon.points.size(); ++ i) {
+            const Point &p1 = polygon.points[i];
+            const Point &p2 = polygon.points[i + 1 == polygon.points.size() ? 0 : i + 1];
+            out.emplace_back(p1 + Point(resolution / 11, resolution / 7));
+            out.emplace_back((p1 + p2) / 2 + Point(resolution / 3, - resolution / 5));
+            out.emplace_back((p1 + p2) / 2 + Point(- 3 * resolution, 2 * resolution));
+        }
+    };
+    for (const ExPolygon &expoly : layer) {
+        add_polygon(expoly.contour);
+        for (const Polygon &hole : expoly.holes)
+            add_polygon(hole);
+    }
+    return out;
+}
+
+BenchmarkResult run(const BenchmarkSlices &slices, double resolution)
+{
+    BenchmarkResult result {};
+    result.model      = slices.name;
+    result.resolution = resolution;
+    result.layers     = slices.layers.size();
+    result.points     = slices.points;
+    const coord_t  scaled_resolution = coord_t(scale_(resolution) + 0.5);
+    // Search radius of the seam placement for a 0.4mm nozzle.
+    const coord_t  search_radius     = coord_t(scale_(0.32) + 0.5);
+    for (const ExPolygons &layer : slices.layers) {
+        if (layer.empty())
+            continue;
+        EdgeGrid::Grid grid;
+        auto start = std::chrono::steady_clock::now();
+        grid.create(layer, scaled_resolution);
+        result.create += seconds_since<std::chrono::steady_clock>(start);
+        start = std::chrono::steady_clock::now();
+        grid.calculate_sdf();
+        result.calculate_sdf += seconds_since<std::chrono::steady_clock>(start);
+        result.cells += grid.rows() * grid.cols();
+
+        Points points = query_points(layer, scaled_resolution);
+        result.queries += points.size();
+        start = std::chrono::steady_clock::now();
+        for (const Point &pt : points) {
+            coordf_t dist;
+            if (grid.signed_distance(pt, search_radius, dist))
+                result.checksum += dist;
+        }
+        result.signed_distance += seconds_since<std::chrono::steady_clock>(start);
+        start = std::chrono::steady_clock::now();
+        for (const Point &pt : points)
+            result.checksum += grid.signed_distance_bilinear(pt);
+        result.signed_distance_bilinear += seconds_since<std::chrono::steady_clock>(start);
+        start = std::chrono::steady_clock::now();
+        for (const Point &pt : points) {
+            EdgeGrid::Grid::ClosestPointResult closest = grid.closest_point(pt, scaled_resolution);
+            if (closest.valid())
+                result.checksum += closest.distance + closest.t;
+        }
+        result.closest_point += seconds_since<std::chrono::steady_clock>(start);
+    }
+    return result;
+}
+
+void write_results_json(std::ostream &out, const std::vector<BenchmarkResult> &results)
+{
+    out.precision(6);
+    out << "{\n"
+        << "  \"version\": \"" << SLIC3R_VERSION << "\",\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++ i) {
+        const BenchmarkResult &result = results[i];
+        out << "    { \"model\": \"" << result.model << "\", \"resolution\": " << result.resolution << ", \"repeat\": " << result.repeat
+            << ", \"layers\": " << result.layers << ", \"points\": " << result.points << ", \"cells\": " << result.cells
+            << ", \"queries\": " << result.queries << ",\n"
+            << "      \"create\": " << result.create << ", \"calculate_sdf\": " << result.calculate_sdf
+            << ", \"signed_distance\": " << result.signed_distance << ", \"signed_distance_bilinear\": " << result.signed_distance_bilinear
+            << ", \"closest_point\": " << result.closest_point;
+        out.precision(17);
+        out << ", \"checksum\": " << result.checksum << " }" << (i + 1 == results.size() ? "\n" : ",\n");
+        out.precision(6);
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    boost::nowide::args args(argc, argv);
+
+    Options options;
+    if (! parse_options(argc, argv, { "repeat", "filter", "data-dir", "output" }, options))
+        return 1;
+
+    // Only report errors of the slicing core.
+    set_logging_level(1);
+
+    std::vector<BenchmarkResult> results;
+    // The resolution of the seam placement distance field and a resolution of the support generator grid.
+    for (const BenchmarkSlices &slices : load_slices(options.data_dir, options.filter))
+        for (double resolution : { 1., 0.25 })
+            for (int iteration = 0; iteration < options.repeat; ++ iteration) {
+                BenchmarkResult result = run(slices, resolution);
+                result.repeat = iteration;
+                fprintf(stderr, "%-40s resolution: %4.2f, repeat: %d, create: %8.4f s, sdf: %8.4f s, queries: %8.4f s\n", result.model.c_str(), resolution, iteration,
+                    result.create, result.calculate_sdf, result.signed_distance + result.signed_distance_bilinear + result.closest_point);
+                results.emplace_back(std::move(result));
+            }
+
+    if (! write_results(options.output, [&results](std::ostream &out) { write_results_json(out, results); }))
+        return 1;
+    return 0;
+}
@@ -0,0 +1,232 @@
+// Benchmark of ordering the extrusions by an approximate shortest path.
+//
+// Slices the models of tests/data, clips a sparse rectilinear hatching by the slices to obtain the infill lines of each layer
+// and orders them by chain_polylines() and chain_extrusion_entities() with each ChainingMode. Synthetic sets of up to 10k random
+// segments are ordered as well to cover inputs large enough for the grid hash of ChainingMode::Fast. The wall clock time and the
+// total length of the travel moves between the ordered lines are written as JSON, so that the modes and two builds may be compared
+// both for the speed and for the quality of the chaining.
+//
+// Usage:
+//     slic3r_benchmark_shortest_path [--repeat N] [--filter substring] [--data-dir DIR] [--output results.json]
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/BoundingBox.hpp"
+#include "libslic3r/ClipperUtils.hpp"
+#include "libslic3r/ExtrusionEntity.hpp"
+#include "libslic3r/ShortestPath.hpp"
+#include "libslic3r/Utils.hpp"
+
+#include "benchmark_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/nowide/args.hpp>
+
+using namespace Slic3r;
+using namespace Slic3r::Benchmark;
+
+namespace {
+
+struct BenchmarkInput
+{
+    std::string                 name;
+    // Unordered lines to be chained, one set per layer.
+    std::vector<Polylines>      layers;
+    size_t                      polylines = 0;
+};
+
+struct BenchmarkResult
+{
+    std::string model;
+    std::string mode;
+    int         repeat;
+    size_t      layers;
+    size_t      polylines;
+    double      chain_polylines;
+    double      chain_extrusion_entities;
+    // Total length of the travel moves between the chained lines in millimeters.
+    double      travel_polylines;
+    double      travel_extrusion_entities;
+    // chain_polylines() was not run, see max_default_chain_polylines.
+    bool        chain_polylines_skipped;
+};
+
+// Layer height of the slices and spacing of the hatching, roughly a 20% sparse infill with a 0.45mm extrusion width.
+const double layer_height  = 0.2;
+const double hatch_spacing = 2.25;
+// The two exchanges of chain_polylines() in ChainingMode::Default take time cubic in the number of polylines of a layer,
+// chaining a larger layer would take hours, thus it is only chained by chain_extrusion_entities() in ChainingMode::Default.
+const size_t max_default_chain_polylines = 2000;
+
+// Lines of a hatching rotated by 45 degrees each layer, clipped by the slices of a layer.
+Polylines hatch_layer(const ExPolygons &layer, size_t layer_id)
+{
+    BoundingBox bbox = get_extents(layer);
+    bbox.offset(scale_(hatch_spacing));
+    const double angle   = (layer_id & 1) ? 0.25 * PI : - 0.25 * PI;
+    const Point  center  = bbox.center();
+    const coord_t radius = coord_t((bbox.max - bbox.min).cast<double>().norm() * 0.5);
+    const coord_t step   = coord_t(scale_(hatch_spacing));
+    Polylines hatching;
+    for (coord_t x = - radius; x <= radius; x += step) {
+        Polyline line { Point(x, - radius), Point(x, radius) };
+        line.rotate(angle);
+        line.translate(center.x(), center.y());
+        hatching.emplace_back(std::move(line));
+    }
+    return intersection_pl(hatching, to_polygons(layer));
+}
+
+std::vector<BenchmarkInput> load_inputs(const std::string &data_dir, const std::string &filter)
+{
+    std::vector<BenchmarkInput> out;
+    for (const boost::filesystem::path &path : model_paths(data_dir, filter)) {
+        std::vector<ExPolygons> slices = slice_model(path, layer_height);
+        BenchmarkInput input;
+        input.name = path.stem().string();
+        for (size_t layer_id = 0; layer_id < slices.size(); ++ layer_id) {
+            Polylines lines = hatch_layer(slices[layer_id], layer_id);
+            if (! lines.empty()) {
+                input.polylines += lines.size();
+                input.layers.emplace_back(std::move(lines));
+            }
+        }
+        out.emplace_back(std::move(input));
+    }
+    // Random short segments over a 200x200mm bed, a single large set per "layer".
+    for (size_t num_segments : { 300, 1000, 10000 }) {
+        BenchmarkInput input;
+        input.name = "random_" + std::to_string(num_segments);
+        if (! filter.empty() && input.name.find(filter) == std::string::npos)
+            continue;
+        std::mt19937 rng(num_segments);
+        std::uniform_int_distribution<coord_t> coordinate(0, coord_t(scale_(200.)));
+        std::uniform_int_distribution<coord_t> offset(- coord_t(scale_(5.)), coord_t(scale_(5.)));
+        Polylines lines;
+        for (size_t i = 0; i < num_segments; ++ i) {
+            Point pt(coordinate(rng), coordinate(rng));
+            lines.push_back(Polyline(pt, pt + Point(offset(rng), offset(rng))));
+        }
+        input.polylines = lines.size();
+        input.layers.emplace_back(std::move(lines));
+        out.emplace_back(std::move(input));
+    }
+    return out;
+}
+
+template<typename FirstPointFn, typename LastPointFn>
+double travel_length(size_t num_items, FirstPointFn first_point, LastPointFn last_point)
+{
+    double length = 0.;
+    for (size_t i = 1; i < num_items; ++ i)
+        length += (first_point(i) - last_point(i - 1)).template cast<double>().norm();
+    return unscale<double>(length);
+}
+
+const char* mode_name(ChainingMode mode)
+{
+    return mode == ChainingMode::Fast ? "fast" : "default";
+}
+
+BenchmarkResult run(const BenchmarkInput &input, ChainingMode mode)
+{
+    BenchmarkResult result {};
+    result.model     = input.name;
+    result.mode      = mode_name(mode);
+    result.layers    = input.layers.size();
+    result.polylines = input.polylines;
+    for (const Polylines &layer : input.layers) {
+        if (mode == ChainingMode::Default && layer.size() > max_default_chain_polylines)
+            result.chain_polylines_skipped = true;
+        else {
+            auto start = std::chrono::steady_clock::now();
+            Polylines chained = chain_polylines(layer, nullptr, mode);
+            result.chain_polylines += seconds_since<std::chrono::steady_clock>(start);
+            result.travel_polylines += travel_length(chained.size(),
+                [&chained](size_t i) { return chained[i].first_point(); }, [&chained](size_t i) { return chained[i].last_point(); });
+        }
+
+        // Chain the lines as extrusions starting near the origin, as the G-code generator does for the infill of an island.
+        ExtrusionEntitiesPtr entities;
+        entities.reserve(layer.size());
+        for (const Polyline &polyline : layer) {
+            ExtrusionPath *path = new ExtrusionPath(erInternalInfill);
+            path->polyline = polyline;
+            entities.emplace_back(path);
+        }
+        Point start_near(0, 0);
+        auto start = std::chrono::steady_clock::now();
+        chain_and_reorder_extrusion_entities(entities, &start_near, mode);
+        result.chain_extrusion_entities += seconds_since<std::chrono::steady_clock>(start);
+        result.travel_extrusion_entities += travel_length(entities.size(),
+            [&entities](size_t i) { return entities[i]->first_point(); }, [&entities](size_t i) { return entities[i]->last_point(); });
+        for (ExtrusionEntity *entity : entities)
+            delete entity;
+    }
+    return result;
+}
+
+void write_results_json(std::ostream &out, const std::vector<BenchmarkResult> &results)
+{
+    out.precision(6);
+    out << "{\n"
+        << "  \"version\": \"" << SLIC3R_VERSION << "\",\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++ i) {
+        const BenchmarkResult &result = results[i];
+        out << "    { \"model\": \"" << result.model << "\", \"mode\": \"" << result.mode << "\", \"repeat\": " << result.repeat
+            << ", \"layers\": " << result.layers << ", \"polylines\": " << result.polylines << ",\n"
+            << "      \"chain_polylines\": ";
+        if (result.chain_polylines_skipped)
+            out << "null";
+        else
+            out << result.chain_polylines;
+        out << ", \"chain_extrusion_entities\": " << result.chain_extrusion_entities;
+        out.precision(12);
+        out << ", \"travel_polylines\": ";
+        if (result.chain_polylines_skipped)
+            out << "null";
+        else
+            out << result.travel_polylines;
+        out << ", \"travel_extrusion_entities\": " << result.travel_extrusion_entities
+            << " }" << (i + 1 == results.size() ? "\n" : ",\n");
+        out.precision(6);
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    boost::nowide::args args(argc, argv);
+
+    Options options;
+    if (! parse_options(argc, argv, { "repeat", "filter", "data-dir", "output" }, options))
+        return 1;
+
+    // Only report errors of the slicing core.
+    set_logging_level(1);
+
+    std::vector<BenchmarkResult> results;
+    for (const BenchmarkInput &input : load_inputs(options.data_dir, options.filter))
+        for (ChainingMode mode : { ChainingMode::Default, ChainingMode::Fast })
+            for (int iteration = 0; iteration < options.repeat; ++ iteration) {
+                BenchmarkResult result = run(input, mode);
+                result.repeat = iteration;
+                fprintf(stderr, "%-40s %-7s repeat: %d, chain_polylines: %8.4f s, travel: %10.1f mm, chain_extrusion_entities: %8.4f s, travel: %10.1f mm\n",
+                    result.model.c_str(), result.mode.c_str(), iteration,
+                    result.chain_polylines, result.travel_polylines, result.chain_extrusion_entities, result.travel_extrusion_entities);
+                results.emplace_back(std::move(result));
+            }
+
+    if (! write_results(options.output, [&results](std::ostream &out) { write_results_json(out, results); }))
+        return 1;
+    return 0;
+}
@@ -25,6 +25,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/nowide/args.hpp>
 #include <boost/nowide/cenv.hpp>
+#include <boost/nowide/fstream.hpp>
 #include <boost/nowide/iostream.hpp>
 #include <boost/nowide/integration/filesystem.hpp>
 
@@ -33,10 +34,12 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Config.hpp"
 #include "libslic3r/Geometry.hpp"
+#include "libslic3r/Layer.hpp"
 #include "libslic3r/Model.hpp"
 #include "libslic3r/ModelArrange.hpp"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/SLAPrint.hpp"
+#include "libslic3r/Trace.hpp"
 #include "libslic3r/TriangleMesh.hpp"
 #include "libslic3r/Format/AMF.hpp"
 #include "libslic3r/Format/3mf.hpp"
@@ -59,6 +62,44 @@
 
 using namespace Slic3r;
 
+static void write_memory_usage_json(std::ostream &out, const LayerMemoryUsage &usage)
+{
+    out << "{ \"layers\": " << usage.layers
+        << ", \"slices\": " << usage.slices
+        << ", \"fill_expolygons\": " << usage.fill_expolygons
+        << ", \"fill_surfaces\": " << usage.fill_surfaces
+        << ", \"bridges\": " << usage.bridges
+        << ", \"perimeters\": " << usage.perimeters
+        << ", \"fills\": " << usage.fills
+        << ", \"lslices\": " << usage.lslices
+        << ", \"support\": " << usage.support
+        << ", \"total\": " << usage.total() << " }";
+}
+
+// Write the memory held by the layers of the sliced print in bytes as JSON, broken down by print object and data structure.
+static bool export_memory_report(const Print &print, const std::string &path)
+{
+    boost::nowide::ofstream out(path);
+    if (! out)
+        return false;
+    out << "{\n  \"objects\": [";
+    for (size_t idx = 0; idx < print.objects().size(); ++ idx) {
+        const PrintObject *object = print.objects()[idx];
+        out << (idx == 0 ? "\n" : ",\n")
+            << "    { \"name\": \"" << json_escape(object->model_object()->name) << "\""
+            << ", \"layers\": " << object->layer_count()
+            << ", \"support_layers\": " << object->support_layer_count()
+            << ", \"memory\": ";
+        write_memory_usage_json(out, object->memory_usage());
+        out << " }";
+    }
+    out << "\n  ],\n  \"total\": ";
+    write_memory_usage_json(out, print.memory_usage());
+    out << "\n}\n";
+    out.close();
+    return ! out.fail();
+}
+
 int CLI::run(int argc, char **argv)
 {
 #ifdef __WXGTK__
@@ -91,6 +132,20 @@ int CLI::run(int argc, char **argv)
 	if (! this->setup(argc, argv))
 		return 1;
 
+    // Trace the slicing process into the file given by the --trace option or by the SLIC3R_TRACE environment variable.
+    // The trace is written when leaving this function.
+    std::string trace_file = m_config.opt_string("trace");
+    if (trace_file.empty() && boost::nowide::getenv("SLIC3R_TRACE") != nullptr)
+        trace_file = boost::nowide::getenv("SLIC3R_TRACE");
+    ScopeGuard  trace_guard;
+    if (! trace_file.empty()) {
+        Trace::start();
+        trace_guard = ScopeGuard([&trace_file]() {
+            if (! Trace::finish(trace_file))
+                boost::nowide::cerr << "Writing the trace to " << trace_file << " failed" << std::endl;
+        });
+    }
+
     m_extra_config.apply(m_config, true);
     m_extra_config.normalize();
     
@@ -454,6 +509,7 @@ int CLI::run(int argc, char **argv)
                 if (printer_technology == ptFFF) {
                     for (auto* mo : model.objects)
                         fff_print.auto_assign_extruders(mo);
+                    fff_print.set_slice_cache_dir(m_config.opt_string("slice_cache"));
                 }
                 print->apply(model, m_print_config);
                 std::string err = print->validate();
@@ -467,9 +523,18 @@ int CLI::run(int argc, char **argv)
                     try {
                         std::string outfile_final;
                         print->process();
+                        if (printer_technology == ptFFF && ! m_config.opt_string("memory_report").empty()) {
+                            // Report the memory before the export releases the layer data.
+                            const std::string &report = m_config.opt_string("memory_report");
+                            if (! export_memory_report(fff_print, report)) {
+                                boost::nowide::cerr << "Exporting the memory report to " << report << " failed" << std::endl;
+                                return 1;
+                            }
+                        }
                         if (printer_technology == ptFFF) {
                             // The outfile is processed by a PlaceholderParser.
-                            outfile = fff_print.export_gcode(outfile, nullptr);
+                            // The Print is not exported again, the layer extrusions may be released once they are exported.
+                            outfile = fff_print.export_gcode(outfile, nullptr, nullptr, m_config.opt_bool("memory_budget"));
                             outfile_final = fff_print.print_statistics().finalize_output_path(outfile);
                         } else {
                             outfile = sla_print.output_filepath(outfile);
@@ -34,6 +34,11 @@
 #define BOOST_POOL_NO_MT
 #include <boost/pool/object_pool.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
+
 #include "stl.h"
 
 struct HashEdge {
@@ -53,11 +58,16 @@ struct HashEdge {
 
 	void load_exact(stl_file *stl, const stl_vertex *a, const stl_vertex *b)
 	{
-		{
-	    	stl_vertex diff = (*a - *b).cwiseAbs();
-	    	float max_diff = std::max(diff(0), std::max(diff(1), diff(2)));
-	    	stl->stats.shortest_edge = std::min(max_diff, stl->stats.shortest_edge);
-	  	}
+    	float max_diff = load_exact_key(this->key, this->which_edge, a, b);
+    	stl->stats.shortest_edge = std::min(max_diff, stl->stats.shortest_edge);
+	}
+
+	// Fill in the key of an edge from a to b. If the edge is stored backwards, which_edge is increased by 3.
+	// Returns the length of the edge in the maximum norm to update stl_stats::shortest_edge.
+	static float load_exact_key(uint32_t key[6], int &which_edge, const stl_vertex *a, const stl_vertex *b)
+	{
+    	stl_vertex diff = (*a - *b).cwiseAbs();
+    	float max_diff = std::max(diff(0), std::max(diff(1), diff(2)));
 
 	  	// Ensure identical vertex ordering of equal edges.
 	  	// This method is numerically robust.
@@ -65,13 +75,13 @@ struct HashEdge {
 	  	} else {
 	  		// This edge is loaded backwards.
 		    std::swap(a, b);
-		    this->which_edge += 3;
+		    which_edge += 3;
 	  	}
-	  	memcpy(&this->key[0], a->data(), sizeof(stl_vertex));
-	  	memcpy(&this->key[3], b->data(), sizeof(stl_vertex));
+	  	memcpy(&key[0], a->data(), sizeof(stl_vertex));
+	  	memcpy(&key[3], b->data(), sizeof(stl_vertex));
 	  	// Switch negative zeros to positive zeros, so memcmp will consider them to be equal.
 	  	for (size_t i = 0; i < 6; ++ i) {
-	    	unsigned char *p = (unsigned char*)(this->key + i);
+	    	unsigned char *p = (unsigned char*)(key + i);
 	#if BOOST_ENDIAN_LITTLE_BYTE
 	    	if (p[0] == 0 && p[1] == 0 && p[2] == 0 && p[3] == 0x80)
 	      		// Negative zero, switch to positive zero.
@@ -82,6 +92,7 @@ struct HashEdge {
 	      		p[0] = 0;
 	#endif /* BOOST_ENDIAN_LITTLE_BYTE */
 	  	}
+	  	return max_diff;
 	}
 
 	bool load_nearby(const stl_file *stl, const stl_vertex &a, const stl_vertex &b, float tolerance)
@@ -114,12 +125,45 @@ struct HashEdge {
 	}
 
 private:
-	inline bool vertex_lower(const stl_vertex &a, const stl_vertex &b) {
+	static inline bool vertex_lower(const stl_vertex &a, const stl_vertex &b) {
 	  	return (a(0) != b(0)) ? (a(0) < b(0)) :
 	           ((a(1) != b(1)) ? (a(1) < b(1)) : (a(2) < b(2)));
 	}
 };
 
+// Edge of a facet with its exact key, without the hash chain link. stl_check_facets_exact() sorts the edges by their keys.
+struct SortedEdge {
+	uint32_t key[6];
+	int      facet_number;
+	int      which_edge;
+
+	bool same_key(const SortedEdge &rhs) const { return memcmp(key, rhs.key, sizeof(key)) == 0; }
+	// Equal keys are ordered the way the edges used to be inserted into HashTableEdges.
+	bool operator<(const SortedEdge &rhs) const {
+		int cmp = memcmp(key, rhs.key, sizeof(key));
+		return (cmp != 0) ? (cmp < 0) :
+		       (facet_number != rhs.facet_number) ? (facet_number < rhs.facet_number) : (which_edge % 3 < rhs.which_edge % 3);
+	}
+};
+
+// Facet a's neighbor is facet b and vice versa. which_edge_a / which_edge_b are increased by 3 for edges stored backwards.
+static inline void stl_connect_neighbors(stl_file *stl, int facet_a, int which_edge_a, int facet_b, int which_edge_b)
+{
+	// Facet a's neighbor is facet b
+	stl->neighbors_start[facet_a].neighbor[which_edge_a % 3] = facet_b;	/* sets the .neighbor part */
+	stl->neighbors_start[facet_a].which_vertex_not[which_edge_a % 3] = (which_edge_b + 2) % 3; /* sets the .which_vertex_not part */
+
+	// Facet b's neighbor is facet a
+	stl->neighbors_start[facet_b].neighbor[which_edge_b % 3] = facet_a;	/* sets the .neighbor part */
+	stl->neighbors_start[facet_b].which_vertex_not[which_edge_b % 3] = (which_edge_a + 2) % 3; /* sets the .which_vertex_not part */
+
+	if (((which_edge_a < 3) && (which_edge_b < 3)) || ((which_edge_a > 2) && (which_edge_b > 2))) {
+		// These facets are oriented in opposite directions, their normals are probably messed up.
+		stl->neighbors_start[facet_a].which_vertex_not[which_edge_a % 3] += 3;
+		stl->neighbors_start[facet_b].which_vertex_not[which_edge_b % 3] += 3;
+	}
+}
+
 struct HashTableEdges {
 	HashTableEdges(size_t number_of_faces) {
 		this->M = (int)hash_size_from_nr_faces(number_of_faces);
@@ -241,19 +285,7 @@ private:
 
 	static void record_neighbors(stl_file *stl, const HashEdge &edge_a, const HashEdge &edge_b)
 	{
-		// Facet a's neighbor is facet b
-		stl->neighbors_start[edge_a.facet_number].neighbor[edge_a.which_edge % 3] = edge_b.facet_number;	/* sets the .neighbor part */
-		stl->neighbors_start[edge_a.facet_number].which_vertex_not[edge_a.which_edge % 3] = (edge_b.which_edge + 2) % 3; /* sets the .which_vertex_not part */
-
-		// Facet b's neighbor is facet a
-		stl->neighbors_start[edge_b.facet_number].neighbor[edge_b.which_edge % 3] = edge_a.facet_number;	/* sets the .neighbor part */
-		stl->neighbors_start[edge_b.facet_number].which_vertex_not[edge_b.which_edge % 3] = (edge_a.which_edge + 2) % 3; /* sets the .which_vertex_not part */
-
-		if (((edge_a.which_edge < 3) && (edge_b.which_edge < 3)) || ((edge_a.which_edge > 2) && (edge_b.which_edge > 2))) {
-			// These facets are oriented in opposite directions, their normals are probably messed up.
-			stl->neighbors_start[edge_a.facet_number].which_vertex_not[edge_a.which_edge % 3] += 3;
-			stl->neighbors_start[edge_b.facet_number].which_vertex_not[edge_b.which_edge % 3] += 3;
-		}
+		stl_connect_neighbors(stl, edge_a.facet_number, edge_a.which_edge, edge_b.facet_number, edge_b.which_edge);
 
 		// Count successful connects:
 		// Total connects:
@@ -425,10 +457,8 @@ private:
 	}
 };
 
-// This function builds the neighbors list.  No modifications are made
-// to any of the facets.  The edges are said to match only if all six
-// floats of the first edge matches all six floats of the second edge.
-void stl_check_facets_exact(stl_file *stl)
+// Resets the connection statistics and the neighbors list, removes the degenerate facets.
+static void stl_check_facets_exact_prepare(stl_file *stl)
 {
 	assert(stl->facet_start.size() == stl->neighbors_start.size());
 
@@ -453,21 +483,78 @@ void stl_check_facets_exact(stl_file *stl)
 		  	++ i;
   	}
 
-  	// Initialize hash table.
-  	HashTableEdges hash_table(stl->stats.number_of_facets);
 	for (auto &neighbor : stl->neighbors_start)
 		neighbor.reset();
+}
 
-  	// Connect neighbor edges.
-	for (uint32_t i = 0; i < stl->stats.number_of_facets; ++ i) {
-		const stl_facet &facet = stl->facet_start[i];
-		for (int j = 0; j < 3; ++ j) {
-			HashEdge edge;
-			edge.facet_number = i;
-			edge.which_edge = j;
-			edge.load_exact(stl, &facet.vertex[j], &facet.vertex[(j + 1) % 3]);
-			hash_table.insert_edge_exact(stl, edge);
+// This function builds the neighbors list.  No modifications are made
+// to any of the facets.  The edges are said to match only if all six
+// floats of the first edge matches all six floats of the second edge.
+void stl_check_facets_exact(stl_file *stl)
+{
+	stl_check_facets_exact_prepare(stl);
+
+	// Connect neighbor edges. The result is the same as if the edges were inserted one by one into HashTableEdges:
+	// An edge is connected to the first edge with an equal key, which belongs to another facet and which was not connected yet.
+	// Once the edges are sorted by their keys and by the order of insertion, the groups of equal edges are independent
+	// and they are connected in parallel.
+	std::vector<SortedEdge> edges(size_t(stl->stats.number_of_facets) * 3);
+	stl->stats.shortest_edge = tbb::parallel_reduce(tbb::blocked_range<size_t>(0, stl->stats.number_of_facets), stl->stats.shortest_edge,
+		[stl, &edges](const tbb::blocked_range<size_t> &range, float shortest_edge) {
+			for (size_t i = range.begin(); i < range.end(); ++ i) {
+				const stl_facet &facet = stl->facet_start[i];
+				for (int j = 0; j < 3; ++ j) {
+					SortedEdge &edge = edges[i * 3 + j];
+					edge.facet_number = int(i);
+					edge.which_edge   = j;
+					shortest_edge = std::min(shortest_edge, HashEdge::load_exact_key(edge.key, edge.which_edge, &facet.vertex[j], &facet.vertex[(j + 1) % 3]));
+				}
+			}
+			return shortest_edge;
+		},
+		[](float a, float b) { return std::min(a, b); });
+	tbb::parallel_sort(edges.begin(), edges.end());
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, edges.size()), [stl, &edges](const tbb::blocked_range<size_t> &range) {
+		// Process the groups of equal edges starting inside this range, the last group may extend past the end of the range.
+		size_t i = range.begin();
+		while (i > 0 && i < range.end() && edges[i].same_key(edges[i - 1]))
+			++ i;
+		std::vector<const SortedEdge*> unconnected;
+		while (i < range.end()) {
+			size_t j = i + 1;
+			while (j < edges.size() && edges[j].same_key(edges[i]))
+				++ j;
+			if (j == i + 2) {
+				// The most common case of a manifold edge.
+				if (edges[i].facet_number != edges[i + 1].facet_number)
+					stl_connect_neighbors(stl, edges[i + 1].facet_number, edges[i + 1].which_edge, edges[i].facet_number, edges[i].which_edge);
+			} else if (j > i + 2) {
+				unconnected.clear();
+				for (size_t k = i; k < j; ++ k) {
+					const SortedEdge &edge = edges[k];
+					auto it = std::find_if(unconnected.begin(), unconnected.end(), [&edge](const SortedEdge *other) { return other->facet_number != edge.facet_number; });
+					if (it == unconnected.end())
+						unconnected.emplace_back(&edge);
+					else {
+						stl_connect_neighbors(stl, edge.facet_number, edge.which_edge, (*it)->facet_number, (*it)->which_edge);
+						unconnected.erase(it);
+					}
+				}
+			}
+			i = j;
 		}
+	});
+
+	// Count successful connects.
+	for (const stl_neighbors &neighbors : stl->neighbors_start) {
+		int num_neighbors = neighbors.num_neighbors();
+		stl->stats.connected_edges += num_neighbors;
+		if (num_neighbors > 0)
+			++ stl->stats.connected_facets_1_edge;
+		if (num_neighbors > 1)
+			++ stl->stats.connected_facets_2_edge;
+		if (num_neighbors > 2)
+			++ stl->stats.connected_facets_3_edge;
 	}
 
 #if 0
@@ -155,6 +155,8 @@ struct indexed_triangle_set
 };
 
 extern bool stl_open(stl_file *stl, const char *file);
+// Reads the file with stdio, without the memory mapping used by stl_open() for binary files.
+extern bool stl_open_stdio(stl_file *stl, const char *file);
 extern void stl_stats_out(stl_file *stl, FILE *file, char *input_file);
 extern bool stl_print_neighbors(stl_file *stl, char *file);
 extern bool stl_write_ascii(stl_file *stl, const char *file, const char *label);
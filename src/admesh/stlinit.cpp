@@ -29,6 +29,8 @@
 #include <boost/log/trivial.hpp>
 #include <boost/nowide/cstdio.hpp>
 #include <boost/detail/endian.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 #include "stl.h"
 
@@ -230,7 +232,76 @@ static bool stl_read(stl_file *stl, FILE *fp, int first_facet, bool first)
   	return true;
 }
 
+/* Reads a binary STL file through a memory mapping. The facets are copied from the mapped file
+   in a single pass instead of being read one by one with fread().
+   Returns false if the file could not be mapped or if it is not a valid binary STL file,
+   the caller shall fall back to stl_open_stdio(), which reports the errors. */
+static bool stl_open_binary_mapped(stl_file *stl, const char *file)
+{
+	try {
+		// Non-ASCII file names will fail to open on Windows, they are read through boost::nowide::fopen() then.
+		boost::interprocess::file_mapping  mapping(file, boost::interprocess::read_only);
+		boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+		const char *data      = static_cast<const char*>(region.get_address());
+		size_t      file_size = region.get_size();
+		if (file_size < STL_MIN_FILE_SIZE || (file_size - HEADER_SIZE) % SIZEOF_STL_FACET != 0)
+			return false;
+		// Check for binary or ASCII file the same way as stl_open_count_facets().
+		bool is_binary = false;
+		for (size_t s = HEADER_SIZE; s < HEADER_SIZE + 128; ++ s)
+			if ((unsigned char)data[s] > 127) {
+				is_binary = true;
+				break;
+			}
+		if (! is_binary)
+			return false;
+
+		uint32_t num_facets = uint32_t((file_size - HEADER_SIZE) / SIZEOF_STL_FACET);
+		uint32_t header_num_facets;
+		memcpy(&header_num_facets, data + LABEL_SIZE, sizeof(uint32_t));
+#ifndef BOOST_LITTLE_ENDIAN
+		stl_internal_reverse_quads((char*)&header_num_facets, 4);
+#endif /* BOOST_LITTLE_ENDIAN */
+		if (num_facets != header_num_facets)
+			BOOST_LOG_TRIVIAL(info) << "stl_open_binary_mapped: Warning: File size doesn't match number of facets in the header: " << file;
+
+		stl->stats.type = binary;
+		memcpy(stl->stats.header, data, LABEL_SIZE);
+		stl->stats.number_of_facets    = num_facets;
+		stl->stats.original_num_facets = num_facets;
+		stl_allocate(stl);
+
+		const char *src   = data + HEADER_SIZE;
+		bool        first = true;
+		for (stl_facet &facet : stl->facet_start) {
+			// stl_facet is padded, SIZEOF_STL_FACET bytes are stored in the file.
+			memcpy(&facet, src, SIZEOF_STL_FACET);
+			src += SIZEOF_STL_FACET;
+#ifndef BOOST_LITTLE_ENDIAN
+			stl_internal_reverse_quads((char*)&facet, 48);
+#endif /* BOOST_LITTLE_ENDIAN */
+			stl_facet_stats(stl, facet, first);
+		}
+	} catch (const boost::interprocess::interprocess_exception &ex) {
+		BOOST_LOG_TRIVIAL(debug) << "stl_open_binary_mapped: Couldn't map " << file << ": " << ex.what();
+		stl->clear();
+		return false;
+	}
+
+	stl->stats.size = stl->stats.max - stl->stats.min;
+	stl->stats.bounding_diameter = stl->stats.size.norm();
+	return true;
+}
+
 bool stl_open(stl_file *stl, const char *file)
+{
+	stl->clear();
+	if (stl_open_binary_mapped(stl, file))
+		return true;
+	return stl_open_stdio(stl, file);
+}
+
+bool stl_open_stdio(stl_file *stl, const char *file)
 {
 	stl->clear();
 	FILE *fp = stl_open_count_facets(stl, file);
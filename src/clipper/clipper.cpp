@@ -712,73 +712,9 @@ TEdge* ClipperBase::ProcessBound(TEdge* E, bool NextIsForward)
 }
 //------------------------------------------------------------------------------
 
-bool ClipperBase::AddPath(const Path &pg, PolyType PolyTyp, bool Closed)
-{
-  PROFILE_FUNC();
-  // Remove duplicate end point from a closed input path.
-  // Remove duplicate points from the end of the input path.
-  int highI = (int)pg.size() -1;
-  if (Closed) 
-    while (highI > 0 && (pg[highI] == pg[0])) 
-      --highI;
-  while (highI > 0 && (pg[highI] == pg[highI -1])) 
-    --highI;
-  if ((Closed && highI < 2) || (!Closed && highI < 1))
-    return false;
-
-  // Allocate a new edge array.
-  std::vector<TEdge> edges(highI + 1);
-  // Fill in the edge array.
-  bool result = AddPathInternal(pg, highI, PolyTyp, Closed, edges.data());
-  if (result)
-    // Success, remember the edge array.
-    m_edges.emplace_back(std::move(edges));
-  return result;
-}
-
-bool ClipperBase::AddPaths(const Paths &ppg, PolyType PolyTyp, bool Closed)
-{
-  PROFILE_FUNC();
-  std::vector<int> num_edges(ppg.size(), 0);
-  int num_edges_total = 0;
-  for (size_t i = 0; i < ppg.size(); ++ i) {
-    const Path &pg = ppg[i];
-    // Remove duplicate end point from a closed input path.
-    // Remove duplicate points from the end of the input path.
-    int highI = (int)pg.size() -1;
-    if (Closed) 
-      while (highI > 0 && (pg[highI] == pg[0])) 
-        --highI;
-    while (highI > 0 && (pg[highI] == pg[highI -1])) 
-      --highI;
-    if ((Closed && highI < 2) || (!Closed && highI < 1))
-      highI = -1;
-    num_edges[i] = highI + 1;
-    num_edges_total += highI + 1;
-  }
-  if (num_edges_total == 0)
-    return false;
-
-  // Allocate a new edge array.
-  std::vector<TEdge> edges(num_edges_total);
-  // Fill in the edge array.
-  bool result = false;
-  TEdge *p_edge = edges.data();
-  for (Paths::size_type i = 0; i < ppg.size(); ++i)
-    if (num_edges[i]) {
-      bool res = AddPathInternal(ppg[i], num_edges[i] - 1, PolyTyp, Closed, p_edge);
-      if (res) {
-        p_edge += num_edges[i];
-        result = true;
-      }
-    }
-  if (result)
-    // At least some edges were generated. Remember the edge array.
-    m_edges.emplace_back(std::move(edges));
-  return result;
-}
-
-bool ClipperBase::AddPathInternal(const Path &pg, int highI, PolyType PolyTyp, bool Closed, TEdge* edges)
+// Initialize the edges of a single input path, whose vertices were already stored into edges[0..highI].Curr
+// by ClipperBase::AddPathInternal(const PathInput&, ...).
+bool ClipperBase::AddPathInternal(int highI, PolyType PolyTyp, bool Closed, TEdge* edges)
 {
   PROFILE_FUNC();
 #ifdef use_lines
@@ -789,25 +725,14 @@ bool ClipperBase::AddPathInternal(const Path &pg, int highI, PolyType PolyTyp, b
     throw clipperException("AddPath: Open paths have been disabled.");
 #endif
 
-  assert(highI >= 0 && highI < pg.size());
+  assert(highI >= 0);
 
   //1. Basic (first) edge initialization ...
-  try
-  {
-    edges[1].Curr = pg[1];
-    RangeTest(pg[0], m_UseFullRange);
-    RangeTest(pg[highI], m_UseFullRange);
-    InitEdge(&edges[0], &edges[1], &edges[highI], pg[0]);
-    InitEdge(&edges[highI], &edges[0], &edges[highI-1], pg[highI]);
-    for (int i = highI - 1; i >= 1; --i)
-    {
-      RangeTest(pg[i], m_UseFullRange);
-      InitEdge(&edges[i], &edges[i+1], &edges[i-1], pg[i]);
-    }
-  }
-  catch(...)
+  for (int i = 0; i <= highI; ++ i)
   {
-    throw; //range test fails
+    IntPoint pt = edges[i].Curr;
+    RangeTest(pt, m_UseFullRange);
+    InitEdge(&edges[i], &edges[(i == highI) ? 0 : i + 1], &edges[(i == 0) ? highI : i - 1], pt);
   }
   TEdge *eStart = &edges[0];
 
@@ -3333,11 +3258,11 @@ void ClipperOffset::Clear()
 }
 //------------------------------------------------------------------------------
 
-void ClipperOffset::AddPath(const Path& path, JoinType joinType, EndType endType)
+// Called by ClipperOffset::AddPath() with the vertices of a non-empty input path already copied into newNode->Contour.
+void ClipperOffset::AddPathInternal(PolyNode *newNode, JoinType joinType, EndType endType)
 {
-  int highI = (int)path.size() - 1;
-  if (highI < 0) return;
-  PolyNode* newNode = new PolyNode();
+  Path &path  = newNode->Contour;
+  int   highI = (int)path.size() - 1;
   newNode->m_jointype = joinType;
   newNode->m_endtype = endType;
 
@@ -3356,25 +3281,25 @@ void ClipperOffset::AddPath(const Path& path, JoinType joinType, EndType endType
       if (! same)
         break;
     }
-  newNode->Contour.reserve(highI + 1);
-  newNode->Contour.push_back(path[0]);
+  // Compact the path in place, path[0..j] are the vertices kept.
   int j = 0, k = 0;
   for (int i = 1; i <= highI; i++) {
     bool same = false;
     if (has_shortest_edge_length) {
-      double dx = double(path[i].X - newNode->Contour[j].X);
-      double dy = double(path[i].Y - newNode->Contour[j].Y);
+      double dx = double(path[i].X - path[j].X);
+      double dy = double(path[i].Y - path[j].Y);
       same = dx*dx + dy*dy < shortest_edge_length2;
     } else
-      same = newNode->Contour[j] == path[i];
+      same = path[j] == path[i];
     if (same)
       continue;
     j++;
-    newNode->Contour.push_back(path[i]);
-    if (path[i].Y > newNode->Contour[k].Y ||
-      (path[i].Y == newNode->Contour[k].Y &&
-      path[i].X < newNode->Contour[k].X)) k = j;
+    path[j] = path[i];
+    if (path[j].Y > path[k].Y ||
+      (path[j].Y == path[k].Y &&
+      path[j].X < path[k].X)) k = j;
   }
+  path.erase(path.begin() + (j + 1), path.end());
   if (endType == etClosedPolygon && j < 2)
   {
     delete newNode;
@@ -3397,12 +3322,6 @@ void ClipperOffset::AddPath(const Path& path, JoinType joinType, EndType endType
 }
 //------------------------------------------------------------------------------
 
-void ClipperOffset::AddPaths(const Paths& paths, JoinType joinType, EndType endType)
-{
-  for (const Path &path : paths)
-    AddPath(path, joinType, endType);
-}
-//------------------------------------------------------------------------------
 
 void ClipperOffset::FixOrientations()
 {
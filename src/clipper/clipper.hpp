@@ -291,8 +291,13 @@ class ClipperBase
 public:
   ClipperBase() : m_UseFullRange(false), m_HasOpenPaths(false) {}
   ~ClipperBase() { Clear(); }
-  bool AddPath(const Path &pg, PolyType PolyTyp, bool Closed);
-  bool AddPaths(const Paths &ppg, PolyType PolyTyp, bool Closed);
+  // PathInput is a random access container of points convertible to IntPoint, for example Path.
+  // PathsProvider is an iterable container of PathInput, for example Paths.
+  // Foreign polygon types may thus be added through lightweight views without converting them to Paths first.
+  template<typename PathInput = Path>
+  bool AddPath(const PathInput &pg, PolyType PolyTyp, bool Closed);
+  template<typename PathsProvider = Paths>
+  bool AddPaths(const PathsProvider &paths_provider, PolyType PolyTyp, bool Closed);
   void Clear();
   IntRect GetBounds();
   // By default, when three or more vertices are collinear in input polygons (subject or clip), the Clipper object removes the 'inner' vertices before clipping.
@@ -300,7 +305,12 @@ public:
   bool PreserveCollinear() const {return m_PreserveCollinear;};
   void PreserveCollinear(bool value) {m_PreserveCollinear = value;};
 protected:
-  bool AddPathInternal(const Path &pg, int highI, PolyType PolyTyp, bool Closed, TEdge* edges);
+  // Index of the last vertex of an input path after removing the duplicate end points, -1 if the path is degenerate.
+  template<typename PathInput>
+  static int PathLastVertex(const PathInput &pg, bool Closed);
+  template<typename PathInput>
+  bool AddPathInternal(const PathInput &pg, int highI, PolyType PolyTyp, bool Closed, TEdge* edges);
+  bool AddPathInternal(int highI, PolyType PolyTyp, bool Closed, TEdge* edges);
   TEdge* AddBoundsToLML(TEdge *e, bool IsClosed);
   void Reset();
   TEdge* ProcessBound(TEdge* E, bool IsClockwise);
@@ -447,8 +457,12 @@ public:
   ClipperOffset(double miterLimit = 2.0, double roundPrecision = 0.25, double shortestEdgeLength = 0.) :
     MiterLimit(miterLimit), ArcTolerance(roundPrecision), ShortestEdgeLength(shortestEdgeLength), m_lowest(-1, 0) {}
   ~ClipperOffset() { Clear(); }
-  void AddPath(const Path& path, JoinType joinType, EndType endType);
-  void AddPaths(const Paths& paths, JoinType joinType, EndType endType);
+  // See ClipperBase::AddPath() and ClipperBase::AddPaths() for the PathInput and PathsProvider types.
+  template<typename PathInput = Path>
+  void AddPath(const PathInput &path, JoinType joinType, EndType endType);
+  template<typename PathsProvider = Paths>
+  void AddPaths(const PathsProvider &paths_provider, JoinType joinType, EndType endType)
+    { for (const auto &path : paths_provider) AddPath(path, joinType, endType); }
   void Execute(Paths& solution, double delta);
   void Execute(PolyTree& solution, double delta);
   void Clear();
@@ -465,6 +479,7 @@ private:
   IntPoint m_lowest;
   PolyNode m_polyNodes;
 
+  void AddPathInternal(PolyNode *newNode, JoinType joinType, EndType endType);
   void FixOrientations();
   void DoOffset(double delta);
   void OffsetPoint(int j, int& k, JoinType jointype);
@@ -485,6 +500,91 @@ class clipperException : public std::exception
 };
 //------------------------------------------------------------------------------
 
+template<typename PathInput>
+int ClipperBase::PathLastVertex(const PathInput &pg, bool Closed)
+{
+  // Remove duplicate end point from a closed input path.
+  // Remove duplicate points from the end of the input path.
+  int highI = (int)pg.size() -1;
+  if (Closed) 
+    while (highI > 0 && (IntPoint(pg[highI]) == IntPoint(pg[0]))) 
+      --highI;
+  while (highI > 0 && (IntPoint(pg[highI]) == IntPoint(pg[highI -1]))) 
+    --highI;
+  return ((Closed && highI < 2) || (!Closed && highI < 1)) ? -1 : highI;
+}
+
+template<typename PathInput>
+bool ClipperBase::AddPathInternal(const PathInput &pg, int highI, PolyType PolyTyp, bool Closed, TEdge* edges)
+{
+  // Convert the vertices directly into the edges, the rest of the initialization does not depend on PathInput.
+  for (int i = 0; i <= highI; ++ i)
+    edges[i].Curr = pg[i];
+  return AddPathInternal(highI, PolyTyp, Closed, edges);
+}
+
+template<typename PathInput>
+bool ClipperBase::AddPath(const PathInput &pg, PolyType PolyTyp, bool Closed)
+{
+  int highI = PathLastVertex(pg, Closed);
+  if (highI < 0)
+    return false;
+
+  // Allocate a new edge array.
+  std::vector<TEdge> edges(highI + 1);
+  // Fill in the edge array.
+  bool result = AddPathInternal(pg, highI, PolyTyp, Closed, edges.data());
+  if (result)
+    // Success, remember the edge array.
+    m_edges.emplace_back(std::move(edges));
+  return result;
+}
+
+template<typename PathsProvider>
+bool ClipperBase::AddPaths(const PathsProvider &paths_provider, PolyType PolyTyp, bool Closed)
+{
+  std::vector<int> num_edges;
+  int num_edges_total = 0;
+  for (const auto &pg : paths_provider) {
+    int highI = PathLastVertex(pg, Closed);
+    num_edges.emplace_back(highI + 1);
+    num_edges_total += highI + 1;
+  }
+  if (num_edges_total == 0)
+    return false;
+
+  // Allocate a new edge array.
+  std::vector<TEdge> edges(num_edges_total);
+  // Fill in the edge array.
+  bool result = false;
+  TEdge *p_edge = edges.data();
+  auto it_num_edges = num_edges.begin();
+  for (const auto &pg : paths_provider) {
+    int n = *it_num_edges ++;
+    if (n && AddPathInternal(pg, n - 1, PolyTyp, Closed, p_edge)) {
+      p_edge += n;
+      result = true;
+    }
+  }
+  if (result)
+    // At least some edges were generated. Remember the edge array.
+    m_edges.emplace_back(std::move(edges));
+  return result;
+}
+
+template<typename PathInput>
+void ClipperOffset::AddPath(const PathInput &path, JoinType joinType, EndType endType)
+{
+  if (path.size() == 0)
+    return;
+  PolyNode* newNode = new PolyNode();
+  newNode->Contour.reserve(path.size());
+  for (size_t i = 0; i < path.size(); ++ i)
+    newNode->Contour.emplace_back(path[i]);
+  AddPathInternal(newNode, joinType, endType);
+}
+//------------------------------------------------------------------------------
+
 } //ClipperLib namespace
 
 #endif //clipper_hpp
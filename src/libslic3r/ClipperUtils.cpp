@@ -8,6 +8,10 @@
 #include "SVG.hpp"
 #endif /* CLIPPER_UTILS_DEBUG */
 
+#include <array>
+
+#include <tbb/parallel_for.h>
+
 #include <Shiny/Shiny.h>
 
 #define CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR (0.005f)
@@ -48,15 +52,6 @@ err:
 }
 #endif /* CLIPPER_UTILS_DEBUG */
 
-void scaleClipperPolygon(ClipperLib::Path &polygon)
-{
-    PROFILE_FUNC();
-    for (ClipperLib::Path::iterator pit = polygon.begin(); pit != polygon.end(); ++pit) {
-        pit->X <<= CLIPPER_OFFSET_POWER_OF_2;
-        pit->Y <<= CLIPPER_OFFSET_POWER_OF_2;
-    }
-}
-
 void scaleClipperPolygons(ClipperLib::Paths &polygons)
 {
     PROFILE_FUNC();
@@ -173,15 +168,6 @@ ClipperLib::Path Slic3rMultiPoint_to_ClipperPath(const MultiPoint &input)
     return retval;
 }
 
-ClipperLib::Path Slic3rMultiPoint_to_ClipperPath_reversed(const Slic3r::MultiPoint &input)
-{
-    ClipperLib::Path output;
-    output.reserve(input.points.size());
-    for (Slic3r::Points::const_reverse_iterator pit = input.points.rbegin(); pit != input.points.rend(); ++pit)
-        output.emplace_back((*pit)(0), (*pit)(1));
-    return output;
-}
-
 ClipperLib::Paths Slic3rMultiPoints_to_ClipperPaths(const Polygons &input)
 {
     ClipperLib::Paths retval;
@@ -211,11 +197,10 @@ ClipperLib::Paths Slic3rMultiPoints_to_ClipperPaths(const Polylines &input)
     return retval;
 }
 
-ClipperLib::Paths _offset(ClipperLib::Paths &&input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit)
+// Input is already scaled by CLIPPER_OFFSET_SCALE, either ClipperLib::Paths or one of the ClipperUtils providers.
+template<typename PathsProvider>
+static ClipperLib::Paths _offset_scaled(const PathsProvider &input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit)
 {
-    // scale input
-    scaleClipperPolygons(input);
-    
     // perform offset
     ClipperLib::ClipperOffset co;
     if (joinType == jtRound)
@@ -233,6 +218,13 @@ ClipperLib::Paths _offset(ClipperLib::Paths &&input, ClipperLib::EndType endType
     return retval;
 }
 
+ClipperLib::Paths _offset(ClipperLib::Paths &&input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit)
+{
+    // scale input
+    scaleClipperPolygons(input);
+    return _offset_scaled(input, endType, delta, joinType, miterLimit);
+}
+
 ClipperLib::Paths _offset(ClipperLib::Path &&input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit)
 {
     ClipperLib::Paths paths;
@@ -240,6 +232,21 @@ ClipperLib::Paths _offset(ClipperLib::Path &&input, ClipperLib::EndType endType,
 	return _offset(std::move(paths), endType, delta, joinType, miterLimit);
 }
 
+ClipperLib::Paths _offset(const Slic3r::MultiPoint &input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit)
+{
+    return _offset_scaled(std::array<ClipperUtils::PointsView<true>, 1>{ ClipperUtils::PointsView<true>(input.points) }, endType, delta, joinType, miterLimit);
+}
+
+ClipperLib::Paths _offset(const Slic3r::Polygons &input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit)
+{
+    return _offset_scaled(ClipperUtils::PolygonsProvider<true>(input), endType, delta, joinType, miterLimit);
+}
+
+ClipperLib::Paths _offset(const Slic3r::Polylines &input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit)
+{
+    return _offset_scaled(ClipperUtils::PolylinesProvider<true>(input), endType, delta, joinType, miterLimit);
+}
+
 // This is a safe variant of the polygon offset, tailored for a single ExPolygon:
 // a single polygon with multiple non-overlapping holes.
 // Each contour and hole is offsetted separately, then the holes are subtracted from the outer contours.
@@ -251,15 +258,13 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygon &expolygon, const float delta,
     const float delta_scaled = delta * float(CLIPPER_OFFSET_SCALE);
     ClipperLib::Paths contours;
     {
-        ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath(expolygon.contour);
-        scaleClipperPolygon(input);
         ClipperLib::ClipperOffset co;
         if (joinType == jtRound)
             co.ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
         else
             co.MiterLimit = miterLimit;
         co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
-        co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
+        co.AddPath(ClipperUtils::PointsView<true>(expolygon.contour.points), joinType, ClipperLib::etClosedPolygon);
         co.Execute(contours, delta_scaled);
     }
 
@@ -268,15 +273,13 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygon &expolygon, const float delta,
     {
         holes.reserve(expolygon.holes.size());
         for (Polygons::const_iterator it_hole = expolygon.holes.begin(); it_hole != expolygon.holes.end(); ++ it_hole) {
-            ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath_reversed(*it_hole);
-            scaleClipperPolygon(input);
             ClipperLib::ClipperOffset co;
             if (joinType == jtRound)
                 co.ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
             else
                 co.MiterLimit = miterLimit;
             co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
-            co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
+            co.AddPath(ClipperUtils::PointsView<true, true>(it_hole->points), joinType, ClipperLib::etClosedPolygon);
             ClipperLib::Paths out;
             co.Execute(out, - delta_scaled);
             holes.insert(holes.end(), out.begin(), out.end());
@@ -317,15 +320,13 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygons &expolygons, const float delt
         // 1) Offset the outer contour.
         ClipperLib::Paths contours;
         {
-            ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath(it_expoly->contour);
-            scaleClipperPolygon(input);
             ClipperLib::ClipperOffset co;
             if (joinType == jtRound)
                 co.ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
             else
                 co.MiterLimit = miterLimit;
             co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
-            co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
+            co.AddPath(ClipperUtils::PointsView<true>(it_expoly->contour.points), joinType, ClipperLib::etClosedPolygon);
             co.Execute(contours, delta_scaled);
         }
         if (contours.empty())
@@ -341,15 +342,13 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygons &expolygons, const float delt
             ClipperLib::Paths holes;
             {
                 for (Polygons::const_iterator it_hole = it_expoly->holes.begin(); it_hole != it_expoly->holes.end(); ++ it_hole) {
-                    ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath_reversed(*it_hole);
-                    scaleClipperPolygon(input);
                     ClipperLib::ClipperOffset co;
                     if (joinType == jtRound)
                         co.ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
                     else
                         co.MiterLimit = miterLimit;
                     co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
-                    co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
+                    co.AddPath(ClipperUtils::PointsView<true, true>(it_hole->points), joinType, ClipperLib::etClosedPolygon);
                     ClipperLib::Paths out;
                     co.Execute(out, - delta_scaled);
                     holes.insert(holes.end(), out.begin(), out.end());
@@ -413,12 +412,6 @@ ClipperLib::Paths
 _offset2(const Polygons &polygons, const float delta1, const float delta2,
     const ClipperLib::JoinType joinType, const double miterLimit)
 {
-    // read input
-    ClipperLib::Paths input = Slic3rMultiPoints_to_ClipperPaths(polygons);
-    
-    // scale input
-    scaleClipperPolygons(input);
-    
     // prepare ClipperOffset object
     ClipperLib::ClipperOffset co;
     if (joinType == jtRound) {
@@ -432,7 +425,7 @@ _offset2(const Polygons &polygons, const float delta1, const float delta2,
     
     // perform first offset
     ClipperLib::Paths output1;
-    co.AddPaths(input, joinType, ClipperLib::etClosedPolygon);
+    co.AddPaths(ClipperUtils::PolygonsProvider<true>(polygons), joinType, ClipperLib::etClosedPolygon);
     co.Execute(output1, delta_scaled1);
     
     // perform second offset
@@ -481,6 +474,22 @@ ExPolygons offset2_ex(const ExPolygons &expolygons, const float delta1,
     return union_ex(polys);
 }
 
+static inline ClipperUtils::PolygonsProvider<>   clipper_paths_provider(const Polygons &polygons)     { return ClipperUtils::PolygonsProvider<>(polygons); }
+static inline ClipperUtils::ExPolygonsProvider<> clipper_paths_provider(const ExPolygons &expolygons) { return ClipperUtils::ExPolygonsProvider<>(expolygons); }
+
+// Add the input polygons to the Clipper, optionally with the safety offset applied.
+// Only the safety offset needs the input to be converted to ClipperLib::Paths, otherwise the input is passed to the Clipper through a provider.
+template<class TPolygons>
+static void clipper_add_paths(ClipperLib::Clipper &clipper, const TPolygons &polygons, ClipperLib::PolyType polyType, bool safety_offset_)
+{
+    if (safety_offset_) {
+        ClipperLib::Paths paths = Slic3rMultiPoints_to_ClipperPaths(polygons);
+        safety_offset(&paths);
+        clipper.AddPaths(paths, polyType, true);
+    } else
+        clipper.AddPaths(clipper_paths_provider(polygons), polyType, true);
+}
+
 template<class T, class TSubj, class TClip>
 T _clipper_do(const ClipperLib::ClipType     clipType,
               TSubj &&                        subject,
@@ -488,26 +497,13 @@ T _clipper_do(const ClipperLib::ClipType     clipType,
               const ClipperLib::PolyFillType fillType,
               const bool                     safety_offset_)
 {
-    // read input
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(std::forward<TSubj>(subject));
-    ClipperLib::Paths input_clip    = Slic3rMultiPoints_to_ClipperPaths(std::forward<TClip>(clip));
-    
-    // perform safety offset
-    if (safety_offset_) {
-        if (clipType == ClipperLib::ctUnion) {
-            safety_offset(&input_subject);
-        } else {
-            safety_offset(&input_clip);
-        }
-    }
-    
     // init Clipper
     ClipperLib::Clipper clipper;
     clipper.Clear();
     
-    // add polygons
-    clipper.AddPaths(input_subject, ClipperLib::ptSubject, true);
-    clipper.AddPaths(input_clip,    ClipperLib::ptClip,    true);
+    // add polygons, perform safety offset
+    clipper_add_paths(clipper, subject, ClipperLib::ptSubject, safety_offset_ && clipType == ClipperLib::ctUnion);
+    clipper_add_paths(clipper, clip,    ClipperLib::ptClip,    safety_offset_ && clipType != ClipperLib::ctUnion);
     
     // perform operation
     T retval;
@@ -522,50 +518,43 @@ T _clipper_do(const ClipperLib::ClipType     clipType,
 // This function implmenets a following workaround:
 // 1) Peform the Clipper operation with the output to Paths. This method handles overlaps in a reasonable time.
 // 2) Run Clipper Union once again to extract the PolyTree from the result of 1).
-inline ClipperLib::PolyTree _clipper_do_polytree2(const ClipperLib::ClipType clipType, const Polygons &subject, 
-    const Polygons &clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_)
+// The input polygons are expected to be already added to the clipper.
+static ClipperLib::PolyTree _clipper_execute_polytree2(ClipperLib::Clipper &clipper, const ClipperLib::ClipType clipType, const ClipperLib::PolyFillType fillType)
 {
-    // read input
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(subject);
-    ClipperLib::Paths input_clip    = Slic3rMultiPoints_to_ClipperPaths(clip);
-    
-    // perform safety offset
-    if (safety_offset_)
-        safety_offset((clipType == ClipperLib::ctUnion) ? &input_subject : &input_clip);
-    
-    ClipperLib::Clipper clipper;
-    clipper.AddPaths(input_subject, ClipperLib::ptSubject, true);
-    clipper.AddPaths(input_clip,    ClipperLib::ptClip,    true);
-    // Perform the operation with the output to input_subject.
+    // Perform the operation with the output to Paths.
     // This pass does not generate a PolyTree, which is a very expensive operation with the current Clipper library
     // if there are overapping edges.
-    clipper.Execute(clipType, input_subject, fillType, fillType);
+    ClipperLib::Paths output;
+    clipper.Execute(clipType, output, fillType, fillType);
     // Perform an additional Union operation to generate the PolyTree ordering.
     clipper.Clear();
-    clipper.AddPaths(input_subject, ClipperLib::ptSubject, true);
+    clipper.AddPaths(output, ClipperLib::ptSubject, true);
     ClipperLib::PolyTree retval;
     clipper.Execute(ClipperLib::ctUnion, retval, fillType, fillType);
     return retval;
 }
 
+inline ClipperLib::PolyTree _clipper_do_polytree2(const ClipperLib::ClipType clipType, const Polygons &subject, 
+    const Polygons &clip, const ClipperLib::PolyFillType fillType, const bool safety_offset_)
+{
+    // add polygons, perform safety offset
+    ClipperLib::Clipper clipper;
+    clipper_add_paths(clipper, subject, ClipperLib::ptSubject, safety_offset_ && clipType == ClipperLib::ctUnion);
+    clipper_add_paths(clipper, clip,    ClipperLib::ptClip,    safety_offset_ && clipType != ClipperLib::ctUnion);
+    return _clipper_execute_polytree2(clipper, clipType, fillType);
+}
+
 ClipperLib::PolyTree _clipper_do_pl(const ClipperLib::ClipType clipType, const Polylines &subject, 
     const Polygons &clip, const ClipperLib::PolyFillType fillType,
     const bool safety_offset_)
 {
-    // read input
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(subject);
-    ClipperLib::Paths input_clip    = Slic3rMultiPoints_to_ClipperPaths(clip);
-    
-    // perform safety offset
-    if (safety_offset_) safety_offset(&input_clip);
-    
     // init Clipper
     ClipperLib::Clipper clipper;
     clipper.Clear();
     
-    // add polygons
-    clipper.AddPaths(input_subject, ClipperLib::ptSubject, false);
-    clipper.AddPaths(input_clip,    ClipperLib::ptClip,    true);
+    // add polygons, perform safety offset
+    clipper.AddPaths(ClipperUtils::PolylinesProvider<>(subject), ClipperLib::ptSubject, false);
+    clipper_add_paths(clipper, clip, ClipperLib::ptClip, safety_offset_);
     
     // perform operation
     ClipperLib::PolyTree retval;
@@ -748,20 +737,307 @@ Polygons union_pt_chained(const Polygons &subject, bool safety_offset_)
 //    return retval;
 }
 
+ClipperContext::ClipperContext(const Polygons &polygons) : m_paths(Slic3rMultiPoints_to_ClipperPaths(polygons)) {}
+ClipperContext::ClipperContext(const ExPolygons &expolygons) : m_paths(Slic3rMultiPoints_to_ClipperPaths(expolygons)) {}
+
+// Same as offset(const Polygons&, ...), the intermediate result is already in the Clipper representation, thus it is just scaled in place.
+ClipperContext& ClipperContext::offset(const float delta, ClipperLib::JoinType joinType, double miterLimit)
+{
+    scaleClipperPolygons(m_paths);
+    m_paths = _offset_scaled(m_paths, ClipperLib::etClosedPolygon, delta, joinType, miterLimit);
+    return *this;
+}
+
+// Same as _clipper(clipType, subject, clip, false).
+template<typename PathsProvider>
+ClipperContext& ClipperContext::clip(ClipperLib::ClipType clipType, const PathsProvider &clip)
+{
+    ClipperLib::Clipper clipper;
+    clipper.AddPaths(m_paths, ClipperLib::ptSubject, true);
+    clipper.AddPaths(clip,    ClipperLib::ptClip,    true);
+    // The input paths were copied into the Clipper edges, thus the output may overwrite them.
+    clipper.Execute(clipType, m_paths, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+    return *this;
+}
+
+ClipperContext& ClipperContext::diff(const Polygons &clip)                { return this->clip(ClipperLib::ctDifference, ClipperUtils::PolygonsProvider<>(clip)); }
+ClipperContext& ClipperContext::diff(const ExPolygons &clip)              { return this->clip(ClipperLib::ctDifference, ClipperUtils::ExPolygonsProvider<>(clip)); }
+ClipperContext& ClipperContext::diff(const ClipperContext &clip)          { return this->clip(ClipperLib::ctDifference, clip.m_paths); }
+ClipperContext& ClipperContext::intersection(const Polygons &clip)        { return this->clip(ClipperLib::ctIntersection, ClipperUtils::PolygonsProvider<>(clip)); }
+ClipperContext& ClipperContext::intersection(const ExPolygons &clip)      { return this->clip(ClipperLib::ctIntersection, ClipperUtils::ExPolygonsProvider<>(clip)); }
+ClipperContext& ClipperContext::intersection(const ClipperContext &clip)  { return this->clip(ClipperLib::ctIntersection, clip.m_paths); }
+ClipperContext& ClipperContext::union_()                                  { return this->clip(ClipperLib::ctUnion, ClipperLib::Paths()); }
+
+// Same as _clipper_do_polytree2(): Union to Paths first, then extract the PolyTree by another union.
+ExPolygons ClipperContext::expolygons() const
+{
+    ClipperLib::Clipper clipper;
+    clipper.AddPaths(m_paths, ClipperLib::ptSubject, true);
+    ClipperLib::PolyTree polytree = _clipper_execute_polytree2(clipper, ClipperLib::ctUnion, ClipperLib::pftNonZero);
+    return PolyTreeToExPolygons(polytree);
+}
+
+// Minimum number of points of the input of union_parallel() / offset_parallel() to be split into batches processed in parallel.
+static constexpr size_t clipper_parallel_min_points       = 20000;
+// Minimum number of points of a single batch processed by a single Clipper call.
+static constexpr size_t clipper_parallel_min_batch_points = 5000;
+
+// Recursively split the polygons at gaps between their bounding boxes, alternating the X and Y axes.
+// The polygons of a group are stored continuously in [begin, end), end of each group is stored into group_ends.
+static void split_at_bounding_box_gaps(const std::vector<BoundingBox> &bboxes, size_t *begin, size_t *end, int axis, bool other_axis_split, std::vector<size_t*> &group_ends)
+{
+    std::sort(begin, end, [&bboxes, axis](size_t i, size_t j) { return bboxes[i].min(axis) < bboxes[j].min(axis); });
+    size_t  *group_begin = begin;
+    coord_t  max         = bboxes[*begin].max(axis);
+    for (size_t *it = begin + 1; it != end; ++ it) {
+        const BoundingBox &bbox = bboxes[*it];
+        if (bbox.min(axis) > max) {
+            // Gap found. The group [group_begin, it) cannot be split along this axis anymore, try the other axis.
+            split_at_bounding_box_gaps(bboxes, group_begin, it, 1 - axis, true, group_ends);
+            group_begin = it;
+        }
+        max = std::max(max, bbox.max(axis));
+    }
+    if (group_begin != begin)
+        split_at_bounding_box_gaps(bboxes, group_begin, end, 1 - axis, true, group_ends);
+    else if (other_axis_split)
+        // Cannot be split along either axis.
+        group_ends.emplace_back(end);
+    else
+        split_at_bounding_box_gaps(bboxes, begin, end, 1 - axis, true, group_ends);
+}
+
+// Partition the polygons into batches, whose bounding boxes inflated by margin do not overlap, thus the polygons of different batches
+// and their offsets by up to margin do not intersect nor touch. Each batch has at least clipper_parallel_min_batch_points points,
+// the polygon indices of a batch are sorted, so that the Clipper library receives the polygons of a batch in their original order.
+// Returns no batch if the input is too small or if it cannot be split.
+template<typename PolygonFn>
+static std::vector<std::vector<size_t>> clipper_parallel_batches(size_t num_polygons, PolygonFn polygon, coord_t margin)
+{
+    std::vector<std::vector<size_t>> batches;
+    std::vector<BoundingBox>         bboxes(num_polygons);
+    std::vector<size_t>              order;
+    size_t                           num_points = 0;
+    for (size_t i = 0; i < num_polygons; ++ i) {
+        const Polygon &poly = polygon(i);
+        // Polygons with less than 3 points are ignored by the Clipper library.
+        if (poly.points.size() >= 3) {
+            bboxes[i] = get_extents(poly);
+            bboxes[i].offset(margin);
+            order.emplace_back(i);
+            num_points += poly.points.size();
+        }
+    }
+    if (num_points < clipper_parallel_min_points)
+        return batches;
+
+    std::vector<size_t*> group_ends;
+    split_at_bounding_box_gaps(bboxes, order.data(), order.data() + order.size(), 0, false, group_ends);
+    if (group_ends.size() < 2)
+        return batches;
+
+    // Collect neighbor groups into batches to amortize the cost of the Clipper calls over small groups.
+    size_t batch_points = 0;
+    size_t *group_begin = order.data();
+    for (size_t *group_end : group_ends) {
+        if (batches.empty() || batch_points >= clipper_parallel_min_batch_points) {
+            batches.emplace_back();
+            batch_points = 0;
+        }
+        for (size_t *it = group_begin; it != group_end; ++ it) {
+            batches.back().emplace_back(*it);
+            batch_points += polygon(*it).points.size();
+        }
+        group_begin = group_end;
+    }
+    if (batches.size() < 2)
+        batches.clear();
+    for (std::vector<size_t> &batch : batches)
+        std::sort(batch.begin(), batch.end());
+    return batches;
+}
+
+// Adaptor of a subset of Polygons given by a range of indices to the input of the Clipper library, see ClipperUtils::PolygonsProvider.
+template<bool Scaled = false>
+class PolygonsSubsetProvider
+{
+public:
+    PolygonsSubsetProvider(const Polygons &polygons, const size_t *begin, const size_t *end, size_t index_offset = 0) :
+        m_polygons(polygons), m_begin(begin), m_end(end), m_index_offset(index_offset) {}
+    struct iterator {
+        const PolygonsSubsetProvider *self;
+        const size_t                 *it;
+        ClipperUtils::PointsView<Scaled> operator*() const { return ClipperUtils::PointsView<Scaled>(self->m_polygons[*it - self->m_index_offset].points); }
+        iterator&                        operator++() { ++ it; return *this; }
+        bool                             operator!=(const iterator &rhs) const { return it != rhs.it; }
+    };
+    iterator begin() const { return { this, m_begin }; }
+    iterator end()   const { return { this, m_end }; }
+private:
+    const Polygons &m_polygons;
+    const size_t   *m_begin;
+    const size_t   *m_end;
+    size_t          m_index_offset;
+};
+
+// Run union of a batch of subject and subject2 polygons, the subject2 polygons are indexed after the subject polygons.
+static void clipper_add_batch(ClipperLib::Clipper &clipper, const std::vector<size_t> &batch, const Polygons &subject, const Polygons &subject2)
+{
+    // The batch is sorted, the subject polygons precede the subject2 polygons.
+    const size_t *begin  = batch.data();
+    const size_t *end    = batch.data() + batch.size();
+    const size_t *middle = std::lower_bound(begin, end, subject.size());
+    clipper.AddPaths(PolygonsSubsetProvider<>(subject,  begin,  middle), ClipperLib::ptSubject, true);
+    clipper.AddPaths(PolygonsSubsetProvider<>(subject2, middle, end, subject.size()), ClipperLib::ptClip, true);
+}
+
+// The Clipper library sweeps the plane from the highest Y down and it outputs the polygons in the order they were started,
+// that is in the order of their lowest points in the Clipper sense (the highest Y).
+static coord_t clipper_output_order_key(const Polygon &poly)
+{
+    coord_t y = poly.points.front().y();
+    for (const Point &pt : poly.points)
+        y = std::max(y, pt.y());
+    return y;
+}
+
+// Merge the outputs of the batches by their keys, so that the result is ordered as if it was produced by a single Clipper call.
+// Only the polygons with their lowest points at the same Y may be ordered differently, as the Clipper library sorts its
+// local minima by an unstable sort.
+template<typename T>
+static std::vector<T> clipper_parallel_merge(std::vector<std::vector<T>> &&out, const std::vector<std::vector<coord_t>> &keys)
+{
+    size_t num_out = 0;
+    for (const std::vector<T> &batch_out : out)
+        num_out += batch_out.size();
+    std::vector<T>      retval;
+    std::vector<size_t> next(out.size(), 0);
+    retval.reserve(num_out);
+    for (size_t i = 0; i < num_out; ++ i) {
+        size_t best = size_t(-1);
+        for (size_t batch = 0; batch < out.size(); ++ batch)
+            if (next[batch] < out[batch].size() && (best == size_t(-1) || keys[batch][next[batch]] > keys[best][next[best]]))
+                best = batch;
+        retval.emplace_back(std::move(out[best][next[best] ++]));
+    }
+    return retval;
+}
+
+static std::vector<coord_t> clipper_output_order_keys(const Polygons &polygons)
+{
+    std::vector<coord_t> keys;
+    keys.reserve(polygons.size());
+    for (const Polygon &poly : polygons)
+        keys.emplace_back(clipper_output_order_key(poly));
+    return keys;
+}
+
+Polygons union_parallel(const Polygons &subject, const Polygons &subject2)
+{
+    std::vector<std::vector<size_t>> batches = clipper_parallel_batches(subject.size() + subject2.size(),
+        [&subject, &subject2](size_t idx) -> const Polygon& { return idx < subject.size() ? subject[idx] : subject2[idx - subject.size()]; }, 0);
+    if (batches.empty())
+        return union_(subject, subject2);
+
+    std::vector<Polygons>             out(batches.size());
+    std::vector<std::vector<coord_t>> keys(batches.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, batches.size(), 1),
+        [&batches, &subject, &subject2, &out, &keys](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                ClipperLib::Clipper clipper;
+                clipper_add_batch(clipper, batches[i], subject, subject2);
+                ClipperLib::Paths output;
+                clipper.Execute(ClipperLib::ctUnion, output, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+                out[i]  = ClipperPaths_to_Slic3rPolygons(output);
+                keys[i] = clipper_output_order_keys(out[i]);
+            }
+        });
+    return clipper_parallel_merge(std::move(out), keys);
+}
+
+ExPolygons union_parallel_ex(const Polygons &subject)
+{
+    std::vector<std::vector<size_t>> batches = clipper_parallel_batches(subject.size(), [&subject](size_t idx) -> const Polygon& { return subject[idx]; }, 0);
+    if (batches.empty())
+        return union_ex(subject);
+
+    std::vector<ExPolygons>           out(batches.size());
+    std::vector<std::vector<coord_t>> keys(batches.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, batches.size(), 1),
+        [&batches, &subject, &out, &keys](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                ClipperLib::Clipper clipper;
+                clipper_add_batch(clipper, batches[i], subject, Polygons());
+                ClipperLib::PolyTree polytree = _clipper_execute_polytree2(clipper, ClipperLib::ctUnion, ClipperLib::pftNonZero);
+                // Same as PolyTreeToExPolygons(), the islands nested inside the holes of an outer node follow that node
+                // and they are ordered by the key of that node.
+                for (int j = 0; j < polytree.ChildCount(); ++ j) {
+                    AddOuterPolyNodeToExPolygons(*polytree.Childs[j], &out[i]);
+                    keys[i].resize(out[i].size(), clipper_output_order_key(out[i][keys[i].size()].contour));
+                }
+            }
+        });
+    return clipper_parallel_merge(std::move(out), keys);
+}
+
+Polygons offset_parallel(const Polygons &polygons, const float delta, ClipperLib::JoinType joinType, double miterLimit)
+{
+    // The offset curve stays within delta from the source polygon, up to delta * miterLimit at the mitered corners.
+    // ClipperOffset clamps the miter limit to 2 from below.
+    const coord_t margin = coord_t(std::ceil(std::abs(delta) * std::max(2., joinType == jtMiter ? miterLimit : 2.))) + 1;
+    std::vector<std::vector<size_t>> batches = clipper_parallel_batches(polygons.size(), [&polygons](size_t idx) -> const Polygon& { return polygons[idx]; }, margin);
+    if (! batches.empty()) {
+        // ClipperOffset reverses all its input polygons if the polygon with the lowest point is oriented clockwise.
+        // The batches would be offsetted inconsistently with the serial offset if they decided differently.
+        int orientation = -1;
+        for (const std::vector<size_t> &batch : batches) {
+            // Lowest point in the Clipper sense is the one with the highest Y, the one with the lowest X of the same Y.
+            const Polygon *lowest    = nullptr;
+            const Point   *pt_lowest = nullptr;
+            for (size_t idx : batch)
+                for (const Point &pt : polygons[idx].points)
+                    if (pt_lowest == nullptr || pt.y() > pt_lowest->y() || (pt.y() == pt_lowest->y() && pt.x() < pt_lowest->x())) {
+                        lowest    = &polygons[idx];
+                        pt_lowest = &pt;
+                    }
+            int ccw = lowest->is_counter_clockwise();
+            if (orientation == -1)
+                orientation = ccw;
+            else if (orientation != ccw) {
+                batches.clear();
+                break;
+            }
+        }
+    }
+    if (batches.empty())
+        return offset(polygons, delta, joinType, miterLimit);
+
+    std::vector<Polygons>             out(batches.size());
+    std::vector<std::vector<coord_t>> keys(batches.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, batches.size(), 1),
+        [&batches, &polygons, delta, joinType, miterLimit, &out, &keys](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                const std::vector<size_t> &batch = batches[i];
+                out[i]  = ClipperPaths_to_Slic3rPolygons(_offset_scaled(
+                    PolygonsSubsetProvider<true>(polygons, batch.data(), batch.data() + batch.size()), ClipperLib::etClosedPolygon, delta, joinType, miterLimit));
+                keys[i] = clipper_output_order_keys(out[i]);
+            }
+        });
+    return clipper_parallel_merge(std::move(out), keys);
+}
+
 Polygons simplify_polygons(const Polygons &subject, bool preserve_collinear)
 {
-    // convert into Clipper polygons
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(subject);
-    
     ClipperLib::Paths output;
     if (preserve_collinear) {
         ClipperLib::Clipper c;
         c.PreserveCollinear(true);
         c.StrictlySimple(true);
-        c.AddPaths(input_subject, ClipperLib::ptSubject, true);
+        c.AddPaths(ClipperUtils::PolygonsProvider<>(subject), ClipperLib::ptSubject, true);
         c.Execute(ClipperLib::ctUnion, output, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
     } else {
-        ClipperLib::SimplifyPolygons(input_subject, output, ClipperLib::pftNonZero);
+        // convert into Clipper polygons
+        ClipperLib::SimplifyPolygons(Slic3rMultiPoints_to_ClipperPaths(subject), output, ClipperLib::pftNonZero);
     }
     
     // convert into Slic3r polygons
@@ -773,15 +1049,12 @@ ExPolygons simplify_polygons_ex(const Polygons &subject, bool preserve_collinear
     if (! preserve_collinear)
         return union_ex(simplify_polygons(subject, false));
 
-    // convert into Clipper polygons
-    ClipperLib::Paths input_subject = Slic3rMultiPoints_to_ClipperPaths(subject);
-    
     ClipperLib::PolyTree polytree;
     
     ClipperLib::Clipper c;
     c.PreserveCollinear(true);
     c.StrictlySimple(true);
-    c.AddPaths(input_subject, ClipperLib::ptSubject, true);
+    c.AddPaths(ClipperUtils::PolygonsProvider<>(subject), ClipperLib::ptSubject, true);
     c.Execute(ClipperLib::ctUnion, polytree, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
     
     // convert into ExPolygons
@@ -843,7 +1116,7 @@ Polygons top_level_islands(const Slic3r::Polygons &polygons)
     ClipperLib::Clipper clipper;
     clipper.Clear();
     // perform union
-    clipper.AddPaths(Slic3rMultiPoints_to_ClipperPaths(polygons), ClipperLib::ptSubject, true);
+    clipper.AddPaths(ClipperUtils::PolygonsProvider<>(polygons), ClipperLib::ptSubject, true);
     ClipperLib::PolyTree polytree;
     clipper.Execute(ClipperLib::ctUnion, polytree, ClipperLib::pftEvenOdd, ClipperLib::pftEvenOdd); 
     // Convert only the top level islands to the output.
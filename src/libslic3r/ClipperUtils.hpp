@@ -42,19 +42,88 @@ Slic3r::Polygons   ClipperPaths_to_Slic3rPolygons(const ClipperLib::Paths &input
 Slic3r::Polylines  ClipperPaths_to_Slic3rPolylines(const ClipperLib::Paths &input);
 Slic3r::ExPolygons ClipperPaths_to_Slic3rExPolygons(const ClipperLib::Paths &input);
 
+namespace ClipperUtils {
+    // Adaptors of the Slic3r polygons to the input of ClipperLib::Clipper::AddPath(s)() and ClipperLib::ClipperOffset::AddPath(s)().
+    // The 32bit Slic3r points are widened to the 64bit ClipperLib::IntPoint (and optionally scaled by CLIPPER_OFFSET_SCALE)
+    // while the Clipper library copies them into its edges, thus no temporary ClipperLib::Paths are allocated for the input.
+
+    // A single path: Polygon, Polyline or a hole traversed in reverse order.
+    template<bool Scaled = false, bool Reversed = false>
+    class PointsView
+    {
+    public:
+        explicit PointsView(const Points &points) : m_points(&points) {}
+        size_t               size() const { return m_points->size(); }
+        ClipperLib::IntPoint operator[](size_t idx) const {
+            const Point &pt = (*m_points)[Reversed ? m_points->size() - 1 - idx : idx];
+            return Scaled ?
+                ClipperLib::IntPoint(ClipperLib::cInt(pt.x()) << CLIPPER_OFFSET_POWER_OF_2, ClipperLib::cInt(pt.y()) << CLIPPER_OFFSET_POWER_OF_2) :
+                ClipperLib::IntPoint(pt.x(), pt.y());
+        }
+    private:
+        const Points *m_points;
+    };
+
+    // Polygons or Polylines.
+    template<typename MultiPointType, bool Scaled = false>
+    class MultiPointsProvider
+    {
+    public:
+        explicit MultiPointsProvider(const std::vector<MultiPointType> &multipoints) : m_multipoints(multipoints) {}
+        struct iterator {
+            typename std::vector<MultiPointType>::const_iterator it;
+            PointsView<Scaled> operator*() const { return PointsView<Scaled>(it->points); }
+            iterator&          operator++() { ++ it; return *this; }
+            bool               operator!=(const iterator &rhs) const { return it != rhs.it; }
+        };
+        iterator begin() const { return { m_multipoints.cbegin() }; }
+        iterator end()   const { return { m_multipoints.cend() }; }
+    private:
+        const std::vector<MultiPointType> &m_multipoints;
+    };
+
+    template<bool Scaled = false>
+    using PolygonsProvider  = MultiPointsProvider<Polygon, Scaled>;
+    template<bool Scaled = false>
+    using PolylinesProvider = MultiPointsProvider<Polyline, Scaled>;
+
+    // Contours and holes of ExPolygons in the same order as returned by to_polygons(const ExPolygons&).
+    template<bool Scaled = false>
+    class ExPolygonsProvider
+    {
+    public:
+        explicit ExPolygonsProvider(const ExPolygons &expolygons) : m_expolygons(expolygons) {}
+        struct iterator {
+            ExPolygons::const_iterator it;
+            // 0 for the contour, 1 + hole index for the holes.
+            size_t                     idx;
+            PointsView<Scaled> operator*() const { return PointsView<Scaled>(idx == 0 ? it->contour.points : it->holes[idx - 1].points); }
+            iterator&          operator++() { if (++ idx > it->holes.size()) { ++ it; idx = 0; } return *this; }
+            bool               operator!=(const iterator &rhs) const { return it != rhs.it || idx != rhs.idx; }
+        };
+        iterator begin() const { return { m_expolygons.cbegin(), 0 }; }
+        iterator end()   const { return { m_expolygons.cend(), 0 }; }
+    private:
+        const ExPolygons &m_expolygons;
+    };
+}
+
 // offset Polygons
 ClipperLib::Paths _offset(ClipperLib::Path &&input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit);
 ClipperLib::Paths _offset(ClipperLib::Paths &&input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit);
+ClipperLib::Paths _offset(const Slic3r::MultiPoint &input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit);
+ClipperLib::Paths _offset(const Slic3r::Polygons &input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit);
+ClipperLib::Paths _offset(const Slic3r::Polylines &input, ClipperLib::EndType endType, const float delta, ClipperLib::JoinType joinType, double miterLimit);
 inline Slic3r::Polygons offset(const Slic3r::Polygon &polygon, const float delta, ClipperLib::JoinType joinType = ClipperLib::jtMiter,  double miterLimit = 3)
-    { return ClipperPaths_to_Slic3rPolygons(_offset(Slic3rMultiPoint_to_ClipperPath(polygon), ClipperLib::etClosedPolygon, delta, joinType, miterLimit)); }
+    { return ClipperPaths_to_Slic3rPolygons(_offset(polygon, ClipperLib::etClosedPolygon, delta, joinType, miterLimit)); }
 inline Slic3r::Polygons offset(const Slic3r::Polygons &polygons, const float delta, ClipperLib::JoinType joinType = ClipperLib::jtMiter, double miterLimit = 3)
-    { return ClipperPaths_to_Slic3rPolygons(_offset(Slic3rMultiPoints_to_ClipperPaths(polygons), ClipperLib::etClosedPolygon, delta, joinType, miterLimit)); }
+    { return ClipperPaths_to_Slic3rPolygons(_offset(polygons, ClipperLib::etClosedPolygon, delta, joinType, miterLimit)); }
 
 // offset Polylines
 inline Slic3r::Polygons offset(const Slic3r::Polyline &polyline, const float delta, ClipperLib::JoinType joinType = ClipperLib::jtSquare, double miterLimit = 3)
-    { return ClipperPaths_to_Slic3rPolygons(_offset(Slic3rMultiPoint_to_ClipperPath(polyline), ClipperLib::etOpenButt, delta, joinType, miterLimit)); }
+    { return ClipperPaths_to_Slic3rPolygons(_offset(polyline, ClipperLib::etOpenButt, delta, joinType, miterLimit)); }
 inline Slic3r::Polygons offset(const Slic3r::Polylines &polylines, const float delta, ClipperLib::JoinType joinType = ClipperLib::jtSquare, double miterLimit = 3)
-    { return ClipperPaths_to_Slic3rPolygons(_offset(Slic3rMultiPoints_to_ClipperPaths(polylines), ClipperLib::etOpenButt, delta, joinType, miterLimit)); }
+    { return ClipperPaths_to_Slic3rPolygons(_offset(polylines, ClipperLib::etOpenButt, delta, joinType, miterLimit)); }
 
 // offset expolygons and surfaces
 ClipperLib::Paths _offset(const Slic3r::ExPolygon &expolygon, const float delta, ClipperLib::JoinType joinType, double miterLimit);
@@ -64,9 +133,9 @@ inline Slic3r::Polygons offset(const Slic3r::ExPolygon &expolygon, const float d
 inline Slic3r::Polygons offset(const Slic3r::ExPolygons &expolygons, const float delta, ClipperLib::JoinType joinType = ClipperLib::jtMiter, double miterLimit = 3)
     { return ClipperPaths_to_Slic3rPolygons(_offset(expolygons, delta, joinType, miterLimit)); }
 inline Slic3r::ExPolygons offset_ex(const Slic3r::Polygon &polygon, const float delta, ClipperLib::JoinType joinType = ClipperLib::jtMiter, double miterLimit = 3)
-    { return ClipperPaths_to_Slic3rExPolygons(_offset(Slic3rMultiPoint_to_ClipperPath(polygon), ClipperLib::etClosedPolygon, delta, joinType, miterLimit)); }    
+    { return ClipperPaths_to_Slic3rExPolygons(_offset(polygon, ClipperLib::etClosedPolygon, delta, joinType, miterLimit)); }    
 inline Slic3r::ExPolygons offset_ex(const Slic3r::Polygons &polygons, const float delta, ClipperLib::JoinType joinType = ClipperLib::jtMiter, double miterLimit = 3)
-    { return ClipperPaths_to_Slic3rExPolygons(_offset(Slic3rMultiPoints_to_ClipperPaths(polygons), ClipperLib::etClosedPolygon, delta, joinType, miterLimit)); }
+    { return ClipperPaths_to_Slic3rExPolygons(_offset(polygons, ClipperLib::etClosedPolygon, delta, joinType, miterLimit)); }
 inline Slic3r::ExPolygons offset_ex(const Slic3r::ExPolygon &expolygon, const float delta, ClipperLib::JoinType joinType = ClipperLib::jtMiter, double miterLimit = 3)
     { return ClipperPaths_to_Slic3rExPolygons(_offset(expolygon, delta, joinType, miterLimit)); }
 inline Slic3r::ExPolygons offset_ex(const Slic3r::ExPolygons &expolygons, const float delta, ClipperLib::JoinType joinType = ClipperLib::jtMiter, double miterLimit = 3)
@@ -221,8 +290,56 @@ ClipperLib::PolyTree union_pt(Slic3r::ExPolygons &&subject, bool safety_offset_
 
 Slic3r::Polygons union_pt_chained(const Slic3r::Polygons &subject, bool safety_offset_ = false);
 
+// Parallel variants of union_(), union_ex() and offset() for very large polygon sets, for example for the islands of a full print bed.
+// The input is split at the gaps between the bounding boxes of its polygons (inflated by the offset distance), the parts are processed
+// by the Clipper library in parallel and their results are merged in the order the Clipper library emits its output polygons.
+// As no polygon crosses a split, there is no seam to merge and the result equals to the result of the serial function,
+// only the polygons with their lowest points at the same Y may be ordered differently.
+// Small inputs and inputs, which cannot be split, are processed serially.
+// Limitation: only inputs falling apart into groups separated by gaps are parallelized. A single large polygon, or polygons
+// overlapping across the whole bed, are processed serially. The input is not cut into tiles, as the seams of the tiles would
+// have to be merged by another union.
+Slic3r::Polygons   union_parallel(const Slic3r::Polygons &subject, const Slic3r::Polygons &subject2 = Slic3r::Polygons());
+Slic3r::ExPolygons union_parallel_ex(const Slic3r::Polygons &subject);
+Slic3r::Polygons   offset_parallel(const Slic3r::Polygons &polygons, const float delta, ClipperLib::JoinType joinType = ClipperLib::jtMiter, double miterLimit = 3);
+
 ClipperLib::PolyNodes order_nodes(const ClipperLib::PolyNodes &nodes);
 
+// Chain of offsets and boolean operations, which keeps the intermediate results in the Clipper representation,
+// thus the intermediate results are not converted to Slic3r::Polygons and back to ClipperLib::Paths.
+// The results are exactly the same as the results of the respective chain of the offset(), diff(), intersection() and union_() calls,
+// for example
+//     diff(intersection(offset(polygons, delta), clip1), clip2)
+// equals to
+//     ClipperContext(polygons).offset(delta).intersection(clip1).diff(clip2).polygons()
+class ClipperContext
+{
+public:
+    explicit ClipperContext(const Slic3r::Polygons &polygons);
+    explicit ClipperContext(const Slic3r::ExPolygons &expolygons);
+
+    ClipperContext& offset(const float delta, ClipperLib::JoinType joinType = ClipperLib::jtMiter, double miterLimit = 3);
+    ClipperContext& diff(const Slic3r::Polygons &clip);
+    ClipperContext& diff(const Slic3r::ExPolygons &clip);
+    ClipperContext& diff(const ClipperContext &clip);
+    ClipperContext& intersection(const Slic3r::Polygons &clip);
+    ClipperContext& intersection(const Slic3r::ExPolygons &clip);
+    ClipperContext& intersection(const ClipperContext &clip);
+    ClipperContext& union_();
+
+    bool                     empty() const { return m_paths.empty(); }
+    const ClipperLib::Paths& paths() const { return m_paths; }
+    Slic3r::Polygons         polygons() const { return ClipperPaths_to_Slic3rPolygons(m_paths); }
+    // Same as union_ex(this->polygons()).
+    Slic3r::ExPolygons       expolygons() const;
+
+private:
+    template<typename PathsProvider>
+    ClipperContext& clip(ClipperLib::ClipType clipType, const PathsProvider &clip);
+
+    ClipperLib::Paths        m_paths;
+};
+
 // Implementing generalized loop (foreach) over a list of nodes which can be
 // ordered or unordered (performance gain) based on template parameter
 enum class e_ordering {
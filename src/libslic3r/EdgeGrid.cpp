@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <vector>
 #include <float.h>
+#include <string.h>
 #include <unordered_map>
 
 #if 0
@@ -23,6 +24,12 @@
 
 #include <assert.h>
 
+// The row wise passes of calculate_sdf() are vectorized with SSE2, which is available on all x86-64 CPUs.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define EDGEGRID_SSE2
+	#include <emmintrin.h>
+#endif
+
 namespace Slic3r {
 
 EdgeGrid::Grid::Grid() : 
@@ -290,34 +297,41 @@ void EdgeGrid::Grid::create_from_m_contours(coord_t resolution)
 	}
 
 	// 5) Allocate the cell data.
-	m_cell_data.assign(cnt, std::pair<size_t, size_t>(size_t(-1), size_t(-1)));
+	m_cell_data.assign(cnt, CellSegment());
 
 	// 6) Finally fill in m_cell_data by rasterizing the lines once again.
 	for (size_t i = 0; i < m_cells.size(); ++i)
 		m_cells[i].end = m_cells[i].begin;
 
 	struct Visitor {
-		Visitor(std::vector<std::pair<size_t, size_t>> &cell_data, std::vector<Cell> &cells, size_t cols) :
-			cell_data(cell_data), cells(cells), cols(cols), i(0), j(0) {}
+		Visitor(std::vector<CellSegment> &cell_data, std::vector<Cell> &cells, size_t cols) :
+			cell_data(cell_data), cells(cells), cols(cols) {}
 
 		inline bool operator()(coord_t iy, coord_t ix) {
-			cell_data[cells[iy*cols + ix].end++] = std::pair<size_t, size_t>(i, j);
+			cell_data[cells[iy*cols + ix].end++] = segment;
 			// Continue traversing the grid along the edge.
 			return true;
 		}
 
-		std::vector<std::pair<size_t, size_t>> &cell_data;
-		std::vector<Cell> 					   &cells;
-		size_t									cols;
-		size_t 									i;
-		size_t 									j;
+		std::vector<CellSegment>   &cell_data;
+		std::vector<Cell> 		   &cells;
+		size_t						cols;
+		CellSegment 				segment;
 	} visitor(m_cell_data, m_cells, m_cols);
 
-	assert(visitor.i == 0);
-	for (; visitor.i < m_contours.size(); ++ visitor.i) {
-		const Slic3r::Points &pts = *m_contours[visitor.i];
-		for (visitor.j = 0; visitor.j < pts.size(); ++ visitor.j)
-			this->visit_cells_intersecting_line(pts[visitor.j], pts[(visitor.j + 1 == pts.size()) ? 0 : visitor.j + 1], visitor);
+	for (size_t i = 0; i < m_contours.size(); ++ i) {
+		const Slic3r::Points &pts = *m_contours[i];
+		for (size_t j = 0; j < pts.size(); ++ j) {
+			const Slic3r::Point &p1 = pts[j];
+			const Slic3r::Point &p2 = pts[(j + 1 == pts.size()) ? 0 : j + 1];
+			visitor.segment.first  = i;
+			visitor.segment.second = j;
+			visitor.segment.a 	   = p1;
+			visitor.segment.v 	   = p2 - p1;
+			visitor.segment.l2 	   = int64_t(visitor.segment.v(0)) * int64_t(visitor.segment.v(0)) + int64_t(visitor.segment.v(1)) * int64_t(visitor.segment.v(1));
+			visitor.segment.length = sqrt(double(visitor.segment.l2));
+			this->visit_cells_intersecting_line(p1, p2, visitor);
+		}
 	}
 }
 
@@ -657,6 +671,150 @@ struct PropagateDanielssonSingleVStep3 {
 	coord_t			resolution;
 };
 
+// Propagate the signum from the row at (addr + delta) to the row at addr, where the signum is not known yet.
+// Contrary to the propagation along a row, the cells of a row are independent.
+static inline void propagate_signum_vstep(unsigned char *signs, size_t addr, int delta, size_t ncols)
+{
+	size_t c = 0;
+#ifdef EDGEGRID_SSE2
+	const __m128i one  = _mm_set1_epi8(1);
+	const __m128i four = _mm_set1_epi8(4);
+	const __m128i zero = _mm_setzero_si128();
+	for (; c + 16 <= ncols; c += 16) {
+		__m128i cur_val = _mm_loadu_si128(reinterpret_cast<const __m128i*>(signs + addr + c));
+		__m128i old_val = _mm_loadu_si128(reinterpret_cast<const __m128i*>(signs + addr + c + delta));
+		// Signum of cur_val not known yet, signum of old_val known.
+		__m128i mask    = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_and_si128(cur_val, four), zero), _mm_cmpeq_epi8(_mm_and_si128(old_val, four), zero));
+		cur_val = _mm_or_si128(_mm_and_si128(mask, _mm_and_si128(old_val, one)), _mm_andnot_si128(mask, cur_val));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(signs + addr + c), cur_val);
+	}
+#endif /* EDGEGRID_SSE2 */
+	for (; c < ncols; ++ c) {
+		unsigned char &cur_val = signs[addr + c];
+		if (cur_val & 4) {
+			unsigned char old_val = signs[addr + c + delta];
+			if ((old_val & 4) == 0)
+				cur_val = old_val & 1;
+		}
+	}
+}
+
+// Propagate the signum along a row from left to right (DIR = 1) or from right to left (DIR = -1).
+// The cells of a row depend on each other, the signum of the previous cell is kept in a register.
+template<const int DIR>
+static inline void propagate_signum_hpass(unsigned char *signs, size_t ncols)
+{
+	if (ncols < 2)
+		return;
+	unsigned char *it  = (DIR > 0) ? signs : signs + ncols - 1;
+	unsigned char  old_val = *it;
+	for (size_t i = 1; i < ncols; ++ i) {
+		it += DIR;
+		unsigned char cur_val = *it;
+		if ((cur_val & 4) && (old_val & 4) == 0)
+			*it = cur_val = old_val & 1;
+		old_val = cur_val;
+	}
+}
+
+#ifdef EDGEGRID_SSE2
+// Squared lengths of four vectors stored as x0, y0, x1, y1 in v01 and x2, y2, x3, y3 in v23.
+static inline __m128 squared_norm4(__m128 v01, __m128 v23)
+{
+	__m128 sq01 = _mm_mul_ps(v01, v01);
+	__m128 sq23 = _mm_mul_ps(v23, v23);
+	return _mm_add_ps(_mm_shuffle_ps(sq01, sq23, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(sq01, sq23, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+// Four masks of the signs bits, all bits of a mask are set if (signs[i] & bit) != 0.
+static inline __m128 signs_mask4(const unsigned char *signs, unsigned char bit)
+{
+	int packed;
+	memcpy(&packed, signs, 4);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+	v = _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(bit)), zero);
+	return _mm_castsi128_ps(_mm_xor_si128(v, _mm_set1_epi32(-1)));
+}
+#endif /* EDGEGRID_SSE2 */
+
+// Danielsson propagation of the vectors towards the zero iso surface from the row at (addr + delta) to the row at addr.
+// Vectorized equivalent of PropagateDanielssonSingleStep<0, 1> applied to a whole row, the cells of a row are independent.
+static inline void propagate_danielsson_vstep(float *L, unsigned char *signs, size_t ncols, int r, int delta, coord_t resolution)
+{
+	const size_t addr = r * ncols;
+	size_t       c    = 0;
+#ifdef EDGEGRID_SSE2
+	const __m128 inc = _mm_setr_ps(0.f, float(resolution), 0.f, float(resolution));
+	for (; c + 4 <= ncols; c += 4) {
+		float  *v    = &L[(addr + c) << 1];
+		float  *v2s  = v + (delta << 1);
+		__m128  v01  = _mm_loadu_ps(v);
+		__m128  v23  = _mm_loadu_ps(v + 4);
+		__m128  v201 = _mm_add_ps(_mm_loadu_ps(v2s), inc);
+		__m128  v223 = _mm_add_ps(_mm_loadu_ps(v2s + 4), inc);
+		// Replace the vector if the propagated one is shorter and the vector is not an original value.
+		__m128  mask = _mm_andnot_ps(signs_mask4(signs + addr + c, 2), _mm_cmplt_ps(squared_norm4(v201, v223), squared_norm4(v01, v23)));
+		__m128  mask01 = _mm_unpacklo_ps(mask, mask);
+		__m128  mask23 = _mm_unpackhi_ps(mask, mask);
+		_mm_storeu_ps(v,     _mm_or_ps(_mm_and_ps(mask01, v201), _mm_andnot_ps(mask01, v01)));
+		_mm_storeu_ps(v + 4, _mm_or_ps(_mm_and_ps(mask23, v223), _mm_andnot_ps(mask23, v23)));
+	}
+#endif /* EDGEGRID_SSE2 */
+	PropagateDanielssonSingleStep<0, 1> danielsson_vstep(L, signs, ncols, resolution);
+	for (; c < ncols; ++ c)
+		danielsson_vstep(r, int(c), delta);
+}
+
+// Danielsson propagation of the vectors towards the zero iso surface along a row from left to right (DIR = 1)
+// or from right to left (DIR = -1), equivalent to PropagateDanielssonSingleStep<1, 0> applied to a whole row.
+// The cells of a row depend on each other, the vector of the previous cell is kept in registers.
+template<const int DIR>
+static inline void propagate_danielsson_hpass(float *L, const unsigned char *signs, size_t ncols, coord_t resolution)
+{
+	if (ncols < 2)
+		return;
+	const float 		 res  = float(resolution);
+	const size_t 		 c0   = (DIR > 0) ? 0 : ncols - 1;
+	float 				*v    = L + (c0 << 1);
+	const unsigned char *sign = signs + c0;
+	float 				 vx   = v[0];
+	float 				 vy   = v[1];
+	for (size_t i = 1; i < ncols; ++ i) {
+		v    += 2 * DIR;
+		sign += DIR;
+		float v2x = vx + res;
+		float v2y = vy;
+		vx = v[0];
+		vy = v[1];
+		if ((*sign & 2) == 0 && v2x * v2x + v2y * v2y < vx * vx + vy * vy) {
+			v[0] = vx = v2x;
+			v[1] = vy = v2y;
+		}
+	}
+}
+
+// Convert the vectors towards the zero iso surface of a row to signed distances.
+static inline void signed_distances_from_vectors(const float *L, const unsigned char *signs, size_t addr, size_t ncols, float *sdf)
+{
+	size_t c = 0;
+#ifdef EDGEGRID_SSE2
+	const __m128 sign_bit = _mm_set1_ps(-0.f);
+	for (; c + 4 <= ncols; c += 4) {
+		const float *v = &L[(addr + c) << 1];
+		__m128 d = _mm_sqrt_ps(squared_norm4(_mm_loadu_ps(v), _mm_loadu_ps(v + 4)));
+		_mm_storeu_ps(sdf + addr + c, _mm_xor_ps(d, _mm_and_ps(signs_mask4(signs + addr + c, 1), sign_bit)));
+	}
+#endif /* EDGEGRID_SSE2 */
+	for (; c < ncols; ++ c) {
+		const float *v = &L[(addr + c) << 1];
+		float        d = sqrt(v[0]*v[0]+v[1]*v[1]);
+		if (signs[addr + c] & 1)
+			d = -d;
+		sdf[addr + c] = d;
+	}
+}
+
 void EdgeGrid::Grid::calculate_sdf()
 {
 	// 1) Initialize a signum and an unsigned vector to a zero iso surface.
@@ -676,36 +834,39 @@ void EdgeGrid::Grid::calculate_sdf()
 	for (int r = 0; r < (int)m_rows; ++ r) {
 		for (int c = 0; c < (int)m_cols; ++ c) {
 			const Cell &cell = m_cells[r * m_cols + c];
+			// Range of the corners of this cell and its 1 ring neighbours.
+			const coord_t corner_r_begin = std::max(r - 1, 0);
+			const coord_t corner_r_end   = std::min(r + 3, (int)nrows);
+			const coord_t corner_c_begin = std::max(c - 1, 0);
+			const coord_t corner_c_end   = std::min(c + 3, (int)ncols);
 			// For each segment in the cell:
 			for (size_t i = cell.begin; i != cell.end; ++ i) {
-				const Slic3r::Points &pts = *m_contours[m_cell_data[i].first];
-				size_t ipt = m_cell_data[i].second;
-				// End points of the line segment.
-				const Slic3r::Point &p1 = pts[ipt];
-				const Slic3r::Point &p2 = pts[(ipt + 1 == pts.size()) ? 0 : ipt + 1];
+				const CellSegment   &seg = m_cell_data[i];
+				// Start point of the line segment.
+				const Slic3r::Point &p1 = seg.a;
 				// Segment vector
-				const Slic3r::Point v_seg = p2 - p1;
+				const Slic3r::Point &v_seg = seg.v;
 				// l2 of v_seg
-				const int64_t l2_seg = int64_t(v_seg(0)) * int64_t(v_seg(0)) + int64_t(v_seg(1)) * int64_t(v_seg(1));
+				const int64_t l2_seg = seg.l2;
+				// Increments of t_pt and d_seg when stepping to the next corner in the X direction.
+				const int64_t t_pt_step  = int64_t(v_seg(0)) * int64_t(m_resolution);
+				const int64_t d_seg_step = int64_t(v_seg(1)) * int64_t(m_resolution);
 				// For each corner of this cell and its 1 ring neighbours:
-				for (int corner_y = -1; corner_y < 3; ++ corner_y) {
-					coord_t corner_r = r + corner_y;
-					if (corner_r < 0 || (size_t)corner_r >= nrows)
-						continue;
-					for (int corner_x = -1; corner_x < 3; ++ corner_x) {
-						coord_t corner_c = c + corner_x;
-						if (corner_c < 0 || (size_t)corner_c >= ncols)
-							continue;
+				for (coord_t corner_r = corner_r_begin; corner_r < corner_r_end; ++ corner_r) {
+					Slic3r::Point v_pt(m_bbox.min(0) + corner_c_begin * m_resolution - p1(0), m_bbox.min(1) + corner_r * m_resolution - p1(1));
+					// dot(p2-p1, pt-p1)
+					int64_t t_pt  = int64_t(v_seg(0)) * int64_t(v_pt(0)) + int64_t(v_seg(1)) * int64_t(v_pt(1));
+					// cross(p2-p1, pt-p1), signed distance of pt from the line scaled by the segment length.
+					int64_t d_seg = int64_t(v_seg(1)) * int64_t(v_pt(0)) - int64_t(v_seg(0)) * int64_t(v_pt(1));
+					for (coord_t corner_c = corner_c_begin; corner_c < corner_c_end; ++ corner_c, v_pt(0) += m_resolution, t_pt += t_pt_step, d_seg += d_seg_step) {
 						float  &d_min = m_signed_distance_field[corner_r * ncols + corner_c];
-						Slic3r::Point pt(m_bbox.min(0) + corner_c * m_resolution, m_bbox.min(1) + corner_r * m_resolution);
-						Slic3r::Point v_pt = pt - p1;
-						// dot(p2-p1, pt-p1)
-						int64_t t_pt = int64_t(v_seg(0)) * int64_t(v_pt(0)) + int64_t(v_seg(1)) * int64_t(v_pt(1));
 						if (t_pt < 0) {
 							// Closest to p1.
 							double dabs = sqrt(int64_t(v_pt(0)) * int64_t(v_pt(0)) + int64_t(v_pt(1)) * int64_t(v_pt(1)));
 							if (dabs < d_min) {
 								// Previous point.
+								const Slic3r::Points &pts = *m_contours[m_cell_data[i].first];
+								size_t ipt = m_cell_data[i].second;
 								const Slic3r::Point &p0 = pts[(ipt == 0) ? (pts.size() - 1) : ipt - 1];
 								Slic3r::Point v_seg_prev = p1 - p0;
 								int64_t t2_pt = int64_t(v_seg_prev(0)) * int64_t(v_pt(0)) + int64_t(v_seg_prev(1)) * int64_t(v_pt(1));
@@ -733,8 +894,7 @@ void EdgeGrid::Grid::calculate_sdf()
 						} else {
 							// Closest to the segment.
 							assert(t_pt >= 0 && t_pt <= l2_seg);
-							int64_t d_seg = int64_t(v_seg(1)) * int64_t(v_pt(0)) - int64_t(v_seg(0)) * int64_t(v_pt(1));
-							double d = double(d_seg) / sqrt(double(l2_seg));
+							double d = double(d_seg) / seg.length;
 							double dabs = std::abs(d);
 							if (dabs < d_min) {
 								d_min = dabs;
@@ -822,74 +982,41 @@ void EdgeGrid::Grid::calculate_sdf()
 #endif /* SLIC3R_GUI */
 
 	// 2) Propagate the signum.
-	#define PROPAGATE_SIGNUM_SINGLE_STEP(DELTA) do { \
-		size_t 		   addr    = r * ncols + c;				\
-		unsigned char &cur_val = signs[addr]; 				\
-		if (cur_val & 4) {	 								\
-			unsigned char old_val = signs[addr + (DELTA)];  \
-			if ((old_val & 4) == 0)							\
-				cur_val = old_val & 1; 						\
-		} 													\
-	} while (0);
 	// Top to bottom propagation.
 	for (size_t r = 0; r < nrows; ++ r) {
 		if (r > 0)
-			for (size_t c = 0; c < ncols; ++ c)
-				PROPAGATE_SIGNUM_SINGLE_STEP(- int(ncols));
-		for (size_t c = 1; c < ncols; ++ c)
-			PROPAGATE_SIGNUM_SINGLE_STEP(- 1);
-		for (int c = int(ncols) - 2; c >= 0; -- c)
-			PROPAGATE_SIGNUM_SINGLE_STEP(+ 1);
+			propagate_signum_vstep(signs.data(), r * ncols, - int(ncols), ncols);
+		propagate_signum_hpass<1>(signs.data() + r * ncols, ncols);
+		propagate_signum_hpass<-1>(signs.data() + r * ncols, ncols);
 	}
 	// Bottom to top propagation.
 	for (int r = int(nrows) - 2; r >= 0; -- r) {
-		for (size_t c = 0; c < ncols; ++ c)
-			PROPAGATE_SIGNUM_SINGLE_STEP(+ ncols);
-		for (size_t c = 1; c < ncols; ++ c)
-			PROPAGATE_SIGNUM_SINGLE_STEP(- 1);
-		for (int c = int(ncols) - 2; c >= 0; -- c)
-			PROPAGATE_SIGNUM_SINGLE_STEP(+ 1);
+		propagate_signum_vstep(signs.data(), r * ncols, + int(ncols), ncols);
+		propagate_signum_hpass<1>(signs.data() + r * ncols, ncols);
+		propagate_signum_hpass<-1>(signs.data() + r * ncols, ncols);
 	}
-	#undef PROPAGATE_SIGNUM_SINGLE_STEP
 
 	// 3) Propagate the distance by the Danielsson chamfer metric.
-	// Top to bottom propagation.
-	PropagateDanielssonSingleStep<1, 0> danielsson_hstep(L.data(), signs.data(), ncols, m_resolution);
-	PropagateDanielssonSingleStep<0, 1> danielsson_vstep(L.data(), signs.data(), ncols, m_resolution);
 	PropagateDanielssonSingleVStep3 	danielsson_vstep3(L.data(), signs.data(), ncols, m_resolution);
 	// Top to bottom propagation.
 	for (size_t r = 0; r < nrows; ++ r) {
 		if (r > 0)
-			for (size_t c = 0; c < ncols; ++ c)
-				danielsson_vstep(r, c, -int(ncols));
+			propagate_danielsson_vstep(L.data(), signs.data(), ncols, int(r), -int(ncols), m_resolution);
 //				PROPAGATE_DANIELSSON_SINGLE_VSTEP3(-int(ncols), c != 0, c + 1 != ncols);
-		for (size_t c = 1; c < ncols; ++ c)
-			danielsson_hstep(r, c, -1);
-		for (int c = int(ncols) - 2; c >= 0; -- c)
-			danielsson_hstep(r, c, +1);
+		propagate_danielsson_hpass<1>(L.data() + ((r * ncols) << 1), signs.data() + r * ncols, ncols, m_resolution);
+		propagate_danielsson_hpass<-1>(L.data() + ((r * ncols) << 1), signs.data() + r * ncols, ncols, m_resolution);
 	}
 	// Bottom to top propagation.
 	for (int r = int(nrows) - 2; r >= 0; -- r) {
-		for (size_t c = 0; c < ncols; ++ c)
-			danielsson_vstep(r, c, +ncols);
+		propagate_danielsson_vstep(L.data(), signs.data(), ncols, r, +int(ncols), m_resolution);
 //			PROPAGATE_DANIELSSON_SINGLE_VSTEP3(+int(ncols), c != 0, c + 1 != ncols);
-		for (size_t c = 1; c < ncols; ++ c)
-			danielsson_hstep(r, c, -1);
-		for (int c = int(ncols) - 2; c >= 0; -- c)
-			danielsson_hstep(r, c, +1);
+		propagate_danielsson_hpass<1>(L.data() + ((r * ncols) << 1), signs.data() + r * ncols, ncols, m_resolution);
+		propagate_danielsson_hpass<-1>(L.data() + ((r * ncols) << 1), signs.data() + r * ncols, ncols, m_resolution);
 	}
 
 	// Update signed distance field from absolte vectors to the iso-surface.
-	for (size_t r = 0; r < nrows; ++ r) {
-		for (size_t c = 0; c < ncols; ++ c) {
-			size_t  addr = r * ncols + c;
-			float  *v    = &L[addr<<1];
-			float   d    = sqrt(v[0]*v[0]+v[1]*v[1]);
-			if (signs[addr] & 1)
-				d = -d;
-			m_signed_distance_field[addr] = d;
-		}
-	}
+	for (size_t r = 0; r < nrows; ++ r)
+		signed_distances_from_vectors(L.data(), signs.data(), r * ncols, ncols, m_signed_distance_field.data());
 
 #if 0
 //#ifdef SLIC3R_GUI
@@ -1080,23 +1207,23 @@ EdgeGrid::Grid::ClosestPointResult EdgeGrid::Grid::closest_point(const Point &pt
 		for (int c = bbox.min(0); c <= bbox.max(0); ++ c) {
 			const Cell &cell = m_cells[r * m_cols + c];
 			for (size_t i = cell.begin; i < cell.end; ++ i) {
-				const size_t          contour_idx = m_cell_data[i].first;
-				const Slic3r::Points &pts         = *m_contours[contour_idx];
-				size_t ipt = m_cell_data[i].second;
-				// End points of the line segment.
-				const Slic3r::Point &p1 = pts[ipt];
-				const Slic3r::Point &p2 = pts[(ipt + 1 == pts.size()) ? 0 : ipt + 1];
-				const Slic3r::Point v_seg = p2 - p1;
+				const CellSegment   &seg = m_cell_data[i];
+				// Start point of the line segment.
+				const Slic3r::Point &p1 = seg.a;
+				const Slic3r::Point &v_seg = seg.v;
 				const Slic3r::Point v_pt  = pt - p1;
 				// dot(p2-p1, pt-p1)
 				int64_t t_pt = int64_t(v_seg(0)) * int64_t(v_pt(0)) + int64_t(v_seg(1)) * int64_t(v_pt(1));
 				// l2 of seg
-				int64_t l2_seg = int64_t(v_seg(0)) * int64_t(v_seg(0)) + int64_t(v_seg(1)) * int64_t(v_seg(1));
+				int64_t l2_seg = seg.l2;
 				if (t_pt < 0) {
 					// Closest to p1.
 					double dabs = sqrt(int64_t(v_pt(0)) * int64_t(v_pt(0)) + int64_t(v_pt(1)) * int64_t(v_pt(1)));
 					if (dabs < d_min) {
 						// Previous point.
+						const size_t          contour_idx = m_cell_data[i].first;
+						const Slic3r::Points &pts         = *m_contours[contour_idx];
+						size_t ipt = m_cell_data[i].second;
 						const Slic3r::Point &p0 = pts[(ipt == 0) ? (pts.size() - 1) : ipt - 1];
 						Slic3r::Point v_seg_prev = p1 - p0;
 						int64_t t2_pt = int64_t(v_seg_prev(0)) * int64_t(v_pt(0)) + int64_t(v_seg_prev(1)) * int64_t(v_pt(1));
@@ -1126,17 +1253,17 @@ EdgeGrid::Grid::ClosestPointResult EdgeGrid::Grid::closest_point(const Point &pt
 					// Closest to the segment.
 					assert(t_pt >= 0 && t_pt <= l2_seg);
 					int64_t d_seg = int64_t(v_seg(1)) * int64_t(v_pt(0)) - int64_t(v_seg(0)) * int64_t(v_pt(1));
-					double d = double(d_seg) / sqrt(double(l2_seg));
+					double d = double(d_seg) / seg.length;
 					double dabs = std::abs(d);
 					if (dabs < d_min) {
 						d_min = dabs;
 						sign_min = (d_seg < 0) ? -1 : ((d_seg == 0) ? 0 : 1);
 						l2_seg_min = l2_seg;
-						result.contour_idx = contour_idx;
-						result.start_point_idx = ipt;
+						result.contour_idx = m_cell_data[i].first;
+						result.start_point_idx = m_cell_data[i].second;
 						result.t = t_pt;
 #ifndef NDEBUG
-						Vec2d foot = p1.cast<double>() * (1. - result.t / l2_seg_min) + p2.cast<double>() * (result.t / l2_seg_min);
+						Vec2d foot = p1.cast<double>() * (1. - result.t / l2_seg_min) + (p1 + v_seg).cast<double>() * (result.t / l2_seg_min);
 						Vec2d vfoot = foot - pt.cast<double>();
 						double dist_foot = vfoot.norm();
 						double dist_foot_err = dist_foot - d_min;
@@ -1209,22 +1336,22 @@ bool EdgeGrid::Grid::signed_distance_edges(const Point &pt, coord_t search_radiu
 		for (int c = bbox.min(0); c <= bbox.max(0); ++ c) {
 			const Cell &cell = m_cells[r * m_cols + c];
 			for (size_t i = cell.begin; i < cell.end; ++ i) {
-				const Slic3r::Points &pts = *m_contours[m_cell_data[i].first];
-				size_t ipt = m_cell_data[i].second;
-				// End points of the line segment.
-				const Slic3r::Point &p1 = pts[ipt];
-				const Slic3r::Point &p2 = pts[(ipt + 1 == pts.size()) ? 0 : ipt + 1];
-				Slic3r::Point v_seg = p2 - p1;
+				const CellSegment   &seg = m_cell_data[i];
+				// Start point of the line segment.
+				const Slic3r::Point &p1 = seg.a;
+				const Slic3r::Point &v_seg = seg.v;
 				Slic3r::Point v_pt  = pt - p1;
 				// dot(p2-p1, pt-p1)
 				int64_t t_pt = int64_t(v_seg(0)) * int64_t(v_pt(0)) + int64_t(v_seg(1)) * int64_t(v_pt(1));
 				// l2 of seg
-				int64_t l2_seg = int64_t(v_seg(0)) * int64_t(v_seg(0)) + int64_t(v_seg(1)) * int64_t(v_seg(1));
+				int64_t l2_seg = seg.l2;
 				if (t_pt < 0) {
 					// Closest to p1.
 					double dabs = sqrt(int64_t(v_pt(0)) * int64_t(v_pt(0)) + int64_t(v_pt(1)) * int64_t(v_pt(1)));
 					if (dabs < d_min) {
 						// Previous point.
+						const Slic3r::Points &pts = *m_contours[m_cell_data[i].first];
+						size_t ipt = m_cell_data[i].second;
 						const Slic3r::Point &p0 = pts[(ipt == 0) ? (pts.size() - 1) : ipt - 1];
 						Slic3r::Point v_seg_prev = p1 - p0;
 						int64_t t2_pt = int64_t(v_seg_prev(0)) * int64_t(v_pt(0)) + int64_t(v_seg_prev(1)) * int64_t(v_pt(1));
@@ -1246,7 +1373,7 @@ bool EdgeGrid::Grid::signed_distance_edges(const Point &pt, coord_t search_radiu
 					// Closest to the segment.
 					assert(t_pt >= 0 && t_pt <= l2_seg);
 					int64_t d_seg = int64_t(v_seg(1)) * int64_t(v_pt(0)) - int64_t(v_seg(0)) * int64_t(v_pt(1));
-					double d = double(d_seg) / sqrt(double(l2_seg));
+					double d = double(d_seg) / seg.length;
 					double dabs = std::abs(d);
 					if (dabs < d_min) {
 						d_min = dabs;
@@ -228,7 +228,20 @@ public:
 					return;
 	}
 
-	std::pair<std::vector<std::pair<size_t, size_t>>::const_iterator, std::vector<std::pair<size_t, size_t>>::const_iterator> cell_data_range(coord_t row, coord_t col) const
+	// Index of a contour (first) and of the start point of its line segment (second),
+	// with the line segment vector and length precalculated.
+	struct CellSegment : public std::pair<size_t, size_t> {
+		// Start point of the line segment.
+		Point 		a;
+		// Vector of the line segment.
+		Point 		v;
+		// Squared length of the line segment.
+		int64_t 	l2;
+		// Length of the line segment, sqrt(double(l2)).
+		double 		length;
+	};
+
+	std::pair<std::vector<CellSegment>::const_iterator, std::vector<CellSegment>::const_iterator> cell_data_range(coord_t row, coord_t col) const
 	{
 		const EdgeGrid::Grid::Cell &cell = m_cells[row * m_cols + col];
 		return std::make_pair(m_cell_data.begin() + cell.begin, m_cell_data.begin() + cell.end);
@@ -277,8 +290,9 @@ protected:
 	// (Polygon, ExPolygon, ExPolygonCollection etc).
 	std::vector<const Slic3r::Points*>			m_contours;
 
-	// Referencing a contour and a line segment of m_contours.
-	std::vector<std::pair<size_t, size_t> >		m_cell_data;
+	// Referencing a contour and a line segment of m_contours, with the line segment precalculated,
+	// thus the distance queries traverse a single compact array instead of dereferencing m_contours.
+	std::vector<CellSegment>					m_cell_data;
 
 	// Full grid of cells.
 	std::vector<Cell> 							m_cells;
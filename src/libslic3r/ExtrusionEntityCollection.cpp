@@ -26,10 +26,22 @@ ExtrusionEntityCollection::ExtrusionEntityCollection(const ExtrusionPaths &paths
 
 ExtrusionEntityCollection& ExtrusionEntityCollection::operator=(const ExtrusionEntityCollection &other)
 {
-    this->entities      = other.entities;
-    for (size_t i = 0; i < this->entities.size(); ++i)
-        this->entities[i] = this->entities[i]->clone();
-    this->no_sort       = other.no_sort;
+    if (this != &other) {
+        // Release the entities owned by this collection before cloning the other's.
+        this->clear();
+        this->append(other.entities);
+        this->no_sort = other.no_sort;
+    }
+    return *this;
+}
+
+ExtrusionEntityCollection& ExtrusionEntityCollection::operator=(ExtrusionEntityCollection &&other)
+{
+    if (this != &other) {
+        this->clear();
+        this->entities = std::move(other.entities);
+        this->no_sort  = other.no_sort;
+    }
     return *this;
 }
 
@@ -58,10 +70,8 @@ ExtrusionEntityCollection::operator ExtrusionPaths() const
 
 ExtrusionEntity* ExtrusionEntityCollection::clone() const
 {
-    ExtrusionEntityCollection* coll = new ExtrusionEntityCollection(*this);
-    for (size_t i = 0; i < coll->entities.size(); ++i)
-        coll->entities[i] = this->entities[i]->clone();
-    return coll;
+    // The copy constructor clones the entities.
+    return new ExtrusionEntityCollection(*this);
 }
 
 void ExtrusionEntityCollection::reverse()
@@ -86,7 +96,7 @@ void ExtrusionEntityCollection::remove(size_t i)
     this->entities.erase(this->entities.begin() + i);
 }
 
-ExtrusionEntityCollection ExtrusionEntityCollection::chained_path_from(const ExtrusionEntitiesPtr& extrusion_entities, const Point &start_near, ExtrusionRole role)
+ExtrusionEntityCollection ExtrusionEntityCollection::chained_path_from(const ExtrusionEntitiesPtr& extrusion_entities, const Point &start_near, ExtrusionRole role, bool fast_chaining)
 {
 	// Return a filtered copy of the collection.
     ExtrusionEntityCollection out;
@@ -94,7 +104,7 @@ ExtrusionEntityCollection ExtrusionEntityCollection::chained_path_from(const Ext
 	// Clone the extrusion entities.
 	for (auto &ptr : out.entities)
 		ptr = ptr->clone();
-	chain_and_reorder_extrusion_entities(out.entities, &start_near);
+	chain_and_reorder_extrusion_entities(out.entities, &start_near, chaining_mode(fast_chaining, out.entities.size()));
     return out;
 }
 
@@ -8,10 +8,13 @@
 #include "../Print.hpp"
 #include "../PrintConfig.hpp"
 #include "../Surface.hpp"
+#include "../Trace.hpp"
 
 #include "FillBase.hpp"
 #include "FillRectilinear2.hpp"
 
+#include <tbb/parallel_for.h>
+
 namespace Slic3r {
 
 struct SurfaceFillParams
@@ -317,6 +320,78 @@ void export_group_fills_to_svg(const char *path, const std::vector<SurfaceFill>
 }
 #endif
 
+// Generate the extrusions of a single SurfaceFill of a layer. Thread safe, the SurfaceFill is consumed.
+static ExtrusionEntitiesPtr fill_surface_fill(const Layer &layer, SurfaceFill &surface_fill, const BoundingBox &bbox)
+{
+    ExtrusionEntitiesPtr out;
+    // Create the filler object.
+    std::unique_ptr<Fill> f = std::unique_ptr<Fill>(Fill::new_from_type(surface_fill.params.pattern));
+    f->set_bounding_box(bbox);
+    f->layer_id = layer.id();
+    f->z 		= layer.print_z;
+    f->angle 	= surface_fill.params.angle;
+
+    // calculate flow spacing for infill pattern generation
+    bool using_internal_flow = ! surface_fill.surface.is_solid() && ! surface_fill.params.flow.bridge;
+    double link_max_length = 0.;
+    if (! surface_fill.params.flow.bridge) {
+#if 0
+        link_max_length = layerm.region()->config().get_abs_value(surface.is_external() ? "external_fill_link_max_length" : "fill_link_max_length", flow.spacing());
+//            printf("flow spacing: %f,  is_external: %d, link_max_length: %lf\n", flow.spacing(), int(surface.is_external()), link_max_length);
+#else
+        if (surface_fill.params.density > 80.) // 80%
+            link_max_length = 3. * f->spacing;
+#endif
+    }
+
+    // Maximum length of the perimeter segment linking two infill lines.
+    f->link_max_length = (coord_t)scale_(link_max_length);
+    // Used by the concentric infill pattern to clip the loops to create extrusion paths.
+    f->loop_clipping = coord_t(scale_(surface_fill.params.flow.nozzle_diameter) * LOOP_CLIPPING_LENGTH_OVER_NOZZLE_DIAMETER);
+    f->fast_chaining = layer.object()->print()->config().fast_extrusion_ordering.value;
+
+    // apply half spacing using this flow's own spacing and generate infill
+    FillParams params;
+    params.density 		= float(0.01 * surface_fill.params.density);
+    params.dont_adjust 	= surface_fill.params.dont_adjust; // false
+
+    for (ExPolygon &expoly : surface_fill.expolygons) {
+        // Spacing is modified by the filler to indicate adjustments. Reset it for each expolygon.
+        f->spacing = surface_fill.params.spacing;
+        surface_fill.surface.expolygon = std::move(expoly);
+        Polylines polylines;
+        try {
+            polylines = f->fill_surface(&surface_fill.surface, params);
+        } catch (InfillFailedException &) {
+        }
+        if (! polylines.empty()) {
+            // calculate actual flow from spacing (which might have been adjusted by the infill
+            // pattern generator)
+            double flow_mm3_per_mm = surface_fill.params.flow.mm3_per_mm();
+            double flow_width      = surface_fill.params.flow.width;
+            if (using_internal_flow) {
+                // if we used the internal flow we're not doing a solid infill
+                // so we can safely ignore the slight variation that might have
+                // been applied to f->spacing
+            } else {
+                Flow new_flow = Flow::new_from_spacing(float(f->spacing), surface_fill.params.flow.nozzle_diameter, surface_fill.params.flow.height, surface_fill.params.flow.bridge);
+                flow_mm3_per_mm = new_flow.mm3_per_mm();
+                flow_width      = new_flow.width;
+            }
+            // Save into the output, make_fills() stores it into the layer region.
+            ExtrusionEntityCollection* eec = nullptr;
+            out.push_back(eec = new ExtrusionEntityCollection());
+            // Only concentric fills are not sorted.
+            eec->no_sort = f->no_sort();
+            extrusion_entities_append_paths(
+                eec->entities, std::move(polylines),
+                surface_fill.params.extrusion_role,
+                flow_mm3_per_mm, float(flow_width), surface_fill.params.flow.height);
+        }
+    }
+    return out;
+}
+
 // friend to Layer
 void Layer::make_fills()
 {
@@ -338,72 +413,19 @@ void Layer::make_fills()
 	}
 #endif /* SLIC3R_DEBUG_SLICE_PROCESSING */
 
-    for (SurfaceFill &surface_fill : surface_fills) {
-        // Create the filler object.
-        std::unique_ptr<Fill> f = std::unique_ptr<Fill>(Fill::new_from_type(surface_fill.params.pattern));
-        f->set_bounding_box(bbox);
-        f->layer_id = this->id();
-        f->z 		= this->print_z;
-        f->angle 	= surface_fill.params.angle;
-
-        // calculate flow spacing for infill pattern generation
-        bool using_internal_flow = ! surface_fill.surface.is_solid() && ! surface_fill.params.flow.bridge;
-        double link_max_length = 0.;
-        if (! surface_fill.params.flow.bridge) {
-#if 0
-            link_max_length = layerm.region()->config().get_abs_value(surface.is_external() ? "external_fill_link_max_length" : "fill_link_max_length", flow.spacing());
-//            printf("flow spacing: %f,  is_external: %d, link_max_length: %lf\n", flow.spacing(), int(surface.is_external()), link_max_length);
-#else
-            if (surface_fill.params.density > 80.) // 80%
-                link_max_length = 3. * f->spacing;
-#endif
-        }
-
-        // Maximum length of the perimeter segment linking two infill lines.
-        f->link_max_length = (coord_t)scale_(link_max_length);
-        // Used by the concentric infill pattern to clip the loops to create extrusion paths.
-        f->loop_clipping = coord_t(scale_(surface_fill.params.flow.nozzle_diameter) * LOOP_CLIPPING_LENGTH_OVER_NOZZLE_DIAMETER);
-
-        // apply half spacing using this flow's own spacing and generate infill
-        FillParams params;
-        params.density 		= float(0.01 * surface_fill.params.density);
-        params.dont_adjust 	= surface_fill.params.dont_adjust; // false
-
-        for (ExPolygon &expoly : surface_fill.expolygons) {
-			// Spacing is modified by the filler to indicate adjustments. Reset it for each expolygon.
-			f->spacing = surface_fill.params.spacing;
-			surface_fill.surface.expolygon = std::move(expoly);
-			Polylines polylines;
-			try {
-				polylines = f->fill_surface(&surface_fill.surface, params);
-			} catch (InfillFailedException &) {
-			}
-	        if (! polylines.empty()) {
-		        // calculate actual flow from spacing (which might have been adjusted by the infill
-		        // pattern generator)
-		        double flow_mm3_per_mm = surface_fill.params.flow.mm3_per_mm();
-		        double flow_width      = surface_fill.params.flow.width;
-		        if (using_internal_flow) {
-		            // if we used the internal flow we're not doing a solid infill
-		            // so we can safely ignore the slight variation that might have
-		            // been applied to f->spacing
-		        } else {
-		            Flow new_flow = Flow::new_from_spacing(float(f->spacing), surface_fill.params.flow.nozzle_diameter, surface_fill.params.flow.height, surface_fill.params.flow.bridge);
-		        	flow_mm3_per_mm = new_flow.mm3_per_mm();
-		        	flow_width      = new_flow.width;
-		        }
-		        // Save into layer.
-				ExtrusionEntityCollection* eec = nullptr;
-		        m_regions[surface_fill.region_id]->fills.entities.push_back(eec = new ExtrusionEntityCollection());
-		        // Only concentric fills are not sorted.
-		        eec->no_sort = f->no_sort();
-		        extrusion_entities_append_paths(
-		            eec->entities, std::move(polylines),
-		            surface_fill.params.extrusion_role,
-		            flow_mm3_per_mm, float(flow_width), surface_fill.params.flow.height);
-		    }
-		}
-    }
+    // The SurfaceFills are independent, they are filled in parallel, as there may be just a few layers of a short object
+    // with many regions. The extrusions are then stored into the layer regions in the order of surface_fills.
+    std::vector<ExtrusionEntitiesPtr> fills(surface_fills.size());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, surface_fills.size(), 1),
+        [this, &surface_fills, &fills, &bbox](const tbb::blocked_range<size_t> &range) {
+            for (size_t surface_fill_idx = range.begin(); surface_fill_idx < range.end(); ++ surface_fill_idx) {
+                Trace::Scope trace("Layer::fill_surface", "region", surface_fills[surface_fill_idx].region_id);
+                fills[surface_fill_idx] = fill_surface_fill(*this, surface_fills[surface_fill_idx], bbox);
+            }
+        });
+    for (size_t surface_fill_idx = 0; surface_fill_idx < surface_fills.size(); ++ surface_fill_idx)
+        append(m_regions[surface_fills[surface_fill_idx].region_id]->fills.entities, std::move(fills[surface_fill_idx]));
 
     // add thin fill regions
     // Unpacks the collection, creates multiple collections per path.
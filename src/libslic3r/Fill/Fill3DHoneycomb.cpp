@@ -162,7 +162,8 @@ void Fill3DHoneycomb::_fill_surface_single(
 		pl.translate(bb.min);
 
     // clip pattern to boundaries, chain the clipped polylines
-    Polylines polylines_chained = chain_polylines(intersection_pl(polylines, to_polygons(expolygon)));
+    polylines = intersection_pl(polylines, to_polygons(expolygon));
+    Polylines polylines_chained = chain_polylines(std::move(polylines), nullptr, chaining_mode(this->fast_chaining, polylines.size()));
 
     // connect lines if needed
     if (! polylines_chained.empty()) {
@@ -66,6 +66,8 @@ public:
     coord_t     link_max_length;
     // In scaled coordinates. Used by the concentric infill pattern to clip the loops to create extrusion paths.
     coord_t     loop_clipping;
+    // Chain the lines of large fills by ChainingMode::Fast, see chaining_mode().
+    bool        fast_chaining;
     // In scaled coordinates. Bounding box of the 2D projection of the object.
     BoundingBox bounding_box;
 
@@ -98,6 +100,7 @@ protected:
         angle(FLT_MAX),
         link_max_length(0),
         loop_clipping(0),
+        fast_chaining(false),
         // The initial bounding box is empty, therefore undefined.
         bounding_box(Point(0, 0), Point(-1, -1))
         {}
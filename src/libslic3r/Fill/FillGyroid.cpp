@@ -190,7 +190,7 @@ void FillGyroid::_fill_surface_single(
 			polylines.end());
 
 	if (! polylines.empty()) {
-		polylines = chain_polylines(polylines);
+		polylines = chain_polylines(std::move(polylines), nullptr, chaining_mode(this->fast_chaining, polylines.size()));
 		// connect lines
 		size_t polylines_out_first_idx = polylines_out.size();
 		if (params.dont_connect)
@@ -93,7 +93,7 @@ void FillRectilinear::_fill_surface_single(
             }
         }
         bool first = true;
-        for (Polyline &polyline : chain_polylines(std::move(polylines))) {
+        for (Polyline &polyline : chain_polylines(std::move(polylines), nullptr, chaining_mode(this->fast_chaining, polylines.size()))) {
             if (! first) {
                 // Try to connect the lines.
                 Points &pts_end = polylines_out.back().points;
@@ -8,6 +8,7 @@
 #include "GCode/WipeTower.hpp"
 #include "ShortestPath.hpp"
 #include "Print.hpp"
+#include "Trace.hpp"
 #include "Utils.hpp"
 #include "libslic3r.h"
 
@@ -30,6 +31,8 @@
 #include "SVG.hpp"
 
 #include <tbb/parallel_for.h>
+#include <tbb/pipeline.h>
+#include <tbb/task_arena.h>
 
 #include <Shiny/Shiny.h>
 
@@ -90,7 +93,7 @@ NEXT: ;
 
 void AvoidCrossingPerimeters::init_external_mp(const Print &print)
 { 
-	m_external_mp = Slic3r::make_unique<MotionPlanner>(union_ex(this->collect_contours_all_layers(print.objects())));
+	m_external_mp = Slic3r::make_unique<MotionPlanner>(union_parallel_ex(this->collect_contours_all_layers(print.objects())));
 }
 
 // Plan a travel move while minimizing the number of perimeter crossings.
@@ -728,7 +731,8 @@ void GCode::do_export(Print* print, const char* path, GCodePreviewData* preview_
     std::string path_tmp(path);
     path_tmp += ".tmp";
 
-    FILE *file = boost::nowide::fopen(path_tmp.c_str(), "wb");
+    // Opened for reading as well, the remaining times writer moves the G-code within the file when filling in the M73 lines.
+    FILE *file = boost::nowide::fopen(path_tmp.c_str(), "w+b");
     if (file == nullptr)
         throw std::runtime_error(std::string("G-code export to ") + path + " failed.\nCannot open the file for writing.\n");
 
@@ -765,15 +769,7 @@ void GCode::do_export(Print* print, const char* path, GCodePreviewData* preview_
         throw std::runtime_error(msg);
     }
 
-    GCodeTimeEstimator::PostProcessData normal_data = m_normal_time_estimator.get_post_process_data();
-    GCodeTimeEstimator::PostProcessData silent_data = m_silent_time_estimator.get_post_process_data();
-
-    bool remaining_times_enabled = print->config().remaining_times.value;
-
-    BOOST_LOG_TRIVIAL(debug) << "Time estimator post processing" << log_memory_info();
-    GCodeTimeEstimator::post_process(path_tmp, 60.0f, remaining_times_enabled ? &normal_data : nullptr, (remaining_times_enabled && m_silent_time_estimator_enabled) ? &silent_data : nullptr);
-
-    if (remaining_times_enabled)
+    if (print->config().remaining_times.value)
     {
         m_normal_time_estimator.reset();
         if (m_silent_time_estimator_enabled)
@@ -1132,6 +1128,11 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
     	// modifies the following:
     	m_normal_time_estimator, m_silent_time_estimator, m_silent_time_estimator_enabled);
     DoExport::init_gcode_analyzer(print.config(), m_analyzer);
+    m_gcode_reader.set_extrusion_axis(print.config().get_extrusion_axis()[0]);
+    // The M73 lines with the remaining times are inserted while the G-code is being written.
+    m_remaining_times_writer = make_unique<GCodeTimeEstimator::RemainingTimesWriter>(60.0f,
+        print.config().remaining_times.value ? &m_normal_time_estimator : nullptr,
+        (print.config().remaining_times.value && m_silent_time_estimator_enabled) ? &m_silent_time_estimator : nullptr);
 
     // resets analyzer's tracking data
     m_last_mm3_per_mm = GCodeAnalyzer::Default_mm3_per_mm;
@@ -1174,7 +1175,6 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
     m_volumetric_speed = DoExport::autospeed_volumetric_limit(print);
     print.throw_if_canceled();
 
-    m_cooling_buffer = make_unique<CoolingBuffer>(*this);
     if (print.config().spiral_vase.value)
         m_spiral_vase = make_unique<SpiralVase>(print.config());
 #ifdef HAS_PRESSURE_EQUALIZER
@@ -1288,6 +1288,8 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
     }
     print.throw_if_canceled();
 
+    // The CoolingBuffer takes a snapshot of the extruders, thus it is created once the extruders are set.
+    m_cooling_buffer = make_unique<CoolingBuffer>(*this);
     m_cooling_buffer->set_current_extruder(initial_extruder_id);
 
     // Emit machine envelope limits for the Marlin firmware.
@@ -1417,14 +1419,12 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
             // Reset the cooling buffer internal state (the current position, feed rate, accelerations).
             m_cooling_buffer->reset();
             m_cooling_buffer->set_current_extruder(initial_extruder_id);
+            // The extrusions of an object may only be released once its last instance has been exported.
+            bool release_extrusions = m_release_extrusions && std::none_of(print_object_instance_sequential_active + 1, print_object_instances_ordering.cend(),
+                [&object](const PrintInstance *instance) { return instance->print_object == &object; });
             // Pair the object layers with the support layers by z, extrude them.
-            std::vector<LayerToPrint> layers_to_print = collect_layers_to_print(object);
-            for (const LayerToPrint &ltp : layers_to_print) {
-                std::vector<LayerToPrint> lrs;
-                lrs.emplace_back(std::move(ltp));
-                this->process_layer(file, print, lrs, tool_ordering.tools_for_layer(ltp.print_z()), nullptr, *print_object_instance_sequential_active - object.instances().data());
-                print.throw_if_canceled();
-            }
+            this->process_layers(print, tool_ordering, collect_layers_to_print(object), *print_object_instance_sequential_active - object.instances().data(), release_extrusions, file);
+            print.throw_if_canceled();
 #ifdef HAS_PRESSURE_EQUALIZER
             if (m_pressure_equalizer)
                 _write(file, m_pressure_equalizer->process("", true));
@@ -1470,13 +1470,8 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
             print.throw_if_canceled();
         }
         // Extrude the layers.
-        for (auto &layer : layers_to_print) {
-            const LayerTools &layer_tools = tool_ordering.tools_for_layer(layer.first);
-            if (m_wipe_tower && layer_tools.has_wipe_tower)
-                m_wipe_tower->next_layer();
-            this->process_layer(file, print, layer.second, layer_tools, &print_object_instances_ordering, size_t(-1));
-            print.throw_if_canceled();
-        }
+        this->process_layers(print, tool_ordering, print_object_instances_ordering, layers_to_print, file);
+        print.throw_if_canceled();
 #ifdef HAS_PRESSURE_EQUALIZER
         if (m_pressure_equalizer)
             _write(file, m_pressure_equalizer->process("", true));
@@ -1556,6 +1551,9 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
         if (!full_config.empty())
             _write(file, full_config);
     }
+    // Write the rest of the G-code and fill in the M73 lines now, as the print time is known.
+    m_remaining_times_writer->finalize(file);
+    m_remaining_times_writer.reset();
     print.throw_if_canceled();
 }
 
@@ -1633,28 +1631,36 @@ static bool custom_gcode_sets_temperature(const std::string &gcode, const int mc
 void GCode::print_machine_envelope(FILE *file, Print &print)
 {
     if (print.config().gcode_flavor.value == gcfMarlin) {
-        fprintf(file, "M201 X%d Y%d Z%d E%d ; sets maximum accelerations, mm/sec^2\n",
+        char buf[256];
+        std::string gcode;
+        sprintf(buf, "M201 X%d Y%d Z%d E%d ; sets maximum accelerations, mm/sec^2\n",
             int(print.config().machine_max_acceleration_x.values.front() + 0.5),
             int(print.config().machine_max_acceleration_y.values.front() + 0.5),
             int(print.config().machine_max_acceleration_z.values.front() + 0.5),
             int(print.config().machine_max_acceleration_e.values.front() + 0.5));
-        fprintf(file, "M203 X%d Y%d Z%d E%d ; sets maximum feedrates, mm/sec\n",
+        gcode += buf;
+        sprintf(buf, "M203 X%d Y%d Z%d E%d ; sets maximum feedrates, mm/sec\n",
             int(print.config().machine_max_feedrate_x.values.front() + 0.5),
             int(print.config().machine_max_feedrate_y.values.front() + 0.5),
             int(print.config().machine_max_feedrate_z.values.front() + 0.5),
             int(print.config().machine_max_feedrate_e.values.front() + 0.5));
-        fprintf(file, "M204 P%d R%d T%d ; sets acceleration (P, T) and retract acceleration (R), mm/sec^2\n",
+        gcode += buf;
+        sprintf(buf, "M204 P%d R%d T%d ; sets acceleration (P, T) and retract acceleration (R), mm/sec^2\n",
             int(print.config().machine_max_acceleration_extruding.values.front() + 0.5),
             int(print.config().machine_max_acceleration_retracting.values.front() + 0.5),
             int(print.config().machine_max_acceleration_extruding.values.front() + 0.5));
-        fprintf(file, "M205 X%.2lf Y%.2lf Z%.2lf E%.2lf ; sets the jerk limits, mm/sec\n",
+        gcode += buf;
+        sprintf(buf, "M205 X%.2lf Y%.2lf Z%.2lf E%.2lf ; sets the jerk limits, mm/sec\n",
             print.config().machine_max_jerk_x.values.front(),
             print.config().machine_max_jerk_y.values.front(),
             print.config().machine_max_jerk_z.values.front(),
             print.config().machine_max_jerk_e.values.front());
-        fprintf(file, "M205 S%d T%d ; sets the minimum extruding and travel feed rate, mm/sec\n",
+        gcode += buf;
+        sprintf(buf, "M205 S%d T%d ; sets the minimum extruding and travel feed rate, mm/sec\n",
             int(print.config().machine_min_extruding_rate.values.front() + 0.5),
             int(print.config().machine_min_travel_rate.values.front() + 0.5));
+        gcode += buf;
+        m_remaining_times_writer->write(file, gcode.c_str());
     }
 }
 
@@ -1936,13 +1942,12 @@ namespace Skirt {
 // In non-sequential mode, process_layer is called per each print_z height with all object and support layers accumulated.
 // For multi-material prints, this routine minimizes extruder switches by gathering extruder specific extrusion paths
 // and performing the extruder specific extrusions together.
-void GCode::process_layer(
-    // Write into the output file.
-    FILE                            		*file,
+GCode::LayerResult GCode::process_layer(
     const Print                    			&print,
     // Set of object & print layers of the same PrintObject and with the same print_z.
     const std::vector<LayerToPrint> 		&layers,
     const LayerTools        		        &layer_tools,
+    const LayersSeamCandidates              &seam_candidates,
 	// Pairs of PrintObject index and its instance index.
 	const std::vector<const PrintInstance*> *ordering,
     // If set to size_t(-1), then print all copies of all objects.
@@ -1955,7 +1960,7 @@ void GCode::process_layer(
 
     if (layer_tools.extruders.empty())
         // Nothing to extrude.
-        return;
+        return {};
 
     // Extract 1st object_layer and support_layer of this set of layers with an equal print_z.
     const Layer         *object_layer  = nullptr;
@@ -1971,6 +1976,8 @@ void GCode::process_layer(
     bool                 first_layer   = layer.id() == 0;
     unsigned int         first_extruder_id = layer_tools.extruders.front();
 
+    Trace::Scope trace("GCode::process_layer", "layer", layer.id());
+
     // Initialize config with the 1st object to be printed at this layer.
     m_config.apply(layer.object()->config(), true);
 
@@ -1987,12 +1994,16 @@ void GCode::process_layer(
                     break;
                 }
         }
-        m_spiral_vase->enable = enable;
+        m_spiral_vase_enable = enable;
     }
     // If we're going to apply spiralvase to this layer, disable loop clipping
-    m_enable_loop_clipping = ! m_spiral_vase || ! m_spiral_vase->enable;
+    m_enable_loop_clipping = ! m_spiral_vase || ! m_spiral_vase_enable;
     
-    std::string gcode;
+    LayerResult result;
+    result.layer_id           = layer.id();
+    result.print_z            = print_z;
+    result.spiral_vase_enable = m_spiral_vase_enable;
+    std::string &gcode        = result.gcode;
 
     // Set new layer - this will change Z and force a retraction if retract_layer_change is enabled.
     if (! print.config().before_layer_gcode.value.empty()) {
@@ -2200,7 +2211,7 @@ void GCode::process_layer(
     } // for objects
 
     // Extrude the skirt, brim, support, perimeters, infill ordered by the extruders.
-    std::vector<std::unique_ptr<EdgeGrid::Grid>> lower_layer_edge_grids(layers.size());
+    assert(seam_candidates.size() == layers.size());
     for (unsigned int extruder_id : layer_tools.extruders)
     {
         gcode += (layer_tools.has_wipe_tower && m_wipe_tower) ?
@@ -2279,7 +2290,8 @@ void GCode::process_layer(
                     m_layer = layers[instance_to_print.layer_id].support_layer;
                     gcode += this->extrude_support(
                         // support_extrusion_role is erSupportMaterial, erSupportMaterialInterface or erMixed for all extrusion paths.
-                        instance_to_print.object_by_extruder.support->chained_path_from(m_last_pos, instance_to_print.object_by_extruder.support_extrusion_role));
+                        instance_to_print.object_by_extruder.support->chained_path_from(m_last_pos, instance_to_print.object_by_extruder.support_extrusion_role,
+                            m_config.fast_extrusion_ordering.value));
                     m_layer = layers[instance_to_print.layer_id].layer();
                 }
                 for (ObjectByExtruder::Island &island : instance_to_print.object_by_extruder.islands) {
@@ -2287,9 +2299,9 @@ void GCode::process_layer(
                 	//FIXME the following code prints regions in the order they are defined, the path is not optimized in any way.
                     if (print.config().infill_first) {
                         gcode += this->extrude_infill(print, by_region_specific, false);
-                        gcode += this->extrude_perimeters(print, by_region_specific, lower_layer_edge_grids[instance_to_print.layer_id]);
+                        gcode += this->extrude_perimeters(print, by_region_specific, seam_candidates[instance_to_print.layer_id].get());
                     } else {
-                        gcode += this->extrude_perimeters(print, by_region_specific, lower_layer_edge_grids[instance_to_print.layer_id]);
+                        gcode += this->extrude_perimeters(print, by_region_specific, seam_candidates[instance_to_print.layer_id].get());
                         gcode += this->extrude_infill(print,by_region_specific, false);
                     }
                     // ironing
@@ -2301,39 +2313,158 @@ void GCode::process_layer(
         }
     }
 
-    // Apply spiral vase post-processing if this layer contains suitable geometry
-    // (we must feed all the G-code into the post-processor, including the first 
-    // bottom non-spiral layers otherwise it will mess with positions)
-    // we apply spiral vase at this stage because it requires a full layer.
-    // Just a reminder: A spiral vase mode is allowed for a single object per layer, single material print only.
-    if (m_spiral_vase)
-        gcode = m_spiral_vase->process_layer(gcode);
+    return result;
+}
 
-    // Apply cooling logic; this may alter speeds.
-    if (m_cooling_buffer)
-        gcode = m_cooling_buffer->process_layer(gcode, layer.id());
+// Release the extrusions of a layer, which has been exported already, see GCode::set_release_extrusions().
+// The lslices of the layer are kept, they are used by the G-code generator when processing the layer above,
+// while the lslices of the layer below are no longer needed.
+static void release_layer_extrusions(const GCode::LayerToPrint &layer_to_print)
+{
+    // The layers are only accessed as const by the G-code generator, but they are not shared
+    // with any other thread while being exported.
+    auto release = [](ExtrusionEntityCollection &extrusions) { extrusions.clear(); extrusions.entities.shrink_to_fit(); };
+    if (layer_to_print.object_layer != nullptr) {
+        for (LayerRegion *layerm : layer_to_print.object_layer->regions()) {
+            release(layerm->perimeters);
+            release(layerm->thin_fills);
+            release(layerm->fills);
+        }
+        if (Layer *lower_layer = layer_to_print.object_layer->lower_layer) {
+            lower_layer->lslices.clear();
+            lower_layer->lslices.shrink_to_fit();
+            lower_layer->lslices_bboxes.clear();
+            lower_layer->lslices_bboxes.shrink_to_fit();
+        }
+    }
+    if (layer_to_print.support_layer != nullptr)
+        release(const_cast<SupportLayer*>(layer_to_print.support_layer)->support_fills);
+}
+
+void GCode::process_layers(
+    const Print                                                         &print,
+    const ToolOrdering                                                  &tool_ordering,
+    const std::vector<const PrintInstance*>                             &print_object_instances_ordering,
+    const std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>>   &layers_to_print,
+    FILE                                                                *file)
+{
+    this->run_layers_pipeline(layers_to_print.size(),
+        [&layers_to_print](size_t layer_idx) { return make_seam_candidates(layers_to_print[layer_idx].second); },
+        [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print](size_t layer_idx, const LayersSeamCandidates &seam_candidates) {
+            const std::pair<coordf_t, std::vector<LayerToPrint>> &layer = layers_to_print[layer_idx];
+            const LayerTools &layer_tools = tool_ordering.tools_for_layer(layer.first);
+            if (m_wipe_tower && layer_tools.has_wipe_tower)
+                m_wipe_tower->next_layer();
+            print.throw_if_canceled();
+            LayerResult result = this->process_layer(print, layer.second, layer_tools, seam_candidates, &print_object_instances_ordering, size_t(-1));
+            if (m_release_extrusions)
+                for (const LayerToPrint &layer_to_print : layer.second)
+                    release_layer_extrusions(layer_to_print);
+            return result;
+        }, file);
+}
 
-    // add tag for analyzer
-    if (gcode.find(GCodeAnalyzer::Pause_Print_Tag) != gcode.npos)
-        gcode += "\n; " + GCodeAnalyzer::End_Pause_Print_Or_Custom_Code_Tag + "\n";
-    else if (gcode.find(GCodeAnalyzer::Custom_Code_Tag) != gcode.npos)
-        gcode += "\n; " + GCodeAnalyzer::End_Pause_Print_Or_Custom_Code_Tag + "\n";
+void GCode::process_layers(
+    const Print                                                         &print,
+    const ToolOrdering                                                  &tool_ordering,
+    const std::vector<LayerToPrint>                                     &layers_to_print,
+    const size_t                                                         single_object_idx,
+    bool                                                                 release_extrusions,
+    FILE                                                                *file)
+{
+    this->run_layers_pipeline(layers_to_print.size(),
+        [&layers_to_print](size_t layer_idx) { return make_seam_candidates({ layers_to_print[layer_idx] }); },
+        [this, &print, &tool_ordering, &layers_to_print, single_object_idx, release_extrusions](size_t layer_idx, const LayersSeamCandidates &seam_candidates) {
+            const LayerToPrint &layer = layers_to_print[layer_idx];
+            print.throw_if_canceled();
+            LayerResult result = this->process_layer(print, { layer }, tool_ordering.tools_for_layer(layer.print_z()), seam_candidates, nullptr, single_object_idx);
+            if (release_extrusions)
+                release_layer_extrusions(layer);
+            return result;
+        }, file);
+}
 
+void GCode::run_layers_pipeline(
+    size_t                                                                 num_layers,
+    const std::function<LayersSeamCandidates(size_t)>                     &prepare_layer,
+    const std::function<LayerResult(size_t, const LayersSeamCandidates&)> &generate_layer,
+    FILE                                                                  *file)
+{
+    // The G-code generator, the SpiralVase, the CoolingBuffer, the PressureEqualizer and the G-code analyzer
+    // and time estimators called by _write() carry their state from one layer to the next, therefore each
+    // of them processes the layers serially and in order. The stages overlap though: While the layer N is being
+    // written, the layer N+1 is being cooled and the layer N+2 is being generated.
+    // The stages pass the G-code down the pipeline in LayerResult. The CoolingBuffer works with its own copy of the print config
+    // and of the extruder IDs and it tracks the fan speed on its own, thus it does not access this GCode or the GCodeWriter.
+    // Only the stateless preparation of the layers, namely the overhang penalties of the seam candidates, runs in parallel
+    // ahead of the generator. The number of layers in flight limits the memory consumed by the prepared layers.
+    using PreparedLayer = std::pair<size_t, LayersSeamCandidates>;
+    size_t layer_idx = 0;
+    const auto input = tbb::make_filter<void, size_t>(tbb::filter::serial_in_order,
+        [num_layers, &layer_idx](tbb::flow_control &fc) -> size_t {
+            if (layer_idx == num_layers) {
+                fc.stop();
+                return 0;
+            }
+            return layer_idx ++;
+        });
+    const auto prepare = tbb::make_filter<size_t, PreparedLayer>(tbb::filter::parallel,
+        [&prepare_layer](size_t idx) -> PreparedLayer { return { idx, prepare_layer(idx) }; });
+    const auto generator = tbb::make_filter<PreparedLayer, LayerResult>(tbb::filter::serial_in_order,
+        [&generate_layer](const PreparedLayer &in) -> LayerResult { return generate_layer(in.first, in.second); });
+    const auto spiral_vase = tbb::make_filter<LayerResult, LayerResult>(tbb::filter::serial_in_order,
+        [this](LayerResult in) -> LayerResult {
+            // Apply spiral vase post-processing if this layer contains suitable geometry
+            // (we must feed all the G-code into the post-processor, including the first 
+            // bottom non-spiral layers otherwise it will mess with positions)
+            // we apply spiral vase at this stage because it requires a full layer.
+            // Just a reminder: A spiral vase mode is allowed for a single object per layer, single material print only.
+            if (m_spiral_vase && in.layer_id != size_t(-1)) {
+                m_spiral_vase->enable = in.spiral_vase_enable;
+                in.gcode = m_spiral_vase->process_layer(in.gcode);
+            }
+            return in;
+        });
+    const auto cooling = tbb::make_filter<LayerResult, LayerResult>(tbb::filter::serial_in_order,
+        [this](LayerResult in) -> LayerResult {
+            if (in.layer_id == size_t(-1))
+                // Nothing was extruded at this layer.
+                return in;
+            Trace::Scope trace("GCode::cooling", "layer", in.layer_id);
+            // Apply cooling logic; this may alter speeds.
+            if (m_cooling_buffer)
+                in.gcode = m_cooling_buffer->process_layer(in.gcode, in.layer_id);
+            // add tag for analyzer
+            if (in.gcode.find(GCodeAnalyzer::Pause_Print_Tag) != in.gcode.npos)
+                in.gcode += "\n; " + GCodeAnalyzer::End_Pause_Print_Or_Custom_Code_Tag + "\n";
+            else if (in.gcode.find(GCodeAnalyzer::Custom_Code_Tag) != in.gcode.npos)
+                in.gcode += "\n; " + GCodeAnalyzer::End_Pause_Print_Or_Custom_Code_Tag + "\n";
 #ifdef HAS_PRESSURE_EQUALIZER
-    // Apply pressure equalization if enabled;
-    // printf("G-code before filter:\n%s\n", gcode.c_str());
-    if (m_pressure_equalizer)
-        gcode = m_pressure_equalizer->process(gcode.c_str(), false);
-    // printf("G-code after filter:\n%s\n", out.c_str());
+            // Apply pressure equalization if enabled;
+            if (m_pressure_equalizer)
+                in.gcode = m_pressure_equalizer->process(in.gcode.c_str(), false);
 #endif /* HAS_PRESSURE_EQUALIZER */
-    
-    _write(file, gcode);
-    BOOST_LOG_TRIVIAL(trace) << "Exported layer " << layer.id() << " print_z " << print_z << 
-        ", time estimator memory: " <<
-            format_memsize_MB(m_normal_time_estimator.memory_used() + (m_silent_time_estimator_enabled ? m_silent_time_estimator.memory_used() : 0)) <<
-        ", analyzer memory: " <<
-            format_memsize_MB(m_analyzer.memory_used()) <<
-        log_memory_info();
+            return in;
+        });
+    const auto output = tbb::make_filter<LayerResult, void>(tbb::filter::serial_in_order,
+        [this, file](const LayerResult &in) {
+            if (in.layer_id == size_t(-1))
+                return;
+            Trace::Scope trace("GCode::write", "layer", in.layer_id);
+            _write(file, in.gcode);
+            BOOST_LOG_TRIVIAL(trace) << "Exported layer " << in.layer_id << " print_z " << in.print_z << 
+                ", time estimator memory: " <<
+                    format_memsize_MB(m_normal_time_estimator.memory_used() + (m_silent_time_estimator_enabled ? m_silent_time_estimator.memory_used() : 0)) <<
+                ", analyzer memory: " <<
+                    format_memsize_MB(m_analyzer.memory_used()) <<
+                log_memory_info();
+        });
+    // Besides the layers being prepared in parallel, a serial stage cannot process two layers at once anyway.
+    tbb::parallel_pipeline(std::max<size_t>(4, 2 * size_t(tbb::this_task_arena::max_concurrency())),
+        input & prepare & generator & spiral_vase & cooling & output);
+    // The fan is switched off at the end of the print if the CoolingBuffer left it running.
+    if (m_cooling_buffer)
+        m_writer.set_last_fan_speed(m_cooling_buffer->fan_speed());
 }
 
 void GCode::apply_print_config(const PrintConfig &print_config)
@@ -2464,6 +2595,27 @@ plot(p2.subs(r,0.2).subs(z,1.), (x, -1, 3), adaptive=False, nb_of_points=400)
     }
 }
 
+// Penalty for a seam at an overhang, evaluated over the distance field over the layer below.
+static float seam_overhang_penalty(const EdgeGrid::Grid &lower_layer_edge_grid, const Point &p, coordf_t nozzle_dmr)
+{
+    const float   penaltyOverhangHalf = 10.f;
+    const coord_t nozzle_r = coord_t(floor(scale_(0.5 * nozzle_dmr) + 0.5));
+    const coord_t search_r = coord_t(floor(scale_(0.8 * nozzle_dmr) + 0.5));
+    coordf_t dist;
+    // Signed distance is positive outside the object, negative inside the object.
+    // The point is considered at an overhang, if it is more than nozzle radius
+    // outside of the lower layer contour.
+    #ifdef NDEBUG // to suppress unused variable warning in release mode
+        lower_layer_edge_grid.signed_distance(p, search_r, dist);
+    #else
+        bool found = lower_layer_edge_grid.signed_distance(p, search_r, dist);
+    #endif
+    // If the approximate Signed Distance Field was initialized over lower_layer_edge_grid,
+    // then the signed distnace shall always be known.
+    assert(found); 
+    return extrudate_overlap_penalty(float(nozzle_r), penaltyOverhangHalf, float(dist));
+}
+
 static Points::iterator project_point_to_polygon_and_insert(Polygon &polygon, const Point &pt, double eps)
 {
     assert(polygon.points.size() >= 2);
@@ -2589,32 +2741,67 @@ std::vector<float> polygon_angles_at_vertices(const Polygon &polygon, const std:
     return angles;
 }
 
-std::string GCode::extrude_loop(ExtrusionLoop loop, std::string description, double speed, std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid)
+GCode::LayersSeamCandidates GCode::make_seam_candidates(const std::vector<LayerToPrint> &layers)
+{
+    LayersSeamCandidates out(layers.size());
+    for (size_t i = 0; i < layers.size(); ++ i) {
+        const Layer *layer = layers[i].object_layer;
+        if (layer == nullptr || layer->lower_layer == nullptr ||
+            std::all_of(layer->regions().begin(), layer->regions().end(), [](const LayerRegion *layerm) { return layerm->perimeters.empty(); }))
+            continue;
+        Trace::Scope trace("GCode::make_seam_candidates", "layer", layer->id());
+        auto seam_candidates = std::make_shared<SeamCandidates>();
+        // Create the distance field for a layer below.
+        const coord_t distance_field_resolution = coord_t(scale_(1.) + 0.5);
+        EdgeGrid::Grid &grid = seam_candidates->lower_layer_edge_grid;
+        grid.create(layer->lower_layer->lslices, distance_field_resolution);
+        grid.calculate_sdf();
+        #if 0
+        {
+            static int iRun = 0;
+            BoundingBox bbox = grid.bbox();
+            bbox.min(0) -= scale_(5.f);
+            bbox.min(1) -= scale_(5.f);
+            bbox.max(0) += scale_(5.f);
+            bbox.max(1) += scale_(5.f);
+            EdgeGrid::save_png(grid, bbox, scale_(0.1f), debug_out_path("GCode_extrude_loop_edge_grid-%d.png", iRun++));
+        }
+        #endif
+        // Evaluate the overhang penalties of the loops, for which extrude_loop() searches for the seam with the lowest penalty.
+        const PrintConfig &print_config = layer->object()->print()->config();
+        if (! print_config.spiral_vase && layer->object()->config().seam_position != spRandom)
+            for (const LayerRegion *layerm : layer->regions()) {
+                const PrintRegionConfig &region_config = layerm->region()->config();
+                const coordf_t nozzle_dmr = print_config.nozzle_diameter.get_at(region_config.perimeter_extruder.value - 1);
+                std::function<void(const ExtrusionEntityCollection&)> add_loops = [&add_loops, &seam_candidates, &grid, nozzle_dmr](const ExtrusionEntityCollection &collection) {
+                    for (const ExtrusionEntity *ee : collection.entities)
+                        if (const auto *eec = dynamic_cast<const ExtrusionEntityCollection*>(ee))
+                            add_loops(*eec);
+                        else if (const auto *loop = dynamic_cast<const ExtrusionLoop*>(ee)) {
+                            // Orient the loop the same way extrude_loop() does.
+                            ExtrusionLoop loop_ccw(*loop);
+                            loop_ccw.make_counter_clockwise();
+                            Polygon polygon = loop_ccw.polygon();
+                            SeamCandidates::Loop &loop_candidates = seam_candidates->loops[loop];
+                            loop_candidates.nozzle_dmr = nozzle_dmr;
+                            loop_candidates.overhang_penalties.reserve(polygon.points.size());
+                            for (const Point &p : polygon.points)
+                                loop_candidates.overhang_penalties.emplace_back(seam_overhang_penalty(grid, p, nozzle_dmr));
+                        }
+                };
+                add_loops(layerm->perimeters);
+            }
+        out[i] = std::move(seam_candidates);
+    }
+    return out;
+}
+
+std::string GCode::extrude_loop(const ExtrusionLoop &loop_src, std::string description, double speed, const SeamCandidates *seam_candidates)
 {
     // get a copy; don't modify the orientation of the original loop object otherwise
     // next copies (if any) would not detect the correct orientation
+    ExtrusionLoop loop = loop_src;
 
-    if (m_layer->lower_layer != nullptr && lower_layer_edge_grid != nullptr) {
-        if (! *lower_layer_edge_grid) {
-            // Create the distance field for a layer below.
-            const coord_t distance_field_resolution = coord_t(scale_(1.) + 0.5);
-            *lower_layer_edge_grid = make_unique<EdgeGrid::Grid>();
-            (*lower_layer_edge_grid)->create(m_layer->lower_layer->lslices, distance_field_resolution);
-            (*lower_layer_edge_grid)->calculate_sdf();
-            #if 0
-            {
-                static int iRun = 0;
-                BoundingBox bbox = (*lower_layer_edge_grid)->bbox();
-                bbox.min(0) -= scale_(5.f);
-                bbox.min(1) -= scale_(5.f);
-                bbox.max(0) += scale_(5.f);
-                bbox.max(1) += scale_(5.f);
-                EdgeGrid::save_png(*(*lower_layer_edge_grid), bbox, scale_(0.1f), debug_out_path("GCode_extrude_loop_edge_grid-%d.png", iRun++));
-            }
-            #endif
-        }
-    }
-  
     // extrude all loops ccw
     bool was_clockwise = loop.make_counter_clockwise();
     
@@ -2651,9 +2838,12 @@ std::string GCode::extrude_loop(ExtrusionLoop loop, std::string description, dou
 
         // Insert a projection of last_pos into the polygon.
         size_t last_pos_proj_idx;
+        bool   last_pos_proj_inserted;
         {
+            size_t num_points = polygon.points.size();
             Points::iterator it = project_point_to_polygon_and_insert(polygon, last_pos, 0.1 * nozzle_r);
-            last_pos_proj_idx = it - polygon.points.begin();
+            last_pos_proj_idx      = it - polygon.points.begin();
+            last_pos_proj_inserted = polygon.points.size() > num_points;
         }
 
         // Parametrize the polygon by its length.
@@ -2665,7 +2855,6 @@ std::string GCode::extrude_loop(ExtrusionLoop loop, std::string description, dou
         // No penalty for reflex points, slight penalty for convex points, high penalty for flat surfaces.
         const float penaltyConvexVertex = 1.f;
         const float penaltyFlatSurface  = 5.f;
-        const float penaltyOverhangHalf = 10.f;
         // Penalty for visible seams.
         for (size_t i = 0; i < polygon.points.size(); ++ i) {
             float ccwAngle = penalties[i];
@@ -2699,25 +2888,18 @@ std::string GCode::extrude_loop(ExtrusionLoop loop, std::string description, dou
         }
 
         // Penalty for overhangs.
-        if (lower_layer_edge_grid && (*lower_layer_edge_grid)) {
-            // Use the edge grid distance field structure over the lower layer to calculate overhangs.
-            coord_t nozzle_r = coord_t(floor(scale_(0.5 * nozzle_dmr) + 0.5));
-            coord_t search_r = coord_t(floor(scale_(0.8 * nozzle_dmr) + 0.5));
+        if (seam_candidates != nullptr) {
+            // Use the penalties evaluated by make_seam_candidates() if the loop is extruded with the expected nozzle.
+            auto it_loop = seam_candidates->loops.find(&loop_src);
+            const std::vector<float> *overhang_penalties = (it_loop == seam_candidates->loops.end() || it_loop->second.nozzle_dmr != nozzle_dmr) ?
+                nullptr : &it_loop->second.overhang_penalties;
+            assert(overhang_penalties == nullptr || overhang_penalties->size() + (last_pos_proj_inserted ? 1 : 0) == polygon.points.size());
             for (size_t i = 0; i < polygon.points.size(); ++ i) {
-                const Point &p = polygon.points[i];
-                coordf_t dist;
-                // Signed distance is positive outside the object, negative inside the object.
-                // The point is considered at an overhang, if it is more than nozzle radius
-                // outside of the lower layer contour.
-                #ifdef NDEBUG // to suppress unused variable warning in release mode
-                    (*lower_layer_edge_grid)->signed_distance(p, search_r, dist);
-                #else
-                    bool found = (*lower_layer_edge_grid)->signed_distance(p, search_r, dist);
-                #endif
-                // If the approximate Signed Distance Field was initialized over lower_layer_edge_grid,
-                // then the signed distnace shall always be known.
-                assert(found); 
-                penalties[i] += extrudate_overlap_penalty(float(nozzle_r), penaltyOverhangHalf, float(dist));
+                if (overhang_penalties == nullptr || (last_pos_proj_inserted && i == last_pos_proj_idx))
+                    // Use the edge grid distance field structure over the lower layer to calculate overhangs.
+                    penalties[i] += seam_overhang_penalty(seam_candidates->lower_layer_edge_grid, polygon.points[i], nozzle_dmr);
+                else
+                    penalties[i] += (*overhang_penalties)[last_pos_proj_inserted && i > last_pos_proj_idx ? i - 1 : i];
             }
         }
 
@@ -2874,14 +3056,14 @@ std::string GCode::extrude_multi_path(ExtrusionMultiPath multipath, std::string
     return gcode;
 }
 
-std::string GCode::extrude_entity(const ExtrusionEntity &entity, std::string description, double speed, std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid)
+std::string GCode::extrude_entity(const ExtrusionEntity &entity, std::string description, double speed, const SeamCandidates *seam_candidates)
 {
     if (const ExtrusionPath* path = dynamic_cast<const ExtrusionPath*>(&entity))
         return this->extrude_path(*path, description, speed);
     else if (const ExtrusionMultiPath* multipath = dynamic_cast<const ExtrusionMultiPath*>(&entity))
         return this->extrude_multi_path(*multipath, description, speed);
     else if (const ExtrusionLoop* loop = dynamic_cast<const ExtrusionLoop*>(&entity))
-        return this->extrude_loop(*loop, description, speed, lower_layer_edge_grid);
+        return this->extrude_loop(*loop, description, speed, seam_candidates);
     else
         throw std::invalid_argument("Invalid argument supplied to extrude()");
     return "";
@@ -2902,14 +3084,14 @@ std::string GCode::extrude_path(ExtrusionPath path, std::string description, dou
 }
 
 // Extrude perimeters: Decide where to put seams (hide or align seams).
-std::string GCode::extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region, std::unique_ptr<EdgeGrid::Grid> &lower_layer_edge_grid)
+std::string GCode::extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region, const SeamCandidates *seam_candidates)
 {
     std::string gcode;
     for (const ObjectByExtruder::Island::Region &region : by_region)
         if (! region.perimeters.empty()) {
             m_config.apply(print.regions()[&region - &by_region.front()]->config());
             for (const ExtrusionEntity *ee : region.perimeters)
-                gcode += this->extrude_entity(*ee, "perimeter", -1., &lower_layer_edge_grid);
+                gcode += this->extrude_entity(*ee, "perimeter", -1., seam_candidates);
         }
     return gcode;
 }
@@ -2929,11 +3111,11 @@ std::string GCode::extrude_infill(const Print &print, const std::vector<ObjectBy
         			extrusions.emplace_back(ee);
         	if (! extrusions.empty()) {
 	            m_config.apply(print.regions()[&region - &by_region.front()]->config());
-			    chain_and_reorder_extrusion_entities(extrusions, &m_last_pos);
+			    chain_and_reorder_extrusion_entities(extrusions, &m_last_pos, chaining_mode(m_config.fast_extrusion_ordering.value, extrusions.size()));
 	            for (const ExtrusionEntity *fill : extrusions) {
 	                auto *eec = dynamic_cast<const ExtrusionEntityCollection*>(fill);
 	                if (eec) {
-					    for (ExtrusionEntity *ee : eec->chained_path_from(m_last_pos).entities)
+					    for (ExtrusionEntity *ee : eec->chained_path_from(m_last_pos, erMixed, m_config.fast_extrusion_ordering.value).entities)
 	                        gcode += this->extrude_entity(*ee, extrusion_name);
 	                } else
 	                    gcode += this->extrude_entity(*fill, extrusion_name);
@@ -2973,22 +3155,45 @@ std::string GCode::extrude_support(const ExtrusionEntityCollection &support_fill
 void GCode::_write(FILE* file, const char *what)
 {
     if (what != nullptr) {
-        // apply analyzer, if enabled
-        const char* gcode = m_enable_analyzer ? m_analyzer.process_gcode(what).c_str() : what;
-
-        // writes string to file
-        fwrite(gcode, 1, ::strlen(gcode), file);
-        // updates time estimator and gcode lines vector
-        m_normal_time_estimator.add_gcode_block(gcode);
-        if (m_silent_time_estimator_enabled)
-            m_silent_time_estimator.add_gcode_block(gcode);
+        // The G-code is parsed just once, either by the analyzer or by m_gcode_reader,
+        // the parsed lines are passed to the time estimators.
+        auto parse = [this, what](auto line_callback) -> const char* {
+            if (m_enable_analyzer)
+                // apply analyzer, removes the analyzer tags from the G-code
+                return m_analyzer.process_gcode(what, line_callback).c_str();
+            GCodeReader::GCodeLine gline;
+            auto action = [&line_callback](GCodeReader&, const GCodeReader::GCodeLine &line) { line_callback(line); };
+            for (const char *ptr = what; *ptr != 0;) {
+                gline.reset();
+                ptr = m_gcode_reader.parse_line(ptr, gline, action);
+            }
+            return what;
+        };
+        // The normal and the silent time estimators process the same moves with different machine limits,
+        // both are fed by the same callback, thus the parsed line is not copied.
+        const char *gcode = m_silent_time_estimator_enabled ?
+            parse([this](const GCodeReader::GCodeLine &line) {
+                m_normal_time_estimator.add_gcode_line(line);
+                m_silent_time_estimator.add_gcode_line(line);
+            }) :
+            parse([this](const GCodeReader::GCodeLine &line) { m_normal_time_estimator.add_gcode_line(line); });
+        // writes string to file, the remaining times writer needs the time estimators to be updated first
+        m_remaining_times_writer->write(file, gcode);
     }
 }
 
 void GCode::_writeln(FILE* file, const std::string &what)
 {
-    if (! what.empty())
-        _write(file, (what.back() == '\n') ? what : (what + '\n'));
+    if (! what.empty()) {
+        if (what.back() == '\n')
+            _write(file, what);
+        else {
+            // Reuse the buffer instead of allocating what + '\n'.
+            m_writeln_buffer.assign(what);
+            m_writeln_buffer += '\n';
+            _write(file, m_writeln_buffer);
+        }
+    }
 }
 
 void GCode::_write_format(FILE* file, const char* format, ...)
@@ -3172,11 +3377,16 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
     double path_length = 0.;
     {
         std::string comment = m_config.gcode_comments ? description : "";
-        for (const Line &line : path.polyline.lines()) {
-            const double line_length = line.length() * SCALING_FACTOR;
+        const Points &pts = path.polyline.points;
+        // Roughly the length of a "G1 Xxxx.xxx Yxxx.xxx Exx.xxxxx" line, so that the lines are appended without reallocation.
+        if (pts.size() > 1)
+            gcode.reserve(gcode.size() + (pts.size() - 1) * (32 + (comment.empty() ? 0 : comment.size() + 3)));
+        for (size_t i = 1; i < pts.size(); ++ i) {
+            const double line_length = (pts[i] - pts[i - 1]).cast<double>().norm() * SCALING_FACTOR;
             path_length += line_length;
-            gcode += m_writer.extrude_to_xy(
-                this->point_to_gcode(line.b),
+            m_writer.extrude_to_xy(
+                gcode,
+                this->point_to_gcode(pts[i]),
                 e_per_mm * line_length,
                 comment);
         }
@@ -3226,11 +3436,10 @@ std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string
         m_wipe.reset_path();
     
     // use G1 because we rely on paths being straight (G0 may make round paths)
-    Lines lines = travel.lines();
-    if (! lines.empty()) {
-        for (const Line &line : lines)
-    	    gcode += m_writer.travel_to_xy(this->point_to_gcode(line.b), comment);    
-        this->set_last_pos(lines.back().b);
+    if (travel.points.size() > 1) {
+        for (size_t i = 1; i < travel.points.size(); ++ i)
+    	    m_writer.travel_to_xy(gcode, this->point_to_gcode(travel.points[i]), comment);
+        this->set_last_pos(travel.points.back());
     }
     return gcode;
 }
@@ -18,8 +18,10 @@
 #include "GCode/Analyzer.hpp"
 #include "GCode/ThumbnailData.hpp"
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #ifdef HAS_PRESSURE_EQUALIZER
 #include "GCode/PressureEqualizer.hpp"
@@ -143,6 +145,8 @@ public:
     GCode() : 
     	m_origin(Vec2d::Zero()),
         m_enable_loop_clipping(true), 
+        m_spiral_vase_enable(false), 
+        m_release_extrusions(false), 
         m_enable_cooling_markers(false), 
         m_enable_extrusion_role_markers(false), 
         m_enable_analyzer(false),
@@ -168,6 +172,9 @@ public:
     // throws std::runtime_exception on error,
     // throws CanceledException through print->throw_if_canceled().
     void            do_export(Print* print, const char* path, GCodePreviewData* preview_data = nullptr, ThumbnailsGeneratorCallback thumbnail_cb = nullptr);
+    // Release the extrusions of the object and support layers as soon as their G-code is generated
+    // to lower the peak memory of the export. The Print is not exportable again afterwards.
+    void            set_release_extrusions(bool enable) { m_release_extrusions = enable; }
 
     // Exported for the helper classes (OozePrevention, Wipe) and for the Perl binding for unit tests.
     const Vec2d&    origin() const { return m_origin; }
@@ -211,13 +218,67 @@ private:
 
     static std::vector<LayerToPrint>        		                   collect_layers_to_print(const PrintObject &object);
     static std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>> collect_layers_to_print(const Print &print);
-    void            process_layer(
-        // Write into the output file.
-        FILE                            *file,
+
+    // G-code of a single layer as produced by process_layer(), before it is passed
+    // through the SpiralVase, CoolingBuffer and PressureEqualizer filters.
+    struct LayerResult {
+        std::string gcode;
+        size_t      layer_id           = size_t(-1);
+        coordf_t    print_z            = 0.;
+        // Value of SpiralVase::enable to be set before the G-code of this layer is filtered by the SpiralVase.
+        bool        spiral_vase_enable = false;
+    };
+    // Export the layers of a non-sequential print (all objects at the same print_z printed together).
+    void            process_layers(
+        const Print                                                         &print,
+        const ToolOrdering                                                  &tool_ordering,
+        const std::vector<const PrintInstance*>                             &print_object_instances_ordering,
+        const std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>>   &layers_to_print,
+        FILE                                                                *file);
+    // Export the layers of a single object instance of a sequential print.
+    void            process_layers(
+        const Print                                                         &print,
+        const ToolOrdering                                                  &tool_ordering,
+        const std::vector<LayerToPrint>                                     &layers_to_print,
+        const size_t                                                         single_object_idx,
+        bool                                                                 release_extrusions,
+        FILE                                                                *file);
+    // Seam candidates of the perimeter loops of a LayerToPrint passed to process_layer(): The penalties of the loop vertices
+    // for being at an overhang, evaluated over a distance field over the lslices of the layer below.
+    // The overhang penalties do not depend on the G-code generator state, therefore they are calculated in parallel ahead
+    // of the generator, and extrude_loop() only adds the penalties depending on the current or the preceding seam position.
+    struct SeamCandidates
+    {
+        struct Loop {
+            // Nozzle diameter of the perimeter extruder of the loop's region, the penalties were evaluated for.
+            coordf_t            nozzle_dmr;
+            // Overhang penalty of each point of ExtrusionLoop::polygon() of the loop oriented counter clockwise.
+            std::vector<float>  overhang_penalties;
+        };
+        // Distance field over the lslices of the layer below. extrude_loop() queries it for the points it inserts into a loop
+        // and for a loop extruded with a nozzle diameter other than expected.
+        EdgeGrid::Grid                                  lower_layer_edge_grid;
+        std::unordered_map<const ExtrusionLoop*, Loop>  loops;
+    };
+    // Indexed as the LayerToPrint. Null if the layer has no perimeters or no layer below.
+    using LayersSeamCandidates = std::vector<std::shared_ptr<const SeamCandidates>>;
+    static LayersSeamCandidates make_seam_candidates(const std::vector<LayerToPrint> &layers);
+    // Runs the G-code generation of the layers and the stateful filters of the generated G-code in a pipeline,
+    // so that the layer N is generated while the layers N-1, N-2... are being post-processed and written.
+    // prepare_layer(idx) returns the stateless data of the idx-th layer, it is called in parallel for the layers ahead of the generator.
+    // generate_layer(idx, prepared) returns the G-code of the idx-th layer.
+    void            run_layers_pipeline(
+        size_t                                                                 num_layers,
+        const std::function<LayersSeamCandidates(size_t)>                     &prepare_layer,
+        const std::function<LayerResult(size_t, const LayersSeamCandidates&)> &generate_layer,
+        FILE                                                                  *file);
+    LayerResult     process_layer(
         const Print                     &print,
         // Set of object & print layers of the same PrintObject and with the same print_z.
         const std::vector<LayerToPrint> &layers,
         const LayerTools  				&layer_tools,
+        // Seam candidates of the perimeters of layers, see make_seam_candidates().
+        const LayersSeamCandidates      &seam_candidates,
 		// Pairs of PrintObject index and its instance index.
 		const std::vector<const PrintInstance*> *ordering,
         // If set to size_t(-1), then print all copies of all objects.
@@ -229,8 +290,8 @@ private:
     void            set_extruders(const std::vector<unsigned int> &extruder_ids);
     std::string     preamble();
     std::string     change_layer(coordf_t print_z);
-    std::string     extrude_entity(const ExtrusionEntity &entity, std::string description = "", double speed = -1., std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid = nullptr);
-    std::string     extrude_loop(ExtrusionLoop loop, std::string description, double speed = -1., std::unique_ptr<EdgeGrid::Grid> *lower_layer_edge_grid = nullptr);
+    std::string     extrude_entity(const ExtrusionEntity &entity, std::string description = "", double speed = -1., const SeamCandidates *seam_candidates = nullptr);
+    std::string     extrude_loop(const ExtrusionLoop &loop_src, std::string description, double speed = -1., const SeamCandidates *seam_candidates = nullptr);
     std::string     extrude_multi_path(ExtrusionMultiPath multipath, std::string description = "", double speed = -1.);
     std::string     extrude_path(ExtrusionPath path, std::string description = "", double speed = -1.);
 
@@ -297,7 +358,7 @@ private:
 		// For sequential print, the instance of the object to be printing has to be defined.
 		const size_t                     				 single_object_instance_idx);
 
-    std::string     extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region, std::unique_ptr<EdgeGrid::Grid> &lower_layer_edge_grid);
+    std::string     extrude_perimeters(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region, const SeamCandidates *seam_candidates);
     std::string     extrude_infill(const Print &print, const std::vector<ObjectByExtruder::Island::Region> &by_region, bool ironing);
     std::string     extrude_support(const ExtrusionEntityCollection &support_fills);
 
@@ -320,6 +381,11 @@ private:
     Wipe                                m_wipe;
     AvoidCrossingPerimeters             m_avoid_crossing_perimeters;
     bool                                m_enable_loop_clipping;
+    // SpiralVase::enable of the last layer generated by process_layer(). The SpiralVase itself is updated
+    // by the G-code export pipeline just before the G-code of that layer is filtered by the SpiralVase.
+    bool                                m_spiral_vase_enable;
+    // See set_release_extrusions().
+    bool                                m_release_extrusions;
     // If enabled, the G-code generator will put following comments at the ends
     // of the G-code lines: _EXTRUDE_SET_SPEED, _WIPE, _BRIDGE_FAN_START, _BRIDGE_FAN_END
     // Those comments are received and consumed (removed from the G-code) by the CoolingBuffer.pm Perl module.
@@ -372,10 +438,15 @@ private:
     GCodeTimeEstimator m_normal_time_estimator;
     GCodeTimeEstimator m_silent_time_estimator;
     bool m_silent_time_estimator_enabled;
+    // Writes the G-code into the output file, inserting the M73 lines with the remaining times.
+    std::unique_ptr<GCodeTimeEstimator::RemainingTimesWriter> m_remaining_times_writer;
 
     // Analyzer
     GCodeAnalyzer m_analyzer;
 
+    // Parses the G-code for the time estimators if the analyzer is disabled.
+    GCodeReader                         m_gcode_reader;
+
     // Write a string into a file.
     void _write(FILE* file, const std::string& what) { this->_write(file, what.c_str()); }
     void _write(FILE* file, const char *what);
@@ -384,6 +455,8 @@ private:
     // Add a newline, if the string does not end with a newline already.
     // Used to export a custom G-code section processed by the PlaceholderParser.
     void _writeln(FILE* file, const std::string& what);
+    // Buffer of _writeln() for the lines not terminated with a new line.
+    std::string m_writeln_buffer;
 
     // Formats and write into a file the given data. 
     void _write_format(FILE* file, const char* format, ...);
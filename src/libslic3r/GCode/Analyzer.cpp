@@ -140,13 +140,20 @@ void GCodeAnalyzer::reset()
     m_extruder_color.clear();
 }
 
-const std::string& GCodeAnalyzer::process_gcode(const std::string& gcode)
+const std::string& GCodeAnalyzer::process_gcode(const char *gcode, const std::function<void(const GCodeReader::GCodeLine&)> &line_callback)
 {
     m_process_output = "";
 
-    m_parser.parse_buffer(gcode,
-        [this](GCodeReader& reader, const GCodeReader::GCodeLine& line)
-    { this->_process_gcode_line(reader, line); });
+    GCodeReader::GCodeLine gline;
+    auto action = [this, &line_callback](GCodeReader& reader, const GCodeReader::GCodeLine& line)
+    {
+        if (this->_process_gcode_line(reader, line) && line_callback)
+            line_callback(line);
+    };
+    for (const char *ptr = gcode; *ptr != 0;) {
+        gline.reset();
+        ptr = m_parser.parse_line(ptr, gline, action);
+    }
 
     return m_process_output;
 }
@@ -174,7 +181,7 @@ bool GCodeAnalyzer::is_valid_extrusion_role(ExtrusionRole role)
     return ((erPerimeter <= role) && (role < erMixed));
 }
 
-void GCodeAnalyzer::_process_gcode_line(GCodeReader&, const GCodeReader::GCodeLine& line)
+bool GCodeAnalyzer::_process_gcode_line(GCodeReader&, const GCodeReader::GCodeLine& line)
 {
     // processes 'special' comments contained in line
     if (_process_tags(line))
@@ -183,7 +190,7 @@ void GCodeAnalyzer::_process_gcode_line(GCodeReader&, const GCodeReader::GCodeLi
         // DEBUG ONLY: puts the line back into the gcode
         m_process_output += line.raw() + "\n";
 #endif
-        return;
+        return false;
     }
 
     // sets new start position/extrusion
@@ -305,6 +312,7 @@ void GCodeAnalyzer::_process_gcode_line(GCodeReader&, const GCodeReader::GCodeLi
 
     // puts the line back into the gcode
     m_process_output += line.raw() + "\n";
+    return true;
 }
 
 void GCodeAnalyzer::_processG1(const GCodeReader::GCodeLine& line)
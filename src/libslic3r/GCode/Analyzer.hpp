@@ -136,7 +136,10 @@ public:
     void reset();
 
     // Adds the gcode contained in the given string to the analysis and returns it after removing the workcodes
-    const std::string& process_gcode(const std::string& gcode);
+    // If line_callback is set, it receives the parsed lines of the returned gcode, so that the returned gcode
+    // does not need to be parsed again by the time estimators.
+    const std::string& process_gcode(const char *gcode, const std::function<void(const GCodeReader::GCodeLine&)> &line_callback = nullptr);
+    const std::string& process_gcode(const std::string& gcode) { return this->process_gcode(gcode.c_str()); }
 
     // Calculates all data needed for gcode visualization
     // throws CanceledException through print->throw_if_canceled() (sent by the caller as callback).
@@ -149,7 +152,8 @@ public:
 
 private:
     // Processes the given gcode line
-    void _process_gcode_line(GCodeReader& reader, const GCodeReader::GCodeLine& line);
+    // Returns false if the line is a workcode, which was removed from the gcode.
+    bool _process_gcode_line(GCodeReader& reader, const GCodeReader::GCodeLine& line);
 
     // Move
     void _processG1(const GCodeReader::GCodeLine& line);
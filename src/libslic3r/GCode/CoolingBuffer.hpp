@@ -2,6 +2,7 @@
 #define slic3r_CoolingBuffer_hpp_
 
 #include "../libslic3r.h"
+#include "../PrintConfig.hpp"
 #include <map>
 #include <string>
 
@@ -20,12 +21,18 @@ struct PerExtruderAdjustments;
 // For example, some materials may not like to print too slowly, while with some materials 
 // we may slow down significantly.
 //
+// The CoolingBuffer processes the layers concurrently with the G-code generator, therefore it keeps a copy of the print config,
+// of the extruder IDs and of the toolchange prefix taken from the GCode at construction time, and it tracks the fan speed on its own.
+// It shall be constructed once the extruders of the GCodeWriter are set.
+//
 class CoolingBuffer {
 public:
     CoolingBuffer(GCode &gcodegen);
     void        reset();
     void        set_current_extruder(unsigned int extruder_id) { m_current_extruder = extruder_id; }
     std::string process_layer(const std::string &gcode, size_t layer_id);
+    // Fan speed set by the last fan command, which was not a temporary bridge fan speed.
+    unsigned int fan_speed() const { return m_fan_speed; }
     GCode* 	    gcodegen() { return &m_gcodegen; }
 
 private:
@@ -37,12 +44,19 @@ private:
     std::string apply_layer_cooldown(const std::string &gcode, size_t layer_id, float layer_time, std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
 
     GCode&              m_gcodegen;
+    // Snapshot of the print config, of the toolchange prefix and of the extruders of the GCode at the time this CoolingBuffer was created.
+    const FullPrintConfig     m_config;
+    const std::string         m_toolchange_prefix;
+    std::vector<unsigned int> m_extruder_ids;
+    unsigned int              m_num_extruders { 0 };
     std::string         m_gcode;
     // Internal data.
     // X,Y,Z,E,F
     std::vector<char>   m_axis;
     std::vector<float>  m_current_pos;
     unsigned int        m_current_extruder;
+    // Last fan speed emitted, see GCodeWriter::set_fan().
+    unsigned int        m_fan_speed;
 
     // Old logic: proportional.
     bool                m_cooling_logic_proportional = false;
@@ -122,10 +122,7 @@ public:
     char   extrusion_axis() const { return m_extrusion_axis; }
     void   set_extrusion_axis(char axis) { m_extrusion_axis = axis; }
 
-private:
-    const char* parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command);
-    void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
-
+    // Tokenizer helpers, public for the consumers of G-code, which do not need a fully parsed line.
     static bool         is_whitespace(char c)           { return c == ' ' || c == '\t'; }
     static bool         is_end_of_line(char c)          { return c == '\r' || c == '\n' || c == 0; }
     static bool         is_end_of_gcode_line(char c)    { return c == ';' || is_end_of_line(c); }
@@ -141,6 +138,10 @@ private:
         return c;
     }
 
+private:
+    const char* parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
+
     GCodeConfig m_config;
     char        m_extrusion_axis;
     float       m_position[NUM_AXES];
@@ -2,13 +2,20 @@
 #include "Utils.hpp"
 #include <boost/bind.hpp>
 #include <cmath>
+#include <cstring>
+#include <string_view>
 
 #include <Shiny/Shiny.h>
 
-#include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
 static const float MMMIN_TO_MMSEC = 1.0f / 60.0f;
 static const float MILLISEC_TO_SEC = 0.001f;
 static const float INCHES_TO_MM = 25.4f;
@@ -98,12 +105,12 @@ namespace Slic3r {
         return trapezoid.cruise_distance();
     }
 
-    void GCodeTimeEstimator::Block::calculate_trapezoid()
+    void GCodeTimeEstimator::Block::calculate_trapezoid(float exit_feedrate)
     {
         trapezoid.cruise_feedrate = feedrate.cruise;
 
         float accelerate_distance = std::max(0.0f, estimate_acceleration_distance(feedrate.entry, feedrate.cruise, acceleration));
-        float decelerate_distance = std::max(0.0f, estimate_acceleration_distance(feedrate.cruise, feedrate.exit, -acceleration));
+        float decelerate_distance = std::max(0.0f, estimate_acceleration_distance(feedrate.cruise, exit_feedrate, -acceleration));
         float cruise_distance = distance - accelerate_distance - decelerate_distance;
 
         // Not enough space to reach the nominal feedrate.
@@ -111,7 +118,7 @@ namespace Slic3r {
         // and start braking in order to reach the exit_feedrate exactly at the end of this block.
         if (cruise_distance < 0.0f)
         {
-            accelerate_distance = std::clamp(intersection_distance(feedrate.entry, feedrate.exit, acceleration, distance), 0.0f, distance);
+            accelerate_distance = std::clamp(intersection_distance(feedrate.entry, exit_feedrate, acceleration, distance), 0.0f, distance);
             cruise_distance = 0.0f;
             trapezoid.cruise_feedrate = Trapezoid::speed_from_distance(feedrate.entry, accelerate_distance, acceleration);
         }
@@ -168,6 +175,12 @@ namespace Slic3r {
         { this->_process_gcode_line(reader, line); });
     }
 
+    void GCodeTimeEstimator::add_gcode_line(const GCodeReader::GCodeLine &line)
+    {
+        PROFILE_FUNC();
+        this->_process_gcode_line(m_parser, line);
+    }
+
     void GCodeTimeEstimator::add_gcode_block(const char *ptr)
     {
         PROFILE_FUNC();
@@ -248,143 +261,226 @@ namespace Slic3r {
     }
 #endif
 
-    bool GCodeTimeEstimator::post_process(const std::string& filename, float interval_sec, const PostProcessData* const normal_mode, const PostProcessData* const silent_mode)
+    // Length of the space including the end of line, which is reserved for the M73 lines to be filled in later.
+    // "M73 P100 R" followed by up to 8 digits of the remaining time in minutes.
+    static constexpr size_t M73_line_length = 19;
+
+    static int fseek_64(FILE *file, int64_t offset, int origin)
+    {
+#ifdef _WIN32
+        return _fseeki64(file, offset, origin);
+#else
+        return fseeko(file, off_t(offset), origin);
+#endif
+    }
+
+    static int ftruncate_64(FILE *file, int64_t size)
+    {
+#ifdef _WIN32
+        return _chsize_s(_fileno(file), size);
+#else
+        return ftruncate(fileno(file), off_t(size));
+#endif
+    }
+
+    // Throws the same error as GCode::do_export() if the G-code could not be written.
+    static void throw_if_write_failed(FILE *file, bool failed)
     {
-        boost::nowide::ifstream in(filename);
-        if (!in.good())
-            throw std::runtime_error(std::string("Time estimator post process export failed.\nCannot open file for reading.\n"));
+        if (failed || ferror(file))
+            throw std::runtime_error("G-code export failed\nIs the disk full?\n");
+    }
 
-        std::string path_tmp = filename + ".postprocess";
+    // Move size bytes of the file from src to dst, where dst <= src.
+    static void move_file_data(FILE *file, int64_t dst, int64_t src, int64_t size, std::vector<char> &buffer)
+    {
+        assert(dst <= src);
+        if (dst == src)
+            return;
+        while (size > 0) {
+            size_t len = size_t(std::min<int64_t>(size, int64_t(buffer.size())));
+            throw_if_write_failed(file, fseek_64(file, src, SEEK_SET) != 0 || fread(buffer.data(), 1, len, file) != len);
+            throw_if_write_failed(file, fseek_64(file, dst, SEEK_SET) != 0 || fwrite(buffer.data(), 1, len, file) != len);
+            src  += int64_t(len);
+            dst  += int64_t(len);
+            size -= int64_t(len);
+        }
+    }
 
-        FILE* out = boost::nowide::fopen(path_tmp.c_str(), "wb");
-        if (out == nullptr)
-            throw std::runtime_error(std::string("Time estimator post process export failed.\nCannot open file for writing.\n"));
+    GCodeTimeEstimator::RemainingTimesWriter::RemainingTimesWriter(float interval_sec, const GCodeTimeEstimator *normal_mode, const GCodeTimeEstimator *silent_mode) :
+        m_interval_sec(interval_sec)
+    {
+        m_modes[0].estimator         = silent_mode;
+        m_modes[0].time_mask         = "M73 Q%s S%s\n";
+        m_modes[0].first_placeholder = &Silent_First_M73_Output_Placeholder_Tag;
+        m_modes[0].last_placeholder  = &Silent_Last_M73_Output_Placeholder_Tag;
+        m_modes[1].estimator         = normal_mode;
+        m_modes[1].time_mask         = "M73 P%s R%s\n";
+        m_modes[1].first_placeholder = &Normal_First_M73_Output_Placeholder_Tag;
+        m_modes[1].last_placeholder  = &Normal_Last_M73_Output_Placeholder_Tag;
+    }
 
-        std::string normal_time_mask = "M73 P%s R%s\n";
-        std::string silent_time_mask = "M73 Q%s S%s\n";
-        char line_M73[64];
+    void GCodeTimeEstimator::RemainingTimesWriter::write(FILE *file, const char *gcode)
+    {
+        m_buffer += gcode;
+        this->process_buffer(file, false);
+    }
 
-        std::string gcode_line;
-        // buffer line to export only when greater than 64K to reduce writing calls
-        std::string export_line;
+    void GCodeTimeEstimator::RemainingTimesWriter::finalize(FILE *file)
+    {
+        this->process_buffer(file, true);
+        assert(m_buffer.empty());
+        this->flush(file);
 
-        // helper function to write to disk
-        auto write_string = [&](const std::string& str) {
-            fwrite((const void*)export_line.c_str(), 1, export_line.length(), out);
-            if (ferror(out))
-            {
-                in.close();
-                fclose(out);
-                boost::nowide::remove(path_tmp.c_str());
-                throw std::runtime_error(std::string("Time estimator post process export failed.\nIs the disk full?\n"));
-            }
-            export_line.clear();
+        // Now the total print time is known, fill in the M73 lines.
+        std::vector<std::pair<int64_t, std::string>> lines_M73;
+        auto format_line = [&lines_M73](int64_t pos, const char *time_mask, const std::string &percent, const std::string &remaining) {
+            char line_M73[64];
+            int  len = sprintf(line_M73, time_mask, percent.c_str(), remaining.c_str());
+            assert(len > 0 && size_t(len) <= M73_line_length);
+            lines_M73.emplace_back(pos, std::string(line_M73, len));
         };
-
-        GCodeReader parser;
-        int g1_lines_count = 0;
-        int normal_g1_line_id = 0;
-        float normal_last_recorded_time = 0.0f;
-        int silent_g1_line_id = 0;
-        float silent_last_recorded_time = 0.0f;
-
-        // helper function to process g1 lines
-        auto process_g1_line = [&](const PostProcessData* const data, const GCodeReader::GCodeLine& line, int& g1_line_id, float& last_recorded_time, const std::string& time_mask) {
-            if (data == nullptr)
-                return;
-
-            assert((g1_line_id >= (int)data->g1_times.size()) || (data->g1_times[g1_line_id].first >= (int)g1_lines_count));
-            float elapsed_time = -1.0f;
-            if (g1_line_id < (int)data->g1_times.size())
-            {
-                const G1LineIdTime& map_item = data->g1_times[g1_line_id];
-                if (map_item.first == g1_lines_count)
-                {
-                    if (line.has_e())
-                        elapsed_time = map_item.second;
-                    ++g1_line_id;
-                }
+        for (const Mode &mode : m_modes)
+            if (mode.estimator != nullptr) {
+                float time = mode.estimator->m_time;
+                if (mode.first_line_pos != -1)
+                    format_line(mode.first_line_pos, mode.time_mask, "0", _get_time_minutes(time));
+                for (const std::pair<int64_t, float> &line : mode.lines)
+                    format_line(line.first, mode.time_mask, std::to_string((int)(100.0f * line.second / time)), _get_time_minutes(time - line.second));
             }
+        std::sort(lines_M73.begin(), lines_M73.end(), [](const auto &l, const auto &r) { return l.first < r.first; });
+
+        // The M73 lines are not longer than the space reserved for them. The G-code following the first M73 line
+        // is moved towards the start of the file while the M73 lines are filled in, so that the M73 lines are not padded.
+        // The data only moves backwards, therefore the file is compacted in place and truncated.
+        std::vector<char> buffer(65536);
+        int64_t src = lines_M73.empty() ? m_file_pos : lines_M73.front().first;
+        int64_t dst = src;
+        for (const std::pair<int64_t, std::string> &line : lines_M73) {
+            move_file_data(file, dst, src, line.first - src, buffer);
+            dst += line.first - src;
+            throw_if_write_failed(file, fseek_64(file, dst, SEEK_SET) != 0 || fwrite(line.second.data(), 1, line.second.size(), file) != line.second.size());
+            dst += int64_t(line.second.size());
+            src  = line.first + int64_t(M73_line_length);
+        }
+        move_file_data(file, dst, src, m_file_pos - src, buffer);
+        dst += m_file_pos - src;
+        throw_if_write_failed(file, fflush(file) != 0 || (dst < m_file_pos && ftruncate_64(file, dst) != 0) || fseek_64(file, 0, SEEK_END) != 0);
+        m_file_pos = dst;
+    }
+
+    void GCodeTimeEstimator::RemainingTimesWriter::process_buffer(FILE *file, bool finalizing)
+    {
+        const char *begin = m_buffer.c_str();
+        const char *end   = begin + m_buffer.size();
+        const char *line  = begin;
+        while (line < end) {
+            const char *line_end = (const char*)memchr(line, '\n', end - line);
+            if (line_end != nullptr)
+                ++ line_end;
+            else if (finalizing)
+                line_end = end;
+            else
+                // Incomplete line, wait for the rest of it.
+                break;
+            if (! this->process_line(line, line_end, finalizing))
+                break;
+            line = line_end;
+        }
+        m_buffer.erase(0, line - begin);
+        // buffer the output to export only when greater than 64K to reduce writing calls
+        if (m_output.size() > 65535)
+            this->flush(file);
+    }
+
+    // Does the G1 line starting with the command at c contain a valid E word? Matches GCodeLine::has_e() of a line parsed by GCodeReader.
+    static bool g1_line_has_e(const char *c)
+    {
+        for (c = GCodeReader::skip_word(c); ! GCodeReader::is_end_of_gcode_line(*c); c = GCodeReader::skip_word(c)) {
+            c = GCodeReader::skip_whitespaces(c);
+            if (*c == 'E') {
+                char *pend = nullptr;
+                strtod(c + 1, &pend);
+                if (pend != nullptr && GCodeReader::is_end_of_word(*pend))
+                    return true;
+            }
+        }
+        return false;
+    }
 
-            if (elapsed_time != -1.0f)
-            {
-                float block_remaining_time = data->time - elapsed_time;
-                if (std::abs(last_recorded_time - block_remaining_time) > interval_sec)
-                {
-                    sprintf(line_M73, time_mask.c_str(), std::to_string((int)(100.0f * elapsed_time / data->time)).c_str(), _get_time_minutes(block_remaining_time).c_str());
-                    gcode_line += line_M73;
+    bool GCodeTimeEstimator::RemainingTimesWriter::process_line(const char *begin, const char *end, bool finalizing)
+    {
+        std::string_view gcode_line(begin, (end > begin && end[-1] == '\n') ? end - begin - 1 : end - begin);
 
-                    last_recorded_time = block_remaining_time;
+        // check tags
+        // remove Color_Change_Tag and Pause_Print_Tag
+        if (gcode_line.size() > 2 && gcode_line[0] == ';' && gcode_line[1] == ' ' &&
+            (gcode_line.substr(2) == Color_Change_Tag || gcode_line.substr(2) == Pause_Print_Tag))
+            return true;
+
+        for (Mode &mode : m_modes)
+            if (mode.estimator != nullptr) {
+                // replaces placeholders for initial line M73 with the real lines
+                if (gcode_line == *mode.first_placeholder) {
+                    mode.first_line_pos = this->reserve_line();
+                    return true;
+                }
+                // replaces placeholders for final line M73 with the real lines
+                if (gcode_line == *mode.last_placeholder) {
+                    char line_M73[64];
+                    sprintf(line_M73, mode.time_mask, "100", "0");
+                    m_output += line_M73;
+                    return true;
                 }
             }
-        };
 
-        while (std::getline(in, gcode_line))
-        {
-            if (!in.good())
-            {
-                fclose(out);
-                throw std::runtime_error(std::string("Time estimator post process export failed.\nError while reading from file.\n"));
-            }
+        // Only the G1 lines and whether they extrude are of interest, which is much cheaper to find out than to parse the line.
+        const char *cmd   = GCodeReader::skip_whitespaces(begin);
+        bool        is_g1 = cmd[0] == 'G' && cmd[1] == '1' && GCodeReader::is_end_of_word(cmd[2]);
+        if (is_g1 && ! finalizing)
+            for (const Mode &mode : m_modes)
+                if (mode.estimator != nullptr && (mode.estimator->m_g1_times.empty() || mode.estimator->m_g1_times.back().first <= m_g1_lines_count))
+                    // The time estimator has not finished the calculation of the elapsed time up to this G1 line yet.
+                    return false;
 
-            // check tags
-            // remove Color_Change_Tag and Pause_Print_Tag
-            if (gcode_line == "; " + Color_Change_Tag || gcode_line == "; " + Pause_Print_Tag)
-                continue;
-
-            // replaces placeholders for initial line M73 with the real lines
-            if ((normal_mode != nullptr) && (gcode_line == Normal_First_M73_Output_Placeholder_Tag))
-            {
-                sprintf(line_M73, normal_time_mask.c_str(), "0", _get_time_minutes(normal_mode->time).c_str());
-                gcode_line = line_M73;
-            }
-            else if ((silent_mode != nullptr) && (gcode_line == Silent_First_M73_Output_Placeholder_Tag))
-            {
-                sprintf(line_M73, silent_time_mask.c_str(), "0", _get_time_minutes(silent_mode->time).c_str());
-                gcode_line = line_M73;
-            }
-            // replaces placeholders for final line M73 with the real lines
-            else if ((normal_mode != nullptr) && (gcode_line == Normal_Last_M73_Output_Placeholder_Tag))
-            {
-                sprintf(line_M73, normal_time_mask.c_str(), "100", "0");
-                gcode_line = line_M73;
-            }
-            else if ((silent_mode != nullptr) && (gcode_line == Silent_Last_M73_Output_Placeholder_Tag))
-            {
-                sprintf(line_M73, silent_time_mask.c_str(), "100", "0");
-                gcode_line = line_M73;
-            }
-            else
-                gcode_line += "\n";
+        m_output.append(gcode_line.data(), gcode_line.size());
+        m_output += '\n';
 
+        if (is_g1) {
             // add remaining time lines where needed
-            parser.parse_line(gcode_line,
-                [&](GCodeReader& reader, const GCodeReader::GCodeLine& line)
-                {
-                    if (line.cmd_is("G1"))
-                    {
-                        ++g1_lines_count;
-                        process_g1_line(silent_mode, line, silent_g1_line_id, silent_last_recorded_time, silent_time_mask);
-                        process_g1_line(normal_mode, line, normal_g1_line_id, normal_last_recorded_time, normal_time_mask);
+            ++ m_g1_lines_count;
+            for (Mode &mode : m_modes) {
+                if (mode.estimator == nullptr)
+                    continue;
+                const G1LineIdsTimes &g1_times = mode.estimator->m_g1_times;
+                assert(mode.g1_time_idx >= g1_times.size() || g1_times[mode.g1_time_idx].first >= m_g1_lines_count);
+                if (mode.g1_time_idx < g1_times.size() && g1_times[mode.g1_time_idx].first == m_g1_lines_count) {
+                    float elapsed_time = g1_times[mode.g1_time_idx ++].second;
+                    // The remaining time decreases by the elapsed time, the first M73 line is emitted
+                    // at the first extrusion.
+                    if (g1_line_has_e(cmd) && (! mode.recorded || std::abs(elapsed_time - mode.last_recorded_time) > m_interval_sec)) {
+                        mode.lines.emplace_back(this->reserve_line(), elapsed_time);
+                        mode.recorded           = true;
+                        mode.last_recorded_time = elapsed_time;
                     }
-                });
-
-            export_line += gcode_line;
-            if (export_line.length() > 65535)
-                write_string(export_line);
+                }
+            }
         }
+        return true;
+    }
 
-        if (!export_line.empty())
-            write_string(export_line);
-
-        fclose(out);
-        in.close();
-
-        if (rename_file(path_tmp, filename))
-            throw std::runtime_error(std::string("Failed to rename the output G-code file from ") + path_tmp + " to " + filename + '\n' +
-                "Is " + path_tmp + " locked?" + '\n');
+    int64_t GCodeTimeEstimator::RemainingTimesWriter::reserve_line()
+    {
+        int64_t pos = m_file_pos + int64_t(m_output.size());
+        m_output.append(M73_line_length - 1, ' ');
+        m_output += '\n';
+        return pos;
+    }
 
-        return true;
+    void GCodeTimeEstimator::RemainingTimesWriter::flush(FILE *file)
+    {
+        throw_if_write_failed(file, fwrite(m_output.data(), 1, m_output.size(), file) != m_output.size());
+        m_file_pos += int64_t(m_output.size());
+        m_output.clear();
     }
 
     void GCodeTimeEstimator::set_axis_position(EAxis axis, float position)
@@ -763,6 +859,7 @@ namespace Slic3r {
         set_axis_origin(X, 0.0f);
         set_axis_origin(Y, 0.0f);
         set_axis_origin(Z, 0.0f);
+        set_axis_origin(E, 0.0f);
 
         if (get_e_local_positioning_type() == Absolute)
             set_axis_position(E, 0.0f);
@@ -1581,10 +1678,7 @@ namespace Slic3r {
                 if (curr->flags.recalculate || next->flags.recalculate)
                 {
                     // NOTE: Entry and exit factors always > 0 by all previous logic operations.
-                    Block block = *curr;
-                    block.feedrate.exit = next->feedrate.entry;
-                    block.calculate_trapezoid();
-                    curr->trapezoid = block.trapezoid;
+                    curr->calculate_trapezoid(next->feedrate.entry);
                     curr->flags.recalculate = false; // Reset current only to ensure next trapezoid is computed
                 }
             }
@@ -1593,10 +1687,7 @@ namespace Slic3r {
         // Last/newest block in buffer. Always recalculated.
         if (next != nullptr)
         {
-            Block block = *next;
-            block.feedrate.exit = next->safe_feedrate;
-            block.calculate_trapezoid();
-            next->trapezoid = block.trapezoid;
+            next->calculate_trapezoid(next->safe_feedrate);
             next->flags.recalculate = false;
         }
     }
@@ -175,7 +175,9 @@ namespace Slic3r {
             float cruise_distance() const;
 
             // Calculates this block's trapezoid
-            void calculate_trapezoid();
+            void calculate_trapezoid() { this->calculate_trapezoid(feedrate.exit); }
+            // Calculates this block's trapezoid for the given exit feedrate, which may differ from feedrate.exit.
+            void calculate_trapezoid(float exit_feedrate);
 
             // Calculates the maximum allowable speed at this point when you must be able to reach target_velocity using the 
             // acceleration within the allotted distance.
@@ -209,10 +211,63 @@ namespace Slic3r {
         typedef std::pair<int, float> G1LineIdTime;
         typedef std::vector<G1LineIdTime> G1LineIdsTimes;
 
-        struct PostProcessData
+        // Writes the exported G-code into the output file in a single pass, while the G-code is being generated:
+        // Inserts the M73 lines with the remaining print time after the G1 lines, replaces the M73 placeholders
+        // and removes the working tags (as those used for color changes).
+        // The G-code following the first G1 line, for which the time estimators did not calculate the elapsed time yet,
+        // is kept in a look-behind buffer, which is bounded by the size of the time estimator's planner queue.
+        // As the total print time is only known once all the G-code was written, the M73 lines are written
+        // with a fixed length first and they are patched in place by finalize().
+        class RemainingTimesWriter
         {
-            const G1LineIdsTimes& g1_times;
-            float time;
+        public:
+            // If normal_mode == nullptr no M73 line will be added for normal mode,
+            // if silent_mode == nullptr no M73 line will be added for silent mode.
+            RemainingTimesWriter(float interval_sec, const GCodeTimeEstimator *normal_mode, const GCodeTimeEstimator *silent_mode);
+
+            // Write G-code, which has already been passed to the time estimators.
+            void write(FILE *file, const char *gcode);
+            // Write the rest of the look-behind buffer and fill in the M73 lines.
+            // To be called after GCodeTimeEstimator::calculate_time() was called for the time estimators
+            // and after all the G-code was written. The file has to be open for both reading and writing,
+            // as the G-code following the M73 lines is moved to close the gaps left by the shorter M73 lines.
+            void finalize(FILE *file);
+
+        private:
+            struct Mode
+            {
+                const GCodeTimeEstimator *estimator { nullptr };
+                // "M73 P%s R%s\n" for the normal mode, "M73 Q%s S%s\n" for the silent mode.
+                const char               *time_mask { nullptr };
+                const std::string        *first_placeholder { nullptr };
+                const std::string        *last_placeholder { nullptr };
+                // Index of the next item of estimator->m_g1_times to be matched with a G1 line.
+                size_t                    g1_time_idx { 0 };
+                bool                      recorded { false };
+                float                     last_recorded_time { 0.f };
+                // File offset of the M73 line replacing the first placeholder, -1 if there was no placeholder.
+                int64_t                   first_line_pos { -1 };
+                // File offsets of the M73 lines following the G1 lines, and the elapsed times of the G1 lines.
+                std::vector<std::pair<int64_t, float>> lines;
+            };
+
+            // Returns false if the line is a G1 line not yet processed by the time estimators.
+            bool process_line(const char *begin, const char *end, bool finalizing);
+            void process_buffer(FILE *file, bool finalizing);
+            // Reserve space for a M73 line to be filled in by finalize().
+            int64_t reserve_line();
+            void flush(FILE *file);
+
+            float           m_interval_sec;
+            // Silent mode first, normal mode second, the M73 lines are emitted in this order.
+            Mode            m_modes[2];
+            int             m_g1_lines_count { 0 };
+            // G-code not yet written, starting with the first G1 line not yet processed by the time estimators.
+            std::string     m_buffer;
+            // Processed G-code to be written into the file.
+            std::string     m_output;
+            // File offset of the start of m_output.
+            int64_t         m_file_pos { 0 };
         };
 
     private:
@@ -247,6 +302,9 @@ namespace Slic3r {
         // Adds the given gcode line
         void add_gcode_line(const std::string& gcode_line);
 
+        // Adds the given gcode line, which has already been parsed with the same extrusion axis.
+        void add_gcode_line(const GCodeReader::GCodeLine &line);
+
         void add_gcode_block(const char *ptr);
         void add_gcode_block(const std::string &str) { this->add_gcode_block(str.c_str()); }
 
@@ -265,14 +323,6 @@ namespace Slic3r {
         // Calculates the time estimate from the gcode contained in given list of gcode lines
         //void calculate_time_from_lines(const std::vector<std::string>& gcode_lines);
 
-        // Process the gcode contained in the file with the given filename, 
-        // replacing placeholders with correspondent new lines M73
-        // placing new lines M73 (containing the remaining time) where needed (in dependence of the given interval in seconds)
-        // and removing working tags (as those used for color changes)
-        // if normal_mode == nullptr no M73 line will be added for normal mode
-        // if silent_mode == nullptr no M73 line will be added for silent mode
-        static bool post_process(const std::string& filename, float interval_sec, const PostProcessData* const normal_mode, const PostProcessData* const silent_mode);
-
         // Set current position on the given axis with the given value
         void set_axis_position(EAxis axis, float position);
         // Set current origin on the given axis with the given value
@@ -375,8 +425,6 @@ namespace Slic3r {
         // Return an estimate of the memory consumed by the time estimator.
         size_t memory_used() const;
 
-        PostProcessData get_post_process_data() const { return PostProcessData{ m_g1_times, m_time }; }
-
     private:
         void _reset();
         void _reset_time();
@@ -1,20 +1,37 @@
 #include "GCodeWriter.hpp"
 #include "CustomGCode.hpp"
 #include <algorithm>
+#include <cstdio>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <assert.h>
 
+#if __has_include(<charconv>)
+    #include <charconv>
+#endif
+
 #define FLAVOR_IS(val) this->config.gcode_flavor == val
 #define FLAVOR_IS_NOT(val) this->config.gcode_flavor != val
-#define COMMENT(comment) if (this->config.gcode_comments && !comment.empty()) gcode << " ; " << comment;
-#define PRECISION(val, precision) std::fixed << std::setprecision(precision) << val
-#define XYZF_NUM(val) PRECISION(val, 3)
-#define E_NUM(val) PRECISION(val, 5)
 
 namespace Slic3r {
 
+void GCodeFormatter::emit_number(double v, int digits)
+{
+    // Enough for any finite double in a fixed point notation with up to 5 decimal digits.
+    char buf[330];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    // Rounds the same way as printf("%.*f").
+    std::to_chars_result res = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::fixed, digits);
+    assert(res.ec == std::errc());
+    m_out.append(buf, res.ptr);
+#else
+    int len = ::snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    assert(len > 0 && len < int(sizeof(buf)));
+    m_out.append(buf, size_t(len));
+#endif
+}
+
 void GCodeWriter::apply_print_config(const PrintConfig &print_config)
 {
     this->config.apply(print_config, true);
@@ -138,36 +155,41 @@ std::string GCodeWriter::set_bed_temperature(unsigned int temperature, bool wait
 }
 
 std::string GCodeWriter::set_fan(unsigned int speed, bool dont_save)
+{
+    if (m_last_fan_speed == speed && ! dont_save)
+        return std::string();
+    if (! dont_save)
+        m_last_fan_speed = speed;
+    return GCodeWriter::set_fan(this->config.gcode_flavor.value, this->config.gcode_comments.value, speed);
+}
+
+std::string GCodeWriter::set_fan(GCodeFlavor gcode_flavor, bool gcode_comments, unsigned int speed)
 {
     std::ostringstream gcode;
-    if (m_last_fan_speed != speed || dont_save) {
-        if (!dont_save) m_last_fan_speed = speed;
-        
-        if (speed == 0) {
-            if (FLAVOR_IS(gcfTeacup)) {
-                gcode << "M106 S0";
-            } else if (FLAVOR_IS(gcfMakerWare) || FLAVOR_IS(gcfSailfish)) {
-                gcode << "M127";
-            } else {
-                gcode << "M107";
-            }
-            if (this->config.gcode_comments) gcode << " ; disable fan";
-            gcode << "\n";
+    if (speed == 0) {
+        if (gcode_flavor == gcfTeacup) {
+            gcode << "M106 S0";
+        } else if (gcode_flavor == gcfMakerWare || gcode_flavor == gcfSailfish) {
+            gcode << "M127";
         } else {
-            if (FLAVOR_IS(gcfMakerWare) || FLAVOR_IS(gcfSailfish)) {
-                gcode << "M126";
+            gcode << "M107";
+        }
+        if (gcode_comments) gcode << " ; disable fan";
+        gcode << "\n";
+    } else {
+        if (gcode_flavor == gcfMakerWare || gcode_flavor == gcfSailfish) {
+            gcode << "M126";
+        } else {
+            gcode << "M106 ";
+            if (gcode_flavor == gcfMach3 || gcode_flavor == gcfMachinekit) {
+                gcode << "P";
             } else {
-                gcode << "M106 ";
-                if (FLAVOR_IS(gcfMach3) || FLAVOR_IS(gcfMachinekit)) {
-                    gcode << "P";
-                } else {
-                    gcode << "S";
-                }
-                gcode << (255.0 * speed / 100.0);
+                gcode << "S";
             }
-            if (this->config.gcode_comments) gcode << " ; enable fan";
-            gcode << "\n";
+            gcode << (255.0 * speed / 100.0);
         }
+        if (gcode_comments) gcode << " ; enable fan";
+        gcode << "\n";
     }
     return gcode.str();
 }
@@ -270,26 +292,34 @@ std::string GCodeWriter::set_speed(double F, const std::string &comment, const s
 {
     assert(F > 0.);
     assert(F < 100000.);
-    std::ostringstream gcode;
-    gcode << "G1 F" << XYZF_NUM(F);
-    COMMENT(comment);
-    gcode << cooling_marker;
-    gcode << "\n";
-    return gcode.str();
+    std::string gcode;
+    GCodeFormatter w(gcode);
+    w.emit_string("G1");
+    w.emit_f(F);
+    w.emit_comment(this->config.gcode_comments, comment);
+    w.emit_string(cooling_marker);
+    w.emit_eol();
+    return gcode;
 }
 
 std::string GCodeWriter::travel_to_xy(const Vec2d &point, const std::string &comment)
+{
+    std::string gcode;
+    this->travel_to_xy(gcode, point, comment);
+    return gcode;
+}
+
+void GCodeWriter::travel_to_xy(std::string &gcode, const Vec2d &point, const std::string &comment)
 {
     m_pos(0) = point(0);
     m_pos(1) = point(1);
     
-    std::ostringstream gcode;
-    gcode << "G1 X" << XYZF_NUM(point(0))
-          <<   " Y" << XYZF_NUM(point(1))
-          <<   " F" << XYZF_NUM(this->config.travel_speed.value * 60.0);
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+    GCodeFormatter w(gcode);
+    w.emit_string("G1");
+    w.emit_xy(point);
+    w.emit_f(this->config.travel_speed.value * 60.0);
+    w.emit_comment(this->config.gcode_comments, comment);
+    w.emit_eol();
 }
 
 std::string GCodeWriter::travel_to_xyz(const Vec3d &point, const std::string &comment)
@@ -313,14 +343,14 @@ std::string GCodeWriter::travel_to_xyz(const Vec3d &point, const std::string &co
     m_lifted = 0;
     m_pos = point;
     
-    std::ostringstream gcode;
-    gcode << "G1 X" << XYZF_NUM(point(0))
-          <<   " Y" << XYZF_NUM(point(1))
-          <<   " Z" << XYZF_NUM(point(2))
-          <<   " F" << XYZF_NUM(this->config.travel_speed.value * 60.0);
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+    std::string gcode;
+    GCodeFormatter w(gcode);
+    w.emit_string("G1");
+    w.emit_xyz(point);
+    w.emit_f(this->config.travel_speed.value * 60.0);
+    w.emit_comment(this->config.gcode_comments, comment);
+    w.emit_eol();
+    return gcode;
 }
 
 std::string GCodeWriter::travel_to_z(double z, const std::string &comment)
@@ -346,12 +376,14 @@ std::string GCodeWriter::_travel_to_z(double z, const std::string &comment)
 {
     m_pos(2) = z;
     
-    std::ostringstream gcode;
-    gcode << "G1 Z" << XYZF_NUM(z)
-          <<   " F" << XYZF_NUM(this->config.travel_speed.value * 60.0);
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+    std::string gcode;
+    GCodeFormatter w(gcode);
+    w.emit_string("G1");
+    w.emit_axis(" Z", z, GCodeFormatter::XYZF_EXPORT_DIGITS);
+    w.emit_f(this->config.travel_speed.value * 60.0);
+    w.emit_comment(this->config.gcode_comments, comment);
+    w.emit_eol();
+    return gcode;
 }
 
 bool GCodeWriter::will_move_z(double z) const
@@ -367,18 +399,24 @@ bool GCodeWriter::will_move_z(double z) const
 }
 
 std::string GCodeWriter::extrude_to_xy(const Vec2d &point, double dE, const std::string &comment)
+{
+    std::string gcode;
+    this->extrude_to_xy(gcode, point, dE, comment);
+    return gcode;
+}
+
+void GCodeWriter::extrude_to_xy(std::string &gcode, const Vec2d &point, double dE, const std::string &comment)
 {
     m_pos(0) = point(0);
     m_pos(1) = point(1);
     m_extruder->extrude(dE);
     
-    std::ostringstream gcode;
-    gcode << "G1 X" << XYZF_NUM(point(0))
-          <<   " Y" << XYZF_NUM(point(1))
-          <<    " " << m_extrusion_axis << E_NUM(m_extruder->E());
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+    GCodeFormatter w(gcode);
+    w.emit_string("G1");
+    w.emit_xy(point);
+    w.emit_e(m_extrusion_axis, m_extruder->E());
+    w.emit_comment(this->config.gcode_comments, comment);
+    w.emit_eol();
 }
 
 std::string GCodeWriter::extrude_to_xyz(const Vec3d &point, double dE, const std::string &comment)
@@ -387,14 +425,14 @@ std::string GCodeWriter::extrude_to_xyz(const Vec3d &point, double dE, const std
     m_lifted = 0;
     m_extruder->extrude(dE);
     
-    std::ostringstream gcode;
-    gcode << "G1 X" << XYZF_NUM(point(0))
-          <<   " Y" << XYZF_NUM(point(1))
-          <<   " Z" << XYZF_NUM(point(2))
-          <<    " " << m_extrusion_axis << E_NUM(m_extruder->E());
-    COMMENT(comment);
-    gcode << "\n";
-    return gcode.str();
+    std::string gcode;
+    GCodeFormatter w(gcode);
+    w.emit_string("G1");
+    w.emit_xyz(point);
+    w.emit_e(m_extrusion_axis, m_extruder->E());
+    w.emit_comment(this->config.gcode_comments, comment);
+    w.emit_eol();
+    return gcode;
 }
 
 std::string GCodeWriter::retract(bool before_wipe)
@@ -421,7 +459,8 @@ std::string GCodeWriter::retract_for_toolchange(bool before_wipe)
 
 std::string GCodeWriter::_retract(double length, double restart_extra, const std::string &comment)
 {
-    std::ostringstream gcode;
+    std::string gcode;
+    GCodeFormatter w(gcode);
     
     /*  If firmware retraction is enabled, we use a fake value of 1
         since we ignore the actual configured retract_length which 
@@ -440,48 +479,52 @@ std::string GCodeWriter::_retract(double length, double restart_extra, const std
     if (dE != 0) {
         if (this->config.use_firmware_retraction) {
             if (FLAVOR_IS(gcfMachinekit))
-                gcode << "G22 ; retract\n";
+                w.emit_string("G22 ; retract\n");
             else
-                gcode << "G10 ; retract\n";
+                w.emit_string("G10 ; retract\n");
         } else {
-            gcode << "G1 " << m_extrusion_axis << E_NUM(m_extruder->E())
-                           << " F" << float(m_extruder->retract_speed() * 60.);
-            COMMENT(comment);
-            gcode << "\n";
+            w.emit_string("G1");
+            w.emit_e(m_extrusion_axis, m_extruder->E());
+            // The retraction speed used to be printed with the precision of E, keep the output unchanged.
+            w.emit_axis(" F", float(m_extruder->retract_speed() * 60.), GCodeFormatter::E_EXPORT_DIGITS);
+            w.emit_comment(this->config.gcode_comments, comment);
+            w.emit_eol();
         }
     }
     
     if (FLAVOR_IS(gcfMakerWare))
-        gcode << "M103 ; extruder off\n";
+        w.emit_string("M103 ; extruder off\n");
     
-    return gcode.str();
+    return gcode;
 }
 
 std::string GCodeWriter::unretract()
 {
-    std::ostringstream gcode;
+    std::string gcode;
+    GCodeFormatter w(gcode);
     
     if (FLAVOR_IS(gcfMakerWare))
-        gcode << "M101 ; extruder on\n";
+        w.emit_string("M101 ; extruder on\n");
     
     double dE = m_extruder->unretract();
     if (dE != 0) {
         if (this->config.use_firmware_retraction) {
             if (FLAVOR_IS(gcfMachinekit))
-                 gcode << "G23 ; unretract\n";
+                 w.emit_string("G23 ; unretract\n");
             else
-                 gcode << "G11 ; unretract\n";
-            gcode << this->reset_e();
+                 w.emit_string("G11 ; unretract\n");
+            w.emit_string(this->reset_e());
         } else {
             // use G1 instead of G0 because G0 will blend the restart with the previous travel move
-            gcode << "G1 " << m_extrusion_axis << E_NUM(m_extruder->E())
-                           << " F" << float(m_extruder->deretract_speed() * 60.);
-            if (this->config.gcode_comments) gcode << " ; unretract";
-            gcode << "\n";
+            w.emit_string("G1");
+            w.emit_e(m_extrusion_axis, m_extruder->E());
+            w.emit_axis(" F", float(m_extruder->deretract_speed() * 60.), GCodeFormatter::E_EXPORT_DIGITS);
+            w.emit_comment(this->config.gcode_comments, "unretract");
+            w.emit_eol();
         }
     }
     
-    return gcode.str();
+    return gcode;
 }
 
 /*  If this method is called more than once before calling unlift(),
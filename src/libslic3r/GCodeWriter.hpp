@@ -10,6 +10,33 @@
 
 namespace Slic3r {
 
+// Appends a G-code line to a string piece by piece, without any temporary allocation.
+// Numbers are printed with a fixed number of decimal digits, the output is the same as
+// of std::ostream << std::fixed << std::setprecision(digits) << value.
+class GCodeFormatter {
+public:
+    static constexpr const int XYZF_EXPORT_DIGITS = 3;
+    static constexpr const int E_EXPORT_DIGITS    = 5;
+
+    GCodeFormatter(std::string &out) : m_out(out) {}
+
+    void emit_string(const char *s)                     { m_out += s; }
+    void emit_string(const std::string &s)              { m_out += s; }
+    void emit_number(double v, int digits);
+    // axis is emitted verbatim, including a leading space if needed.
+    void emit_axis(const char *axis, double v, int digits) { m_out += axis; this->emit_number(v, digits); }
+    void emit_xy(const Vec2d &point)                    { this->emit_axis(" X", point(0), XYZF_EXPORT_DIGITS); this->emit_axis(" Y", point(1), XYZF_EXPORT_DIGITS); }
+    void emit_xyz(const Vec3d &point)                   { this->emit_xy(to_2d(point)); this->emit_axis(" Z", point(2), XYZF_EXPORT_DIGITS); }
+    void emit_e(const std::string &axis, double v)      { m_out += ' '; m_out += axis; this->emit_number(v, E_EXPORT_DIGITS); }
+    void emit_f(double speed)                           { this->emit_axis(" F", speed, XYZF_EXPORT_DIGITS); }
+    void emit_comment(bool allow_comments, const std::string &comment)
+        { if (allow_comments && ! comment.empty()) { m_out += " ; "; m_out += comment; } }
+    void emit_eol()                                     { m_out += '\n'; }
+
+private:
+    std::string &m_out;
+};
+
 class GCodeWriter {
 public:
     GCodeConfig config;
@@ -42,6 +69,11 @@ public:
     std::string set_temperature(unsigned int temperature, bool wait = false, int tool = -1) const;
     std::string set_bed_temperature(unsigned int temperature, bool wait = false);
     std::string set_fan(unsigned int speed, bool dont_save = false);
+    // Fan G-code for the given flavor, without tracking the fan state. Used by the CoolingBuffer, which tracks its own fan state.
+    static std::string set_fan(GCodeFlavor gcode_flavor, bool gcode_comments, unsigned int speed);
+    // The CoolingBuffer sets the fan between the start and the end of the layers, report its last fan speed back.
+    unsigned int last_fan_speed() const { return m_last_fan_speed; }
+    void        set_last_fan_speed(unsigned int speed) { m_last_fan_speed = speed; }
     std::string set_acceleration(unsigned int acceleration);
     std::string reset_e(bool force = false);
     std::string update_progress(unsigned int num, unsigned int tot, bool allow_100 = false) const;
@@ -56,10 +88,14 @@ public:
     std::string toolchange(unsigned int extruder_id);
     std::string set_speed(double F, const std::string &comment = std::string(), const std::string &cooling_marker = std::string()) const;
     std::string travel_to_xy(const Vec2d &point, const std::string &comment = std::string());
+    // Appends the travel move to gcode, no allocation is performed if gcode has enough capacity.
+    void        travel_to_xy(std::string &gcode, const Vec2d &point, const std::string &comment = std::string());
     std::string travel_to_xyz(const Vec3d &point, const std::string &comment = std::string());
     std::string travel_to_z(double z, const std::string &comment = std::string());
     bool        will_move_z(double z) const;
     std::string extrude_to_xy(const Vec2d &point, double dE, const std::string &comment = std::string());
+    // Appends the extrusion move to gcode, no allocation is performed if gcode has enough capacity.
+    void        extrude_to_xy(std::string &gcode, const Vec2d &point, double dE, const std::string &comment = std::string());
     std::string extrude_to_xyz(const Vec3d &point, double dE, const std::string &comment = std::string());
     std::string retract(bool before_wipe = false);
     std::string retract_for_toolchange(bool before_wipe = false);
@@ -4,9 +4,13 @@
 #include "Fill/Fill.hpp"
 #include "ShortestPath.hpp"
 #include "SVG.hpp"
+#include "Trace.hpp"
+#include "Utils.hpp"
 
 #include <boost/log/trivial.hpp>
 
+#include <tbb/parallel_for.h>
+
 namespace Slic3r {
 
 Layer::~Layer()
@@ -27,6 +31,115 @@ bool Layer::empty() const
     return true;
 }
 
+LayerMemoryUsage& LayerMemoryUsage::operator+=(const LayerMemoryUsage &rhs)
+{
+    this->layers          += rhs.layers;
+    this->slices          += rhs.slices;
+    this->fill_expolygons += rhs.fill_expolygons;
+    this->fill_surfaces   += rhs.fill_surfaces;
+    this->bridges         += rhs.bridges;
+    this->perimeters      += rhs.perimeters;
+    this->fills           += rhs.fills;
+    this->lslices         += rhs.lslices;
+    this->support         += rhs.support;
+    return *this;
+}
+
+// Memory allocated by the containers, not including the memory of the container object itself.
+static inline size_t memory_used(const Points &pts) { return SLIC3R_STDVEC_MEMSIZE(pts, Point); }
+
+static size_t memory_used(const Polygons &polygons)
+{
+    size_t out = SLIC3R_STDVEC_MEMSIZE(polygons, Polygon);
+    for (const Polygon &polygon : polygons)
+        out += memory_used(polygon.points);
+    return out;
+}
+
+static size_t memory_used(const Polylines &polylines)
+{
+    size_t out = SLIC3R_STDVEC_MEMSIZE(polylines, Polyline);
+    for (const Polyline &polyline : polylines)
+        out += memory_used(polyline.points);
+    return out;
+}
+
+static inline size_t memory_used(const ExPolygon &expoly) { return memory_used(expoly.contour.points) + memory_used(expoly.holes); }
+
+static size_t memory_used(const ExPolygons &expolys)
+{
+    size_t out = SLIC3R_STDVEC_MEMSIZE(expolys, ExPolygon);
+    for (const ExPolygon &expoly : expolys)
+        out += memory_used(expoly);
+    return out;
+}
+
+static size_t memory_used(const SurfaceCollection &surfaces)
+{
+    size_t out = SLIC3R_STDVEC_MEMSIZE(surfaces.surfaces, Surface);
+    for (const Surface &surface : surfaces.surfaces)
+        out += memory_used(surface.expolygon);
+    return out;
+}
+
+static size_t memory_used(const ExtrusionPaths &paths)
+{
+    size_t out = SLIC3R_STDVEC_MEMSIZE(paths, ExtrusionPath);
+    for (const ExtrusionPath &path : paths)
+        out += memory_used(path.polyline.points);
+    return out;
+}
+
+static size_t memory_used(const ExtrusionEntityCollection &collection);
+
+// Memory of a heap allocated extrusion entity owned by an ExtrusionEntityCollection.
+static size_t memory_used(const ExtrusionEntity &entity)
+{
+    if (entity.is_collection())
+        return sizeof(ExtrusionEntityCollection) + memory_used(static_cast<const ExtrusionEntityCollection&>(entity));
+    if (const ExtrusionPath *path = dynamic_cast<const ExtrusionPath*>(&entity))
+        return sizeof(*path) + memory_used(path->polyline.points);
+    if (const ExtrusionMultiPath *multipath = dynamic_cast<const ExtrusionMultiPath*>(&entity))
+        return sizeof(*multipath) + memory_used(multipath->paths);
+    if (const ExtrusionLoop *loop = dynamic_cast<const ExtrusionLoop*>(&entity))
+        return sizeof(*loop) + memory_used(loop->paths);
+    return sizeof(entity);
+}
+
+static size_t memory_used(const ExtrusionEntityCollection &collection)
+{
+    size_t out = SLIC3R_STDVEC_MEMSIZE(collection.entities, ExtrusionEntity*);
+    for (const ExtrusionEntity *entity : collection.entities)
+        out += memory_used(*entity);
+    return out;
+}
+
+void LayerRegion::memory_usage(LayerMemoryUsage &out) const
+{
+    out.layers          += sizeof(*this);
+    out.slices          += memory_used(this->slices);
+    out.fill_expolygons += memory_used(this->fill_expolygons);
+    out.fill_surfaces   += memory_used(this->fill_surfaces);
+    out.bridges         += memory_used(this->bridged) + memory_used(this->unsupported_bridge_edges);
+    out.perimeters      += memory_used(this->perimeters) + memory_used(this->thin_fills);
+    out.fills           += memory_used(this->fills);
+}
+
+void Layer::memory_usage(LayerMemoryUsage &out) const
+{
+    out.layers  += sizeof(*this) + SLIC3R_STDVEC_MEMSIZE(m_regions, LayerRegion*);
+    out.lslices += memory_used(this->lslices) + SLIC3R_STDVEC_MEMSIZE(this->lslices_bboxes, BoundingBox);
+    for (const LayerRegion *layerm : m_regions)
+        layerm->memory_usage(out);
+}
+
+void SupportLayer::memory_usage(LayerMemoryUsage &out) const
+{
+    Layer::memory_usage(out);
+    out.layers  += sizeof(*this) - sizeof(Layer);
+    out.support += memory_used(this->support_islands.expolygons) + memory_used(this->support_fills);
+}
+
 LayerRegion* Layer::add_region(PrintRegion* print_region)
 {
     m_regions.emplace_back(new LayerRegion(this, print_region));
@@ -105,12 +218,16 @@ ExPolygons Layer::merged(float offset_scaled) const
 // Here the perimeters are created cummulatively for all layer regions sharing the same parameters influencing the perimeters.
 // The perimeter paths and the thin fills (ExtrusionEntityCollection) are assigned to the first compatible layer region.
 // The resulting fill surface is split back among the originating regions.
+// The groups of compatible regions are processed in parallel, as a layer of a short object with many modifier regions
+// may take a considerable time to process, while there are only a few layers to process in parallel.
 void Layer::make_perimeters()
 {
     BOOST_LOG_TRIVIAL(trace) << "Generating perimeters for layer " << this->id();
     
     // keep track of regions whose perimeters we have already generated
     std::vector<unsigned char> done(m_regions.size(), false);
+    // groups of compatible regions, the first region of a group receives the perimeters
+    std::vector<LayerRegionPtrs> groups;
     
     for (LayerRegionPtrs::iterator layerm = m_regions.begin(); layerm != m_regions.end(); ++ layerm) 
     	if ((*layerm)->slices.empty()) {
@@ -150,44 +267,54 @@ void Layer::make_perimeters()
 		                done[it - m_regions.begin()] = true;
 		            }
 		        }
-	        
-	        if (layerms.size() == 1) {  // optimization
-	            (*layerm)->fill_surfaces.surfaces.clear();
-	            (*layerm)->make_perimeters((*layerm)->slices, &(*layerm)->fill_surfaces);
-	            (*layerm)->fill_expolygons = to_expolygons((*layerm)->fill_surfaces.surfaces);
-	        } else {
-	            SurfaceCollection new_slices;
-	            // Use the region with highest infill rate, as the make_perimeters() function below decides on the gap fill based on the infill existence.
-	            LayerRegion *layerm_config = layerms.front();
-	            {
-	                // group slices (surfaces) according to number of extra perimeters
-	                std::map<unsigned short, Surfaces> slices;  // extra_perimeters => [ surface, surface... ]
-	                for (LayerRegion *layerm : layerms) {
-	                    for (Surface &surface : layerm->slices.surfaces)
-	                        slices[surface.extra_perimeters].emplace_back(surface);
-	                    if (layerm->region()->config().fill_density > layerm_config->region()->config().fill_density)
-	                    	layerm_config = layerm;
-	                }
-	                // merge the surfaces assigned to each group
-	                for (std::pair<const unsigned short,Surfaces> &surfaces_with_extra_perimeters : slices)
-	                    new_slices.append(union_ex(surfaces_with_extra_perimeters.second, true), surfaces_with_extra_perimeters.second.front());
-	            }
-	            
-	            // make perimeters
-	            SurfaceCollection fill_surfaces;
-	            layerm_config->make_perimeters(new_slices, &fill_surfaces);
-
-	            // assign fill_surfaces to each layer
-	            if (!fill_surfaces.surfaces.empty()) { 
-	                for (LayerRegionPtrs::iterator l = layerms.begin(); l != layerms.end(); ++l) {
-	                    // Separate the fill surfaces.
-	                    ExPolygons expp = intersection_ex(to_polygons(fill_surfaces), (*l)->slices);
-	                    (*l)->fill_expolygons = expp;
-	                    (*l)->fill_surfaces.set(std::move(expp), fill_surfaces.surfaces.front());
-	                }
-	            }
-	        }
+	        groups.emplace_back(std::move(layerms));
 	    }
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, groups.size(), 1),
+        [this, &groups](const tbb::blocked_range<size_t> &range) {
+            for (size_t group_idx = range.begin(); group_idx < range.end(); ++ group_idx) {
+                Trace::Scope trace("LayerRegion::make_perimeters", "group", group_idx);
+                const LayerRegionPtrs &layerms = groups[group_idx];
+                if (layerms.size() == 1) {  // optimization
+                    LayerRegion *layerm = layerms.front();
+                    layerm->fill_surfaces.surfaces.clear();
+                    layerm->make_perimeters(layerm->slices, &layerm->fill_surfaces);
+                    layerm->fill_expolygons = to_expolygons(layerm->fill_surfaces.surfaces);
+                } else {
+                    SurfaceCollection new_slices;
+                    // Use the region with highest infill rate, as the make_perimeters() function below decides on the gap fill based on the infill existence.
+                    LayerRegion *layerm_config = layerms.front();
+                    {
+                        // group slices (surfaces) according to number of extra perimeters
+                        std::map<unsigned short, Surfaces> slices;  // extra_perimeters => [ surface, surface... ]
+                        for (LayerRegion *layerm : layerms) {
+                            for (Surface &surface : layerm->slices.surfaces)
+                                slices[surface.extra_perimeters].emplace_back(surface);
+                            if (layerm->region()->config().fill_density > layerm_config->region()->config().fill_density)
+                            	layerm_config = layerm;
+                        }
+                        // merge the surfaces assigned to each group
+                        for (std::pair<const unsigned short,Surfaces> &surfaces_with_extra_perimeters : slices)
+                            new_slices.append(union_ex(surfaces_with_extra_perimeters.second, true), surfaces_with_extra_perimeters.second.front());
+                    }
+                    
+                    // make perimeters
+                    SurfaceCollection fill_surfaces;
+                    layerm_config->make_perimeters(new_slices, &fill_surfaces);
+
+                    // assign fill_surfaces to each layer
+                    if (!fill_surfaces.surfaces.empty()) { 
+                        for (LayerRegion *l : layerms) {
+                            // Separate the fill surfaces.
+                            ExPolygons expp = intersection_ex(to_polygons(fill_surfaces), l->slices);
+                            l->fill_expolygons = expp;
+                            l->fill_surfaces.set(std::move(expp), fill_surfaces.surfaces.front());
+                        }
+                    }
+                }
+            }
+        });
     BOOST_LOG_TRIVIAL(trace) << "Generating perimeters for layer " << this->id() << " - Done";
 }
 
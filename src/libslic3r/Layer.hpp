@@ -13,6 +13,33 @@ class Layer;
 class PrintRegion;
 class PrintObject;
 
+// Memory held by the layers of a PrintObject in bytes, broken down by the data structure.
+// Accumulated by LayerRegion::memory_usage(), Layer::memory_usage() and PrintObject::memory_usage().
+struct LayerMemoryUsage
+{
+    // Layer and LayerRegion objects themselves.
+    size_t layers           { 0 };
+    // LayerRegion::slices
+    size_t slices           { 0 };
+    // LayerRegion::fill_expolygons
+    size_t fill_expolygons  { 0 };
+    // LayerRegion::fill_surfaces
+    size_t fill_surfaces    { 0 };
+    // LayerRegion::bridged and LayerRegion::unsupported_bridge_edges
+    size_t bridges          { 0 };
+    // LayerRegion::perimeters and LayerRegion::thin_fills
+    size_t perimeters       { 0 };
+    // LayerRegion::fills
+    size_t fills            { 0 };
+    // Layer::lslices and Layer::lslices_bboxes
+    size_t lslices          { 0 };
+    // SupportLayer::support_islands and SupportLayer::support_fills
+    size_t support          { 0 };
+
+    size_t total() const { return layers + slices + fill_expolygons + fill_surfaces + bridges + perimeters + fills + lslices + support; }
+    LayerMemoryUsage& operator+=(const LayerMemoryUsage &rhs);
+};
+
 class LayerRegion
 {
 public:
@@ -71,6 +98,8 @@ public:
 
     // Is there any valid extrusion assigned to this LayerRegion?
     bool    has_extrusions() const { return ! this->perimeters.entities.empty() || ! this->fills.entities.empty(); }
+    // Add the memory held by this LayerRegion to out.
+    void    memory_usage(LayerMemoryUsage &out) const;
 
 protected:
     friend class Layer;
@@ -145,6 +174,8 @@ public:
 
     // Is there any valid extrusion assigned to this LayerRegion?
     virtual bool            has_extrusions() const { for (auto layerm : m_regions) if (layerm->has_extrusions()) return true; return false; }
+    // Add the memory held by this layer and its regions to out.
+    virtual void            memory_usage(LayerMemoryUsage &out) const;
 
 protected:
     friend class PrintObject;
@@ -173,6 +204,7 @@ public:
 
     // Is there any valid extrusion assigned to this LayerRegion?
     virtual bool                has_extrusions() const { return ! support_fills.empty(); }
+    void                        memory_usage(LayerMemoryUsage &out) const override;
 
 protected:
     friend class PrintObject;
@@ -11,6 +11,7 @@
 #include "SupportMaterial.hpp"
 #include "GCode.hpp"
 #include "GCode/WipeTower.hpp"
+#include "Trace.hpp"
 #include "Utils.hpp"
 
 //#include "PrintExport.hpp"
@@ -24,6 +25,9 @@
 #include <boost/format.hpp>
 #include <boost/log/trivial.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 // Mark string for localization and translate.
 #define L(s) Slic3r::I18N::translate(s)
 
@@ -65,168 +69,25 @@ bool Print::invalidate_state_by_config_options(const std::vector<t_config_option
     if (opt_keys.empty())
         return false;
 
-    // Cache the plenty of parameters, which influence the G-code generator only,
-    // or they are only notes not influencing the generated G-code.
-    static std::unordered_set<std::string> steps_gcode = {
-        "avoid_crossing_perimeters",
-        "bed_shape",
-        "bed_temperature",
-        "before_layer_gcode",
-        "between_objects_gcode",
-        "bridge_acceleration",
-        "bridge_fan_speed",
-        "colorprint_heights",
-        "cooling",
-        "default_acceleration",
-        "deretract_speed",
-        "disable_fan_first_layers",
-        "duplicate_distance",
-        "end_gcode",
-        "end_filament_gcode",
-        "extrusion_axis",
-        "extruder_clearance_height",
-        "extruder_clearance_radius",
-        "extruder_colour",
-        "extruder_offset",
-        "extrusion_multiplier",
-        "fan_always_on",
-        "fan_below_layer_time",
-        "filament_colour",
-        "filament_diameter",
-        "filament_density",
-        "filament_notes",
-        "filament_cost",
-        "first_layer_acceleration",
-        "first_layer_bed_temperature",
-        "first_layer_speed",
-        "gcode_comments",
-        "gcode_label_objects",
-        "infill_acceleration",
-        "layer_gcode",
-        "min_fan_speed",
-        "max_fan_speed",
-        "max_print_height",
-        "min_print_speed",
-        "max_print_speed",
-        "max_volumetric_speed",
-#ifdef HAS_PRESSURE_EQUALIZER
-        "max_volumetric_extrusion_rate_slope_positive",
-        "max_volumetric_extrusion_rate_slope_negative",
-#endif /* HAS_PRESSURE_EQUALIZER */
-        "notes",
-        "only_retract_when_crossing_perimeters",
-        "output_filename_format",
-        "perimeter_acceleration",
-        "post_process",
-        "printer_notes",
-        "retract_before_travel",
-        "retract_before_wipe",
-        "retract_layer_change",
-        "retract_length",
-        "retract_length_toolchange",
-        "retract_lift",
-        "retract_lift_above",
-        "retract_lift_below",
-        "retract_restart_extra",
-        "retract_restart_extra_toolchange",
-        "retract_speed",
-        "single_extruder_multi_material_priming",
-        "slowdown_below_layer_time",
-        "standby_temperature_delta",
-        "start_gcode",
-        "start_filament_gcode",
-        "toolchange_gcode",
-        "threads",
-        "travel_speed",
-        "use_firmware_retraction",
-        "use_relative_e_distances",
-        "use_volumetric_e",
-        "variable_layer_height",
-        "wipe"
-    };
-
-    static std::unordered_set<std::string> steps_ignore;
-
     std::vector<PrintStep> steps;
     std::vector<PrintObjectStep> osteps;
     bool invalidated = false;
 
     for (const t_config_option_key &opt_key : opt_keys) {
-        if (steps_gcode.find(opt_key) != steps_gcode.end()) {
-            // These options only affect G-code export or they are just notes without influence on the generated G-code,
-            // so there is nothing to invalidate.
-            steps.emplace_back(psGCodeExport);
-        } else if (steps_ignore.find(opt_key) != steps_ignore.end()) {
-            // These steps have no influence on the G-code whatsoever. Just ignore them.
-        } else if (
-               opt_key == "skirts"
-            || opt_key == "skirt_height"
-            || opt_key == "draft_shield"
-            || opt_key == "skirt_distance"
-            || opt_key == "min_skirt_length"
-            || opt_key == "ooze_prevention"
-            || opt_key == "wipe_tower_x"
-            || opt_key == "wipe_tower_y"
-            || opt_key == "wipe_tower_rotation_angle") {
-            steps.emplace_back(psSkirt);
-        } else if (opt_key == "brim_width") {
-            steps.emplace_back(psBrim);
-            steps.emplace_back(psSkirt);
-        } else if (
-               opt_key == "nozzle_diameter"
-            || opt_key == "resolution"
-            // Spiral Vase forces different kind of slicing than the normal model:
-            // In Spiral Vase mode, holes are closed and only the largest area contour is kept at each layer.
-            // Therefore toggling the Spiral Vase on / off requires complete reslicing.
-            || opt_key == "spiral_vase") {
-            osteps.emplace_back(posSlice);
-        } else if (
-               opt_key == "complete_objects"
-            || opt_key == "filament_type"
-            || opt_key == "filament_soluble"
-            || opt_key == "first_layer_temperature"
-            || opt_key == "filament_loading_speed"
-            || opt_key == "filament_loading_speed_start"
-            || opt_key == "filament_unloading_speed"
-            || opt_key == "filament_unloading_speed_start"
-            || opt_key == "filament_toolchange_delay"
-            || opt_key == "filament_cooling_moves"
-            || opt_key == "filament_minimal_purge_on_wipe_tower"
-            || opt_key == "filament_cooling_initial_speed"
-            || opt_key == "filament_cooling_final_speed"
-            || opt_key == "filament_ramming_parameters"
-            || opt_key == "filament_max_volumetric_speed"
-            || opt_key == "gcode_flavor"
-            || opt_key == "high_current_on_filament_swap"
-            || opt_key == "infill_first"
-            || opt_key == "single_extruder_multi_material"
-            || opt_key == "temperature"
-            || opt_key == "wipe_tower"
-            || opt_key == "wipe_tower_width"
-            || opt_key == "wipe_tower_bridging"
-            || opt_key == "wipe_tower_no_sparse_layers"
-            || opt_key == "wiping_volumes_matrix"
-            || opt_key == "parking_pos_retraction"
-            || opt_key == "cooling_tube_retraction"
-            || opt_key == "cooling_tube_length"
-            || opt_key == "extra_loading_move"
-            || opt_key == "z_offset") {
-            steps.emplace_back(psWipeTower);
-            steps.emplace_back(psSkirt);
-        } else if (
-               opt_key == "first_layer_extrusion_width" 
-            || opt_key == "min_layer_height"
-            || opt_key == "max_layer_height") {
-            osteps.emplace_back(posPerimeters);
-            osteps.emplace_back(posInfill);
-            osteps.emplace_back(posSupportMaterial);
-            steps.emplace_back(psSkirt);
-            steps.emplace_back(psBrim);
-        } else {
+        // The steps reading the option are listed by the dependency table in PrintConfig.cpp.
+        const PrintStepDependency *dependency = print_step_dependency(opt_key);
+        if (dependency == nullptr) {
             // for legacy, if we can't handle this option let's invalidate all steps
             //FIXME invalidate all steps of all objects as well?
             invalidated |= this->invalidate_all_steps();
             // Continue with the other opt_keys to possibly invalidate any object specific steps.
+        } else if ((opt_key == "temperature" || opt_key == "first_layer_temperature") && ! this->has_wipe_tower()) {
+            // Without the wipe tower, the temperatures are only read by the G-code generator.
+            // Enabling the wipe tower invalidates the wipe tower step by itself.
+            steps.emplace_back(psGCodeExport);
+        } else {
+            append(steps, dependency->print_steps);
+            append(osteps, dependency->object_steps);
         }
     }
 
@@ -844,7 +705,6 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
         bool support_enforcers_differ   = model_volume_list_changed(model_object, model_object_new, ModelVolumeType::SUPPORT_ENFORCER);
         if (model_parts_differ || modifiers_differ || 
             model_object.origin_translation         != model_object_new.origin_translation   ||
-            model_object.layer_height_profile       != model_object_new.layer_height_profile ||
             ! layer_height_ranges_equal(model_object.layer_config_ranges, model_object_new.layer_config_ranges, model_object_new.layer_height_profile.empty())) {
             // The very first step (the slicing step) is invalidated. One may freely remove all associated PrintObjects.
             auto range = print_object_status.equal_range(PrintObjectStatus(model_object.id()));
@@ -854,17 +714,27 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
             }
             // Copy content of the ModelObject including its ID, do not change the parent.
             model_object.assign_copy(model_object_new);
-        } else if (support_blockers_differ || support_enforcers_differ || model_custom_supports_data_changed(model_object, model_object_new)) {
-            // First stop background processing before shuffling or deleting the ModelVolumes in the ModelObject's list.
-            this->call_cancel_callback();
-            update_apply_status(false);
-            // Invalidate just the supports step.
-            auto range = print_object_status.equal_range(PrintObjectStatus(model_object.id()));
-            for (auto it = range.first; it != range.second; ++ it)
-                update_apply_status(it->print_object->invalidate_step(posSupportMaterial));
-            if (support_enforcers_differ || support_blockers_differ) {
-                // Copy just the support volumes.
-                model_volume_list_update_supports(model_object, model_object_new);
+        } else {
+            if (model_object.layer_height_profile != model_object_new.layer_height_profile) {
+                // Only the layer heights changed. Keep the PrintObjects, so that the layers at unchanged Z heights
+                // are not sliced again and their perimeters and infill are reused where possible.
+                auto range = print_object_status.equal_range(PrintObjectStatus(model_object.id()));
+                for (auto it = range.first; it != range.second; ++ it)
+                    update_apply_status(it->print_object->invalidate_layer_height_profile());
+                model_object.layer_height_profile = model_object_new.layer_height_profile;
+            }
+            if (support_blockers_differ || support_enforcers_differ || model_custom_supports_data_changed(model_object, model_object_new)) {
+                // First stop background processing before shuffling or deleting the ModelVolumes in the ModelObject's list.
+                this->call_cancel_callback();
+                update_apply_status(false);
+                // Invalidate just the supports step.
+                auto range = print_object_status.equal_range(PrintObjectStatus(model_object.id()));
+                for (auto it = range.first; it != range.second; ++ it)
+                    update_apply_status(it->print_object->invalidate_step(posSupportMaterial));
+                if (support_enforcers_differ || support_blockers_differ) {
+                    // Copy just the support volumes.
+                    model_volume_list_update_supports(model_object, model_object_new);
+                }
             }
         }
         if (! model_parts_differ && ! modifiers_differ) {
@@ -1580,16 +1450,30 @@ void Print::auto_assign_extruders(ModelObject* model_object) const
 void Print::process()
 {
     BOOST_LOG_TRIVIAL(info) << "Staring the slicing process." << log_memory_info();
+    m_object_step_status_percent = -1;
+    // Slicing may update the caches of a ModelObject, which may be shared by multiple PrintObjects.
     for (PrintObject *obj : m_objects)
-        obj->make_perimeters();
-    this->set_status(70, L("Infilling layers"));
-    for (PrintObject *obj : m_objects)
-        obj->infill();
-    for (PrintObject *obj : m_objects)
-        obj->ironing();
-    for (PrintObject *obj : m_objects)
-        obj->generate_support_material();
+        obj->slice();
+    // From now on the objects are processed independently: Perimeters, infill, ironing and supports of an object
+    // only depend on the preceding steps of the same object. Instead of waiting for all objects to finish a step,
+    // each object runs its steps in sequence, overlapping with the other objects. The steps parallelize over layers,
+    // TBB balances the nested loops, so that the cores do not idle at the end of a short step of a small object.
+    // The steps are not split further into a task graph over layer ranges, the steps of an object still wait for each other,
+    // as they contain passes over all layers of the object (surface classification, vertical shells, bridges, supports).
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, m_objects.size(), 1),
+        [this](const tbb::blocked_range<size_t> &range) {
+            for (size_t object_idx = range.begin(); object_idx < range.end(); ++ object_idx) {
+                PrintObject *obj = m_objects[object_idx];
+                obj->make_perimeters();
+                obj->infill();
+                obj->ironing();
+                obj->generate_support_material();
+            }
+        }
+    );
     if (this->set_started(psWipeTower)) {
+        Trace::Scope trace("Print::make_wipe_tower");
         m_wipe_tower_data.clear();
         m_tool_ordering.clear();
         if (this->has_wipe_tower()) {
@@ -1604,6 +1488,7 @@ void Print::process()
         this->set_done(psWipeTower);
     }
     if (this->set_started(psSkirt)) {
+        Trace::Scope trace("Print::make_skirt");
         m_skirt.clear();
         m_skirt_convex_hull.clear();
         m_first_layer_convex_hull.points.clear();
@@ -1614,6 +1499,7 @@ void Print::process()
         this->set_done(psSkirt);
     }
 	if (this->set_started(psBrim)) {
+        Trace::Scope trace("Print::make_brim");
         m_brim.clear();
         m_first_layer_convex_hull.points.clear();
         if (m_config.brim_width > 0) {
@@ -1628,11 +1514,20 @@ void Print::process()
     BOOST_LOG_TRIVIAL(info) << "Slicing process finished." << log_memory_info();
 }
 
+void Print::set_object_step_status(int percent, const std::string &message)
+{
+    tbb::mutex::scoped_lock lock(m_object_step_status_mutex);
+    if (percent > m_object_step_status_percent) {
+        m_object_step_status_percent = percent;
+        this->set_status(percent, message);
+    }
+}
+
 // G-code export process, running at a background thread.
 // The export_gcode may die for various reasons (fails to process output_filename_format,
 // write error into the G-code, cannot execute post-processing scripts).
 // It is up to the caller to show an error message.
-std::string Print::export_gcode(const std::string& path_template, GCodePreviewData* preview_data, ThumbnailsGeneratorCallback thumbnail_cb)
+std::string Print::export_gcode(const std::string& path_template, GCodePreviewData* preview_data, ThumbnailsGeneratorCallback thumbnail_cb, bool release_extrusions)
 {
     // output everything to a G-code file
     // The following call may die if the output_filename_format template substitution fails.
@@ -1647,12 +1542,54 @@ std::string Print::export_gcode(const std::string& path_template, GCodePreviewDa
         message = L("Generating G-code");
     this->set_status(90, message);
 
+    if (release_extrusions)
+        this->release_fill_surfaces();
+
+    Trace::Scope trace("Print::export_gcode");
     // The following line may die for multiple reasons.
     GCode gcode;
-    gcode.do_export(this, path.c_str(), preview_data, thumbnail_cb);
+    gcode.set_release_extrusions(release_extrusions);
+    try {
+        gcode.do_export(this, path.c_str(), preview_data, thumbnail_cb);
+    } catch (...) {
+        if (release_extrusions)
+            this->invalidate_released_extrusions();
+        throw;
+    }
+    if (release_extrusions)
+        this->invalidate_released_extrusions();
     return path.c_str();
 }
 
+// Release the regions' fill surfaces, which are only used to generate the infill and the supports.
+void Print::release_fill_surfaces()
+{
+    for (PrintObject *object : m_objects)
+        for (Layer *layer : object->m_layers)
+            for (LayerRegion *layerm : layer->regions()) {
+                layerm->fill_expolygons.clear();
+                layerm->fill_expolygons.shrink_to_fit();
+                layerm->fill_surfaces.surfaces.clear();
+                layerm->fill_surfaces.surfaces.shrink_to_fit();
+            }
+}
+
+// Some or all of the extrusions and islands were released by release_fill_surfaces() and GCode::process_layers().
+// Invalidate the steps, which produced them, so that the next call to process() regenerates them.
+void Print::invalidate_released_extrusions()
+{
+    for (PrintObject *object : m_objects)
+        object->invalidate_step(posSlice);
+}
+
+LayerMemoryUsage Print::memory_usage() const
+{
+    LayerMemoryUsage out;
+    for (const PrintObject *object : m_objects)
+        out += object->memory_usage();
+    return out;
+}
+
 void Print::_make_skirt()
 {
     // First off we need to decide how tall the skirt must be.
@@ -1801,7 +1738,7 @@ void Print::_make_brim()
     size_t      num_loops = size_t(floor(m_config.brim_width.value / flow.spacing()));
     for (size_t i = 0; i < num_loops; ++ i) {
         this->throw_if_canceled();
-        islands = offset(islands, float(flow.scaled_spacing()), jtSquare);
+        islands = offset_parallel(islands, float(flow.scaled_spacing()), jtSquare);
         for (Polygon &poly : islands) {
             // poly.simplify(SCALED_RESOLUTION);
             poly.points.push_back(poly.points.front());
@@ -1814,7 +1751,7 @@ void Print::_make_brim()
             for (Polygon &poly : islands)
                 append(m_first_layer_convex_hull.points, poly.points);
         }
-        polygons_append(loops, offset(islands, -0.5f * float(flow.scaled_spacing())));
+        polygons_append(loops, offset_parallel(islands, -0.5f * float(flow.scaled_spacing())));
     }
     loops = union_pt_chained(loops, false);
     // The function above produces ordering well suited for concentric infill (from outside to inside).
@@ -8,6 +8,7 @@
 #include "Flow.hpp"
 #include "Point.hpp"
 #include "Slicing.hpp"
+#include "Surface.hpp"
 #include "GCode/ToolOrdering.hpp"
 #include "GCode/WipeTower.hpp"
 #include "GCode/ThumbnailData.hpp"
@@ -24,26 +25,7 @@ class GCodePreviewData;
 enum class SlicingMode : uint32_t;
 class Layer;
 class SupportLayer;
-
-// Print step IDs for keeping track of the print state.
-enum PrintStep {
-    psSkirt, 
-    psBrim,
-    // Synonym for the last step before the Wipe Tower / Tool Ordering, for the G-code preview slider to understand that 
-    // all the extrusions are there for the layer slider to add color changes etc.
-    psExtrusionPaths = psBrim,
-    psWipeTower,
-    // psToolOrdering is a synonym to psWipeTower, as the Wipe Tower calculates and modifies the ToolOrdering,
-    // while if printing without the Wipe Tower, the ToolOrdering is calculated as well.
-    psToolOrdering = psWipeTower,
-    psGCodeExport,
-    psCount,
-};
-
-enum PrintObjectStep {
-    posSlice, posPerimeters, posPrepareInfill,
-    posInfill, posIroning, posSupportMaterial, posCount,
-};
+struct LayerMemoryUsage;
 
 // A PrintRegion object represents a group of volumes to print
 // sharing the same config (including the same assigned extruder(s))
@@ -121,6 +103,8 @@ public:
     const PrintObjectConfig& config() const         { return m_config; }    
     const LayerPtrs&        layers() const          { return m_layers; }
     const SupportLayerPtrs& support_layers() const  { return m_support_layers; }
+    // Memory held by the object and support layers.
+    LayerMemoryUsage        memory_usage() const;
     const Transform3d&      trafo() const           { return m_trafo; }
     const PrintInstances&   instances() const       { return m_instances; }
 
@@ -196,7 +180,7 @@ private:
     friend class Print;
 
 	PrintObject(Print* print, ModelObject* model_object, const Transform3d& trafo, PrintInstances&& instances);
-	~PrintObject() = default;
+	~PrintObject() { this->clear_layers(); this->clear_support_layers(); }
 
     void                    config_apply(const ConfigBase &other, bool ignore_nonexistent = false) { this->m_config.apply(other, ignore_nonexistent); }
     void                    config_apply_only(const ConfigBase &other, const t_config_option_keys &keys, bool ignore_nonexistent = false) { this->m_config.apply_only(other, keys, ignore_nonexistent); }
@@ -205,6 +189,9 @@ private:
     bool                    invalidate_step(PrintObjectStep step);
     // Invalidates all PrintObject and Print steps.
     bool                    invalidate_all_steps();
+    // Invalidates the slicing step after the layer height profile of the ModelObject was edited,
+    // while keeping the layers for reuse by the next slicing run at the Z heights, which did not change.
+    bool                    invalidate_layer_height_profile();
     // Invalidate steps based on a set of parameters changed.
     bool                    invalidate_state_by_config_options(const std::vector<t_config_option_key> &opt_keys);
     // If ! m_slicing_params.valid, recalculate.
@@ -221,6 +208,7 @@ private:
     void generate_support_material();
 
     void _slice(const std::vector<coordf_t> &layer_height_profile);
+    bool infill_reused(size_t layer_idx) const;
     std::string _fix_slicing_errors();
     void simplify_slices(double distance);
     bool has_support_material() const;
@@ -252,6 +240,46 @@ private:
     // so that next call to make_perimeters() performs a union() before computing loops
     bool                    				m_typed_slices = false;
 
+    // Layers kept by invalidate_layer_height_profile() for the next slicing run.
+    struct LayersReuse {
+        // Which results of the kept layers are valid. Any other invalidation of the respective steps clears the flag.
+        bool                                slices      = false;
+        bool                                perimeters  = false;
+        bool                                infill      = false;
+        // Indexed by m_layers: Index of the layer before the layer height profile was edited, -1 for a newly sliced layer.
+        std::vector<int>                    old_index;
+        size_t                              old_count   = 0;
+        // Indexed by m_layers and regions: Fill surfaces of the layers with reused perimeters as they were before
+        // prepare_infill() was executed again, to decide whether the infill of the layer may be reused.
+        std::vector<std::vector<Surfaces>>  fill_surfaces;
+
+        bool layer_reused(size_t idx) const { return idx < old_index.size() && old_index[idx] != -1; }
+        // Perimeters depend on the layer below (overhangs) and on the layer above (extra perimeters).
+        bool perimeters_reused(size_t idx) const {
+            if (! this->perimeters || ! this->layer_reused(idx))
+                return false;
+            int  i     = old_index[idx];
+            bool below = idx == 0 ? i == 0 : this->layer_reused(idx - 1) && old_index[idx - 1] + 1 == i;
+            bool above = idx + 1 == old_index.size() ? size_t(i + 1) == old_count : this->layer_reused(idx + 1) && old_index[idx + 1] == i + 1;
+            return below && above;
+        }
+        void clear() { *this = LayersReuse(); }
+    };
+    LayersReuse                             m_layers_reuse;
+
+    // Meshes of the model volumes transformed into the object coordinate system together with their slicers, keyed by the IDs
+    // of the volumes merged into the mesh. Shared by slice_volume(), slice_modifiers() and slice_support_volumes(), so that
+    // a mesh sliced repeatedly is transformed and indexed just once. Only accessed by the slicing and support generation steps
+    // of this object, which do not run concurrently, and released at their start and end.
+    struct VolumeSlicer {
+        TriangleMesh                        mesh;
+        TriangleMeshSlicer                  slicer;
+    };
+    mutable std::map<std::vector<ObjectID>, std::unique_ptr<VolumeSlicer>> m_volume_slicers;
+    // Returns nullptr if the volumes contain no facets.
+    const TriangleMeshSlicer* volume_slicer(const std::vector<const ModelVolume*> &volumes) const;
+    void                    release_volume_slicers() { m_volume_slicers.clear(); }
+
     std::vector<ExPolygons> slice_region(size_t region_id, const std::vector<float> &z, SlicingMode mode) const;
     std::vector<ExPolygons> slice_modifiers(size_t region_id, const std::vector<float> &z) const;
     std::vector<ExPolygons> slice_volumes(const std::vector<float> &z, SlicingMode mode, const std::vector<const ModelVolume*> &volumes) const;
@@ -362,7 +390,12 @@ public:
     void                process() override;
     // Exports G-code into a file name based on the path_template, returns the file path of the generated G-code file.
     // If preview_data is not null, the preview_data is filled in for the G-code visualization (not used by the command line Slic3r).
-    std::string         export_gcode(const std::string& path_template, GCodePreviewData* preview_data, ThumbnailsGeneratorCallback thumbnail_cb = nullptr);
+    // With release_extrusions set, the layer data no longer needed by the G-code generator is released before the export
+    // and the extrusions of the layers are released while being exported to lower the peak memory (command line slicer, --memory-budget).
+    // The object steps are invalidated afterwards.
+    // The export only starts after process() finished: The tool ordering and the wipe tower need the extrusions of all layers,
+    // and the support material is generated top down, therefore the bottom layers are not final until the whole print is processed.
+    std::string         export_gcode(const std::string& path_template, GCodePreviewData* preview_data, ThumbnailsGeneratorCallback thumbnail_cb = nullptr, bool release_extrusions = false);
 
     // methods for handling state
     bool                is_step_done(PrintStep step) const { return Inherited::is_step_done(step); }
@@ -374,6 +407,14 @@ public:
     bool                has_infinite_skirt() const;
     bool                has_skirt() const;
 
+    // Memory held by the layers of all objects.
+    LayerMemoryUsage    memory_usage() const;
+
+    // Directory of the persistent cache of the sliced layers (see SliceCache.hpp), shared between slicer runs.
+    // The cache is disabled if empty.
+    void                set_slice_cache_dir(const std::string &dir) { m_slice_cache_dir = dir; }
+    const std::string&  slice_cache_dir() const { return m_slice_cache_dir; }
+
     // Returns an empty string if valid, otherwise returns an error message.
     std::string         validate() const override;
     double              skirt_first_layer_height() const;
@@ -451,6 +492,11 @@ private:
     void                _make_brim();
     void                _make_wipe_tower();
     void                finalize_first_layer_convex_hull();
+    void                release_fill_surfaces();
+    void                invalidate_released_extrusions();
+    // Status of a PrintObject step. process() runs the steps of multiple objects concurrently,
+    // only the first object reaching a step reports it, so that the progress never goes backwards.
+    void                set_object_step_status(int percent, const std::string &message);
 
     // Islands of objects and their supports extruded at the 1st layer.
     Polygons            first_layer_islands() const;
@@ -484,6 +530,12 @@ private:
     // Estimated print time, filament consumed.
     PrintStatistics                         m_print_statistics;
 
+    std::string                             m_slice_cache_dir;
+
+    // Highest percent reported by set_object_step_status() since the start of process().
+    tbb::mutex                              m_object_step_status_mutex;
+    int                                     m_object_step_status_percent = -1;
+
     // To allow GCode to set the Print's GCodeExport step status.
     friend class GCode;
     // Allow PrintObject to access m_mutex and m_cancel_callback.
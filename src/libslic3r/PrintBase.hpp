@@ -2,6 +2,7 @@
 #define slic3r_PrintBase_hpp_
 
 #include "libslic3r.h"
+#include <chrono>
 #include <set>
 #include <vector>
 #include <string>
@@ -116,6 +117,12 @@ public:
         return this->state_with_timestamp_unguarded(step).state == DONE;
     }
 
+    // Wall clock time in seconds spent by the last execution of a step, which is DONE. Zero if the step is not DONE.
+    double duration(StepType step, tbb::mutex &mtx) const {
+        tbb::mutex::scoped_lock lock(mtx);
+        return m_state[step].state == DONE ? m_duration[step] : 0.;
+    }
+
     // Set the step as started. Block on mutex while the Print / PrintObject / PrintRegion objects are being
     // modified by the UI thread.
     // This is necessary to block until the Print::apply() updates its state, which may
@@ -145,6 +152,7 @@ public:
         state.timestamp = ++ g_last_timestamp;
         state.mark_warnings_non_current();
         m_step_active = static_cast<int>(step);
+        m_time_started[step] = std::chrono::steady_clock::now();
         return true;
     }
 
@@ -164,6 +172,7 @@ public:
         state.state = DONE;
         state.timestamp = ++ g_last_timestamp;
         m_step_active = -1;
+        m_duration[step] = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_time_started[step]).count();
         // Remove all non-current warnings.
     	auto it = std::remove_if(state.warnings.begin(), state.warnings.end(), [](const auto &w) { return ! w.current; });
     	bool update_warning_ui = false;
@@ -300,6 +309,9 @@ private:
     // If the background processing is canceled, m_step_active may not be resetted
     // to -1, see the comment in this->set_started().
     int                 m_step_active = -1;
+    // Time of the last set_started() of each step, and the time spent until set_done() for reporting of the step durations.
+    std::chrono::steady_clock::time_point m_time_started[COUNT];
+    double              m_duration[COUNT] = {};
 };
 
 class PrintBase;
@@ -502,6 +514,8 @@ public:
     bool            is_step_done(PrintStepEnum step) const { return m_state.is_done(step, this->state_mutex()); }
 	PrintStateBase::StateWithTimeStamp step_state_with_timestamp(PrintStepEnum step) const { return m_state.state_with_timestamp(step, this->state_mutex()); }
     PrintStateBase::StateWithWarnings  step_state_with_warnings(PrintStepEnum step) const { return m_state.state_with_warnings(step, this->state_mutex()); }
+    // Wall clock time in seconds spent by the last execution of a step, see PrintState::duration().
+    double          step_duration(PrintStepEnum step) const { return m_state.duration(step, this->state_mutex()); }
 
 protected:
     bool            set_started(PrintStepEnum step) { return m_state.set_started(step, this->state_mutex(), [this](){ this->throw_if_canceled(); }); }
@@ -548,6 +562,8 @@ public:
     bool            is_step_done(PrintObjectStepEnum step) const { return m_state.is_done(step, PrintObjectBase::state_mutex(m_print)); }
     PrintStateBase::StateWithTimeStamp step_state_with_timestamp(PrintObjectStepEnum step) const { return m_state.state_with_timestamp(step, PrintObjectBase::state_mutex(m_print)); }
     PrintStateBase::StateWithWarnings  step_state_with_warnings(PrintObjectStepEnum step) const { return m_state.state_with_warnings(step, PrintObjectBase::state_mutex(m_print)); }
+    // Wall clock time in seconds spent by the last execution of a step, see PrintState::duration().
+    double          step_duration(PrintObjectStepEnum step) const { return m_state.duration(step, PrintObjectBase::state_mutex(m_print)); }
 
 protected:
 	PrintObjectBaseWithState(PrintType *print, ModelObject *model_object) : PrintObjectBase(model_object), m_print(print) {}
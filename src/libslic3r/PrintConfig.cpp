@@ -2,6 +2,7 @@
 #include "I18N.hpp"
 
 #include <set>
+#include <unordered_map>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/format.hpp>
@@ -572,6 +573,14 @@ void PrintConfigDef::init_fff_params()
     def->mode = comAdvanced;
     def->set_default_value(new ConfigOptionFloatOrPercent(0, false));
 
+    def = this->add("fast_extrusion_ordering", coBool);
+    def->label = L("Fast ordering of large layers");
+    def->tooltip = L("Order the infill and the support lines of large layers (2048 lines or more) by a faster greedy search, "
+                   "which does not try to shorten the travel moves by exchanging the lines afterwards. "
+                   "This reduces the slicing time of large prints considerably at the cost of somewhat longer travel moves.");
+    def->mode = comExpert;
+    def->set_default_value(new ConfigOptionBool(false));
+
     def = this->add("fan_always_on", coBools);
     def->label = L("Keep fan always on");
     def->tooltip = L("If this is enabled, fan will never be disabled and will be kept running at least "
@@ -3434,6 +3443,114 @@ std::string FullPrintConfig::validate()
     return "";
 }
 
+const PrintStepDependency* print_step_dependency(const t_config_option_key &opt_key)
+{
+    static const std::unordered_map<t_config_option_key, PrintStepDependency> dependencies = []() {
+        std::unordered_map<t_config_option_key, PrintStepDependency> out;
+        auto add = [&out](const std::vector<PrintStep> &print_steps, const std::vector<PrintObjectStep> &object_steps, std::initializer_list<const char*> opt_keys) {
+            for (const char *opt_key : opt_keys) {
+                assert(out.find(opt_key) == out.end());
+                out.emplace(opt_key, PrintStepDependency{ print_steps, object_steps });
+            }
+        };
+
+        // PrintConfig
+        // The plenty of parameters, which influence the G-code generator only,
+        // or they are only notes not influencing the generated G-code.
+        add({ psGCodeExport }, {}, {
+            "avoid_crossing_perimeters", "bed_shape", "bed_temperature", "before_layer_gcode", "between_objects_gcode",
+            "bridge_acceleration", "bridge_fan_speed", "color_change_gcode", "colorprint_heights", "cooling",
+            "default_acceleration", "deretract_speed", "disable_fan_first_layers", "duplicate_distance",
+            "end_gcode", "end_filament_gcode", "extrusion_axis", "extruder_clearance_height", "extruder_clearance_radius",
+            "extruder_colour", "extruder_offset", "extrusion_multiplier", "fan_always_on", "fan_below_layer_time",
+            "filament_colour", "filament_diameter", "filament_density", "filament_load_time", "filament_notes",
+            "filament_cost", "filament_unload_time", "first_layer_acceleration", "first_layer_bed_temperature", "first_layer_speed",
+            "gcode_comments", "gcode_label_objects", "infill_acceleration", "layer_gcode",
+            "machine_max_acceleration_x", "machine_max_acceleration_y", "machine_max_acceleration_z", "machine_max_acceleration_e",
+            "machine_max_feedrate_x", "machine_max_feedrate_y", "machine_max_feedrate_z", "machine_max_feedrate_e",
+            "machine_max_acceleration_extruding", "machine_max_acceleration_retracting",
+            "machine_max_jerk_x", "machine_max_jerk_y", "machine_max_jerk_z", "machine_max_jerk_e",
+            "machine_min_travel_rate", "machine_min_extruding_rate",
+            "min_fan_speed", "max_fan_speed", "max_print_height", "min_print_speed", "max_print_speed", "max_volumetric_speed",
+#ifdef HAS_PRESSURE_EQUALIZER
+            "max_volumetric_extrusion_rate_slope_positive", "max_volumetric_extrusion_rate_slope_negative",
+#endif /* HAS_PRESSURE_EQUALIZER */
+            "notes", "only_retract_when_crossing_perimeters", "output_filename_format", "pause_print_gcode",
+            "perimeter_acceleration", "post_process", "printer_model", "printer_notes", "remaining_times",
+            "retract_before_travel", "retract_before_wipe", "retract_layer_change", "retract_length", "retract_length_toolchange",
+            "retract_lift", "retract_lift_above", "retract_lift_below", "retract_restart_extra", "retract_restart_extra_toolchange",
+            "retract_speed", "silent_mode", "single_extruder_multi_material_priming", "slowdown_below_layer_time",
+            "standby_temperature_delta", "start_gcode", "start_filament_gcode", "template_custom_gcode", "toolchange_gcode",
+            "threads", "travel_speed", "use_firmware_retraction", "use_relative_e_distances", "use_volumetric_e",
+            "variable_layer_height", "wipe",
+            // Only used by the wipe tower dialog of the GUI to fill in the wiping_volumes_matrix.
+            "wipe_tower_per_color_wipe", "wiping_volumes_extruders" });
+        add({ psSkirt }, {}, {
+            "skirts", "skirt_height", "draft_shield", "skirt_distance", "min_skirt_length", "ooze_prevention",
+            "wipe_tower_x", "wipe_tower_y", "wipe_tower_rotation_angle" });
+        add({ psBrim, psSkirt }, {}, { "brim_width" });
+        // The tool ordering and the wipe tower depend on these.
+        add({ psWipeTower, psSkirt }, {}, {
+            "complete_objects", "filament_type", "filament_soluble", "filament_loading_speed", "filament_loading_speed_start",
+            "filament_unloading_speed", "filament_unloading_speed_start", "filament_toolchange_delay", "filament_cooling_moves",
+            "filament_minimal_purge_on_wipe_tower", "filament_cooling_initial_speed", "filament_cooling_final_speed",
+            "filament_ramming_parameters", "filament_max_volumetric_speed", "gcode_flavor", "high_current_on_filament_swap",
+            "infill_first", "single_extruder_multi_material", "wipe_tower", "wipe_tower_width", "wipe_tower_bridging",
+            "wipe_tower_no_sparse_layers", "wiping_volumes_matrix", "parking_pos_retraction", "cooling_tube_retraction",
+            "cooling_tube_length", "extra_loading_move", "z_offset" });
+        // Read by the infill and support generators and by the G-code generator when ordering the infill and support extrusions.
+        add({ psGCodeExport }, { posInfill, posSupportMaterial }, { "fast_extrusion_ordering" });
+        // Read by the wipe tower generator only, see Print::invalidate_state_by_config_options().
+        add({ psWipeTower }, {}, { "temperature", "first_layer_temperature" });
+        add({ psSkirt, psBrim }, { posPerimeters, posInfill, posSupportMaterial }, {
+            "first_layer_extrusion_width", "min_layer_height", "max_layer_height" });
+        // Spiral Vase forces different kind of slicing than the normal model:
+        // In Spiral Vase mode, holes are closed and only the largest area contour is kept at each layer.
+        // Therefore toggling the Spiral Vase on / off requires complete reslicing.
+        add({}, { posSlice }, { "nozzle_diameter", "resolution", "spiral_vase" });
+
+        // PrintObjectConfig and PrintRegionConfig
+        add({}, { posSlice }, {
+            "layer_height", "first_layer_height", "raft_layers", "slice_closing_radius",
+            "clip_multipart_objects", "elefant_foot_compensation", "support_material_contact_distance", "xy_size_compensation" });
+        add({}, { posPerimeters }, {
+            "perimeters", "extra_perimeters", "gap_fill_speed", "overhangs", "perimeter_extrusion_width",
+            "infill_overlap", "thin_walls", "external_perimeters_first" });
+        add({}, { posPerimeters, posPrepareInfill }, { "fill_density", "solid_infill_extrusion_width" });
+        add({}, { posPerimeters, posSupportMaterial }, { "extrusion_width", "external_perimeter_extrusion_width", "perimeter_extruder" });
+        add({}, { posPrepareInfill }, {
+            "interface_shells", "infill_only_where_needed", "infill_every_layers", "solid_infill_every_layers",
+            "bottom_solid_layers", "bottom_solid_min_thickness", "top_solid_layers", "top_solid_min_thickness",
+            "solid_infill_below_area", "infill_extruder", "solid_infill_extruder", "infill_extrusion_width",
+            "ensure_vertical_shell_thickness", "bridge_angle" });
+        // The ironing extrusions are added to the infill extrusions, they are regenerated together with the infill.
+        add({}, { posInfill }, {
+            "top_fill_pattern", "bottom_fill_pattern", "external_fill_link_max_length", "fill_angle", "fill_pattern",
+            "fill_link_max_length", "top_infill_extrusion_width",
+            "ironing", "ironing_type", "ironing_flowrate", "ironing_spacing", "ironing_speed" });
+        // Refined by PrintObject::invalidate_state_by_config_options() based on support_material_contact_distance.
+        add({}, { posSupportMaterial }, { "support_material" });
+        add({}, { posPerimeters, posInfill, posSupportMaterial }, { "bridge_flow_ratio" });
+        add({}, { posSupportMaterial }, {
+            "support_material_auto", "support_material_angle", "support_material_buildplate_only",
+            "support_material_enforce_layers", "support_material_extruder", "support_material_extrusion_width",
+            "support_material_interface_layers", "support_material_interface_contact_loops", "support_material_interface_extruder",
+            "support_material_interface_spacing", "support_material_pattern", "support_material_xy_spacing",
+            "support_material_spacing", "support_material_synchronize_layers", "support_material_inflate_first_layer",
+            "support_material_threshold", "support_material_with_sheath", "dont_support_bridges" });
+        // perimeter_speed and external_perimeter_speed are refined by PrintObject::invalidate_state_by_config_options()
+        // for the objects with multiple regions.
+        add({ psGCodeExport }, {}, {
+            "seam_position", "seam_preferred_direction", "seam_preferred_direction_jitter",
+            "support_material_speed", "support_material_interface_speed", "bridge_speed", "external_perimeter_speed",
+            "infill_speed", "perimeter_speed", "small_perimeter_speed", "solid_infill_speed", "top_solid_infill_speed" });
+        add({ psWipeTower }, {}, { "wipe_into_infill", "wipe_into_objects" });
+        return out;
+    }();
+    auto it = dependencies.find(opt_key);
+    return it == dependencies.end() ? nullptr : &it->second;
+}
+
 // Declare the static caches for each StaticPrintConfig derived class.
 StaticPrintConfig::StaticCache<class Slic3r::PrintObjectConfig> PrintObjectConfig::s_cache_PrintObjectConfig;
 StaticPrintConfig::StaticCache<class Slic3r::PrintRegionConfig> PrintRegionConfig::s_cache_PrintRegionConfig;
@@ -3642,6 +3759,29 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->label = L("Data directory");
     def->tooltip = L("Load and store settings at the given directory. This is useful for maintaining different profiles or including configurations from a network storage.");
 
+    def = this->add("memory_report", coString);
+    def->label = L("Memory report");
+    def->tooltip = L("Write the memory held by the sliced print, broken down by the print objects and their data structures, "
+                     "to the specified file in the JSON format.");
+
+    def = this->add("memory_budget", coBool);
+    def->label = L("Lower the export memory");
+    def->tooltip = L("Lower the peak memory of the G-code export by releasing the fill surfaces before the export "
+                     "and the extrusions and islands of each layer once its G-code is generated.");
+
+    def = this->add("slice_cache", coString);
+    def->label = L("Slice cache directory");
+    def->tooltip = L("Store the sliced layers of the objects at the given directory and reuse them when slicing the same objects "
+                     "with the same settings again. Only the slicing into layers is reused, the perimeters, the infill "
+                     "and the support material are generated again. The directory may be shared by multiple slicer instances. "
+                     "The size of the cache is not limited, the stored files are never removed by the slicer.");
+
+    def = this->add("trace", coString);
+    def->label = L("Trace file");
+    def->tooltip = L("Trace the slicing steps and the tasks executed by the worker threads into the specified file "
+                     "in the Chrome trace event format, to be viewed with chrome://tracing. "
+                     "The SLIC3R_TRACE environment variable may be used instead.");
+
     def = this->add("loglevel", coInt);
     def->label = L("Logging level");
     def->tooltip = L("Sets logging sensitivity. 0:fatal, 1:error, 2:warning, 3:info, 4:debug, 5:trace\n"
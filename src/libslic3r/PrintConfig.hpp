@@ -72,6 +72,26 @@ enum SLAPillarConnectionMode {
     slapcmDynamic
 };
 
+// Print step IDs for keeping track of the print state.
+enum PrintStep {
+    psSkirt, 
+    psBrim,
+    // Synonym for the last step before the Wipe Tower / Tool Ordering, for the G-code preview slider to understand that 
+    // all the extrusions are there for the layer slider to add color changes etc.
+    psExtrusionPaths = psBrim,
+    psWipeTower,
+    // psToolOrdering is a synonym to psWipeTower, as the Wipe Tower calculates and modifies the ToolOrdering,
+    // while if printing without the Wipe Tower, the ToolOrdering is calculated as well.
+    psToolOrdering = psWipeTower,
+    psGCodeExport,
+    psCount,
+};
+
+enum PrintObjectStep {
+    posSlice, posPerimeters, posPrepareInfill,
+    posInfill, posIroning, posSupportMaterial, posCount,
+};
+
 template<> inline const t_config_enum_values& ConfigOptionEnum<PrinterTechnology>::get_enum_values() {
     static t_config_enum_values keys_map;
     if (keys_map.empty()) {
@@ -808,6 +828,7 @@ public:
     ConfigOptionPoints              extruder_offset;
     ConfigOptionBools               fan_always_on;
     ConfigOptionInts                fan_below_layer_time;
+    ConfigOptionBool                fast_extrusion_ordering;
     ConfigOptionStrings             filament_colour;
     ConfigOptionStrings             filament_notes;
     ConfigOptionFloat               first_layer_acceleration;
@@ -881,6 +902,7 @@ protected:
         OPT_PTR(extruder_offset);
         OPT_PTR(fan_always_on);
         OPT_PTR(fan_below_layer_time);
+        OPT_PTR(fast_extrusion_ordering);
         OPT_PTR(filament_colour);
         OPT_PTR(filament_notes);
         OPT_PTR(first_layer_acceleration);
@@ -981,6 +1003,22 @@ protected:
     }
 };
 
+// Steps of the FFF slicing pipeline reading an option of the PrintConfig, PrintObjectConfig or PrintRegionConfig,
+// to be invalidated by Print::invalidate_state_by_config_options() and PrintObject::invalidate_state_by_config_options()
+// on a change of the option. Invalidating a step invalidates the steps depending on it, see Print::invalidate_step()
+// and PrintObject::invalidate_step(), therefore only the first steps reading the option are listed.
+struct PrintStepDependency
+{
+    // Steps of the Print. Just psGCodeExport for the options read by the G-code generator only
+    // or for the notes exported into the G-code.
+    std::vector<PrintStep>          print_steps;
+    // Steps of the PrintObjects printing with the modified config.
+    std::vector<PrintObjectStep>    object_steps;
+};
+
+// Returns nullptr for an option not listed in the dependency table, all the steps are to be invalidated on its change.
+const PrintStepDependency*  print_step_dependency(const t_config_option_key &opt_key);
+
 // This object is mapped to Perl as Slic3r::Config::PrintRegion.
 class SLAPrintConfig : public StaticPrintConfig
 {
@@ -8,6 +8,8 @@
 #include "SupportMaterial.hpp"
 #include "Surface.hpp"
 #include "Slicing.hpp"
+#include "SliceCache.hpp"
+#include "Trace.hpp"
 #include "Utils.hpp"
 
 #include <utility>
@@ -106,21 +108,37 @@ void PrintObject::slice()
 {
     if (! this->set_started(posSlice))
         return;
-    m_print->set_status(10, L("Processing triangulated mesh"));
+    Trace::Scope trace("PrintObject::slice", "object", this->id);
+    m_print->set_object_step_status(10, L("Processing triangulated mesh"));
+    // Volume slicers left over by a canceled slicing run may refer to outdated volumes.
+    this->release_volume_slicers();
     std::vector<coordf_t> layer_height_profile;
     this->update_layer_height_profile(*this->model_object(), m_slicing_params, layer_height_profile);
     m_print->throw_if_canceled();
-    this->_slice(layer_height_profile);
-    m_print->throw_if_canceled();
-    // Fix the model.
-    //FIXME is this the right place to do? It is done repeateadly at the UI and now here at the backend.
-    std::string warning = this->_fix_slicing_errors();
-    m_print->throw_if_canceled();
-    if (! warning.empty())
-        BOOST_LOG_TRIVIAL(info) << warning;
-    // Simplify slices if required.
-    if (m_print->config().resolution)
-        this->simplify_slices(scale_(this->print()->config().resolution));
+    // Key of the slices in the persistent slice cache. The cache is not used if some layers are kept for reuse
+    // after the layer height profile was edited, as their slices may have been typed by detect_surfaces_type().
+    std::string slice_cache_key;
+    if (! m_print->slice_cache_dir().empty() && ! m_layers_reuse.slices)
+        slice_cache_key = SliceCache::key(*this, layer_height_profile);
+    if (! slice_cache_key.empty() && SliceCache::load(m_print->slice_cache_dir(), slice_cache_key, *this)) {
+        m_layers_reuse.clear();
+        m_typed_slices = false;
+    } else {
+        this->_slice(layer_height_profile);
+        m_print->throw_if_canceled();
+        // Fix the model.
+        //FIXME is this the right place to do? It is done repeateadly at the UI and now here at the backend.
+        std::string warning = this->_fix_slicing_errors();
+        m_print->throw_if_canceled();
+        if (! warning.empty())
+            BOOST_LOG_TRIVIAL(info) << warning;
+        // Simplify slices if required.
+        if (m_print->config().resolution)
+            this->simplify_slices(scale_(this->print()->config().resolution));
+        if (! slice_cache_key.empty() && ! m_layers.empty())
+            SliceCache::store(m_print->slice_cache_dir(), slice_cache_key, *this);
+    }
+    this->release_volume_slicers();
     // Update bounding boxes
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, m_layers.size()),
@@ -149,8 +167,9 @@ void PrintObject::make_perimeters()
 
     if (! this->set_started(posPerimeters))
         return;
+    Trace::Scope trace("PrintObject::make_perimeters", "object", this->id);
 
-    m_print->set_status(20, L("Generating perimeters"));
+    m_print->set_object_step_status(20, L("Generating perimeters"));
     BOOST_LOG_TRIVIAL(info) << "Generating perimeters..." << log_memory_info();
     
     // merge slices if they were split into types
@@ -233,12 +252,25 @@ void PrintObject::make_perimeters()
     }
 
     BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - start";
+    if (m_layers_reuse.infill && m_layers_reuse.fill_surfaces.empty())
+        m_layers_reuse.fill_surfaces.assign(m_layers.size(), std::vector<Surfaces>());
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, m_layers.size()),
         [this](const tbb::blocked_range<size_t>& range) {
             for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                 m_print->throw_if_canceled();
-                m_layers[layer_idx]->make_perimeters();
+                Trace::Scope trace("Layer::make_perimeters", "layer", layer_idx);
+                Layer *layer = m_layers[layer_idx];
+                if (m_layers_reuse.perimeters_reused(layer_idx)) {
+                    // Neither this layer nor its neighbors changed after the layer height profile was edited, keep the perimeters.
+                    // Remember the final fill surfaces for reuse of the infill, revert the fill surfaces to the output of the perimeter generator.
+                    if (m_layers_reuse.infill && m_layers_reuse.fill_surfaces[layer_idx].empty())
+                        for (LayerRegion *layerm : layer->m_regions)
+                            m_layers_reuse.fill_surfaces[layer_idx].emplace_back(std::move(layerm->fill_surfaces.surfaces));
+                    for (LayerRegion *layerm : layer->m_regions)
+                        layerm->fill_surfaces.set(layerm->fill_expolygons, stInternal);
+                } else
+                    layer->make_perimeters();
             }
         }
     );
@@ -246,14 +278,16 @@ void PrintObject::make_perimeters()
     BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - end";
 
     this->set_done(posPerimeters);
+    m_layers_reuse.perimeters = false;
 }
 
 void PrintObject::prepare_infill()
 {
     if (! this->set_started(posPrepareInfill))
         return;
+    Trace::Scope trace("PrintObject::prepare_infill", "object", this->id);
 
-    m_print->set_status(30, L("Preparing infill"));
+    m_print->set_object_step_status(30, L("Preparing infill"));
 
     // This will assign a type (top/bottom/internal) to $layerm->slices.
     // Then the classifcation of $layerm->slices is transfered onto 
@@ -369,13 +403,27 @@ void PrintObject::infill()
     this->prepare_infill();
 
     if (this->set_started(posInfill)) {
+        Trace::Scope trace("PrintObject::infill", "object", this->id);
+        m_print->set_object_step_status(70, L("Infilling layers"));
         BOOST_LOG_TRIVIAL(debug) << "Filling layers in parallel - start";
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size()),
             [this](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
-                    m_layers[layer_idx]->make_fills();
+                    Trace::Scope trace("Layer::make_fills", "layer", layer_idx);
+                    if (this->infill_reused(layer_idx)) {
+                        // Keep the infill, but remove the ironing, which will be generated again.
+                        for (LayerRegion *layerm : m_layers[layer_idx]->m_regions)
+                            layerm->fills.entities.erase(std::remove_if(layerm->fills.entities.begin(), layerm->fills.entities.end(), 
+                                [](ExtrusionEntity *ee) { 
+                                    if (ee->role() != erIroning)
+                                        return false;
+                                    delete ee;
+                                    return true;
+                                }), layerm->fills.entities.end());
+                    } else
+                        m_layers[layer_idx]->make_fills();
                 }
             }
         );
@@ -385,18 +433,44 @@ void PrintObject::infill()
         ### $_->fill_surfaces->clear for map @{$_->regions}, @{$object->layers};
         */
         this->set_done(posInfill);
+        m_layers_reuse.clear();
     }
 }
 
+// Infill of a layer kept after an edit of the layer height profile may be reused if the layer has the same ID (the infill
+// patterns are aligned by the layer ID), its perimeters were reused and prepare_infill() produced the same fill surfaces.
+bool PrintObject::infill_reused(size_t layer_idx) const
+{
+    if (! m_layers_reuse.infill || layer_idx >= m_layers_reuse.fill_surfaces.size() || m_layers_reuse.old_index[layer_idx] != int(layer_idx))
+        return false;
+    const std::vector<Surfaces> &old_fill_surfaces = m_layers_reuse.fill_surfaces[layer_idx];
+    const LayerRegionPtrs       &layerms           = m_layers[layer_idx]->m_regions;
+    if (old_fill_surfaces.size() != layerms.size())
+        return false;
+    for (size_t region_id = 0; region_id < layerms.size(); ++ region_id) {
+        const Surfaces &surfaces_old = old_fill_surfaces[region_id];
+        const Surfaces &surfaces_new = layerms[region_id]->fill_surfaces.surfaces;
+        if (! std::equal(surfaces_old.begin(), surfaces_old.end(), surfaces_new.begin(), surfaces_new.end(), 
+                [](const Surface &s1, const Surface &s2) {
+                    return s1.surface_type == s2.surface_type && s1.thickness == s2.thickness && s1.thickness_layers == s2.thickness_layers &&
+                           s1.bridge_angle == s2.bridge_angle && s1.extra_perimeters == s2.extra_perimeters && s1.expolygon == s2.expolygon;
+                }))
+            return false;
+    }
+    return true;
+}
+
 void PrintObject::ironing()
 {
     if (this->set_started(posIroning)) {
+        Trace::Scope trace("PrintObject::ironing", "object", this->id);
         BOOST_LOG_TRIVIAL(debug) << "Ironing in parallel - start";
         tbb::parallel_for(
             tbb::blocked_range<size_t>(1, m_layers.size()),
             [this](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
+                    Trace::Scope trace("Layer::make_ironing", "layer", layer_idx);
                     m_layers[layer_idx]->make_ironing();
                 }
             }
@@ -410,10 +484,13 @@ void PrintObject::ironing()
 void PrintObject::generate_support_material()
 {
     if (this->set_started(posSupportMaterial)) {
+        Trace::Scope trace("PrintObject::generate_support_material", "object", this->id);
         this->clear_support_layers();
         if ((m_config.support_material || m_config.raft_layers > 0) && m_layers.size() > 1) {
-            m_print->set_status(85, L("Generating support material"));    
+            m_print->set_object_step_status(85, L("Generating support material"));    
+            this->release_volume_slicers();
             this->_generate_support_material();
+            this->release_volume_slicers();
             m_print->throw_if_canceled();
         } else {
 #if 0
@@ -430,11 +507,28 @@ void PrintObject::generate_support_material()
 
 void PrintObject::clear_layers()
 {
-    for (Layer *l : m_layers)
-        delete l;
+    // Releasing the extrusions of a large print means freeing millions of small blocks.
+    // The layers do not share any data, therefore they are released in parallel.
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, m_layers.size()),
+        [this](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx)
+                delete m_layers[layer_idx];
+        });
     m_layers.clear();
 }
 
+LayerMemoryUsage PrintObject::memory_usage() const
+{
+    LayerMemoryUsage out;
+    out.layers += SLIC3R_STDVEC_MEMSIZE(m_layers, Layer*) + SLIC3R_STDVEC_MEMSIZE(m_support_layers, SupportLayer*);
+    for (const Layer *layer : m_layers)
+        layer->memory_usage(out);
+    for (const SupportLayer *layer : m_support_layers)
+        layer->memory_usage(out);
+    return out;
+}
+
 Layer* PrintObject::add_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z)
 {
     m_layers.emplace_back(new Layer(id, this, height, print_z, slice_z));
@@ -443,8 +537,12 @@ Layer* PrintObject::add_layer(int id, coordf_t height, coordf_t print_z, coordf_
 
 void PrintObject::clear_support_layers()
 {
-    for (Layer *l : m_support_layers)
-        delete l;
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, m_support_layers.size()),
+        [this](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx)
+                delete m_support_layers[layer_idx];
+        });
     m_support_layers.clear();
 }
 
@@ -469,125 +567,31 @@ bool PrintObject::invalidate_state_by_config_options(const std::vector<t_config_
     std::vector<PrintObjectStep> steps;
     bool invalidated = false;
     for (const t_config_option_key &opt_key : opt_keys) {
-        if (   opt_key == "perimeters"
-            || opt_key == "extra_perimeters"
-            || opt_key == "gap_fill_speed"
-            || opt_key == "overhangs"
-            || opt_key == "first_layer_extrusion_width"
-            || opt_key == "perimeter_extrusion_width"
-            || opt_key == "infill_overlap"
-            || opt_key == "thin_walls"
-            || opt_key == "external_perimeters_first") {
-            steps.emplace_back(posPerimeters);
-        } else if (
-               opt_key == "layer_height"
-            || opt_key == "first_layer_height"
-            || opt_key == "raft_layers"
-            || opt_key == "slice_closing_radius") {
-            steps.emplace_back(posSlice);
-		} else if (
-               opt_key == "clip_multipart_objects"
-            || opt_key == "elefant_foot_compensation"
-            || opt_key == "support_material_contact_distance" 
-            || opt_key == "xy_size_compensation") {
-            steps.emplace_back(posSlice);
-        } else if (opt_key == "support_material") {
-            steps.emplace_back(posSupportMaterial);
-            if (m_config.support_material_contact_distance == 0.) {
-            	// Enabling / disabling supports while soluble support interface is enabled.
-            	// This changes the bridging logic (bridging enabled without supports, disabled with supports).
-            	// Reset everything.
-            	// See GH #1482 for details.
-	            steps.emplace_back(posSlice);
-	        }
-        } else if (
-        	   opt_key == "support_material_auto"
-            || opt_key == "support_material_angle"
-            || opt_key == "support_material_buildplate_only"
-            || opt_key == "support_material_enforce_layers"
-            || opt_key == "support_material_extruder"
-            || opt_key == "support_material_extrusion_width"
-            || opt_key == "support_material_interface_layers"
-            || opt_key == "support_material_interface_contact_loops"
-            || opt_key == "support_material_interface_extruder"
-            || opt_key == "support_material_interface_spacing"
-            || opt_key == "support_material_pattern"
-            || opt_key == "support_material_xy_spacing"
-            || opt_key == "support_material_spacing"
-            || opt_key == "support_material_synchronize_layers"
-            || opt_key == "support_material_inflate_first_layer"
-            || opt_key == "support_material_threshold"
-            || opt_key == "support_material_with_sheath"
-            || opt_key == "dont_support_bridges"
-            || opt_key == "first_layer_extrusion_width") {
-            steps.emplace_back(posSupportMaterial);
-        } else if (
-               opt_key == "interface_shells"
-            || opt_key == "infill_only_where_needed"
-            || opt_key == "infill_every_layers"
-            || opt_key == "solid_infill_every_layers"
-            || opt_key == "bottom_solid_layers"
-            || opt_key == "bottom_solid_min_thickness"
-            || opt_key == "top_solid_layers"
-            || opt_key == "top_solid_min_thickness"
-            || opt_key == "solid_infill_below_area"
-            || opt_key == "infill_extruder"
-            || opt_key == "solid_infill_extruder"
-            || opt_key == "infill_extrusion_width"
-            || opt_key == "ensure_vertical_shell_thickness"
-            || opt_key == "bridge_angle") {
-            steps.emplace_back(posPrepareInfill);
-        } else if (
-               opt_key == "top_fill_pattern"
-            || opt_key == "bottom_fill_pattern"
-            || opt_key == "external_fill_link_max_length"
-            || opt_key == "fill_angle"
-            || opt_key == "fill_pattern"
-            || opt_key == "fill_link_max_length"
-            || opt_key == "top_infill_extrusion_width"
-            || opt_key == "first_layer_extrusion_width") {
-            steps.emplace_back(posInfill);
-        } else if (
-               opt_key == "fill_density"
-            || opt_key == "solid_infill_extrusion_width") {
-            steps.emplace_back(posPerimeters);
-            steps.emplace_back(posPrepareInfill);
-        } else if (
-               opt_key == "external_perimeter_extrusion_width"
-            || opt_key == "perimeter_extruder") {
-            steps.emplace_back(posPerimeters);
-            steps.emplace_back(posSupportMaterial);
-        } else if (opt_key == "bridge_flow_ratio") {
-            if (m_config.support_material_contact_distance > 0.) {
-            	// Only invalidate due to bridging if bridging is enabled.
-            	// If later "support_material_contact_distance" is modified, the complete PrintObject is invalidated anyway.
-            	steps.emplace_back(posPerimeters);
-            	steps.emplace_back(posInfill);
-	            steps.emplace_back(posSupportMaterial);
-	        }
-        } else if (
-               opt_key == "seam_position"
-            || opt_key == "seam_preferred_direction"
-            || opt_key == "seam_preferred_direction_jitter"
-            || opt_key == "support_material_speed"
-            || opt_key == "support_material_interface_speed"
-            || opt_key == "bridge_speed"
-            || opt_key == "external_perimeter_speed"
-            || opt_key == "infill_speed"
-            || opt_key == "perimeter_speed"
-            || opt_key == "small_perimeter_speed"
-            || opt_key == "solid_infill_speed"
-            || opt_key == "top_solid_infill_speed") {
-            invalidated |= m_print->invalidate_step(psGCodeExport);
-        } else if (
-               opt_key == "wipe_into_infill"
-            || opt_key == "wipe_into_objects") {
-            invalidated |= m_print->invalidate_step(psWipeTower);
-            invalidated |= m_print->invalidate_step(psGCodeExport);
-        } else {
+        // The steps reading the option are listed by the dependency table in PrintConfig.cpp.
+        const PrintStepDependency *dependency = print_step_dependency(opt_key);
+        if (dependency == nullptr) {
             // for legacy, if we can't handle this option let's invalidate all steps
             this->invalidate_all_steps();
             invalidated = true;
+            continue;
+        }
+        if (opt_key == "bridge_flow_ratio" && m_config.support_material_contact_distance == 0.)
+            // Only invalidate due to bridging if bridging is enabled.
+            // If later "support_material_contact_distance" is modified, the complete PrintObject is invalidated anyway.
+            continue;
+        append(steps, dependency->object_steps);
+        for (PrintStep step : dependency->print_steps)
+            invalidated |= m_print->invalidate_step(step);
+        if (opt_key == "support_material" && m_config.support_material_contact_distance == 0.) {
+            // Enabling / disabling supports while soluble support interface is enabled.
+            // This changes the bridging logic (bridging enabled without supports, disabled with supports).
+            // Reset everything.
+            // See GH #1482 for details.
+            steps.emplace_back(posSlice);
+        } else if ((opt_key == "perimeter_speed" || opt_key == "external_perimeter_speed") &&
+            std::count_if(this->region_volumes.begin(), this->region_volumes.end(), [](const auto &volumes) { return ! volumes.empty(); }) > 1) {
+            // Layer::make_perimeters() merges the regions of a layer with the same perimeter settings including these speeds.
+            steps.emplace_back(posPerimeters);
         }
     }
 
@@ -600,17 +604,27 @@ bool PrintObject::invalidate_state_by_config_options(const std::vector<t_config_
 bool PrintObject::invalidate_step(PrintObjectStep step)
 {
 	bool invalidated = Inherited::invalidate_step(step);
+
+    // The layers kept after an edit of the layer height profile no longer hold valid results of this step and of the depending steps.
+    if (step == posSlice)
+        m_layers_reuse.clear();
+    else if (step == posPerimeters)
+        m_layers_reuse.perimeters = m_layers_reuse.infill = false;
+    else if (step == posPrepareInfill || step == posInfill)
+        m_layers_reuse.infill = false;
     
     // propagate to dependent steps
     if (step == posPerimeters) {
-		invalidated |= this->invalidate_steps({ posPrepareInfill, posInfill });
+		invalidated |= this->invalidate_steps({ posPrepareInfill, posInfill, posIroning });
         invalidated |= m_print->invalidate_steps({ psSkirt, psBrim });
     } else if (step == posPrepareInfill) {
         invalidated |= this->invalidate_step(posInfill);
     } else if (step == posInfill) {
+        // The ironing extrusions are stored with the infill extrusions.
+        invalidated |= Inherited::invalidate_step(posIroning);
         invalidated |= m_print->invalidate_steps({ psSkirt, psBrim });
     } else if (step == posSlice) {
-		invalidated |= this->invalidate_steps({ posPerimeters, posPrepareInfill, posInfill, posSupportMaterial });
+		invalidated |= this->invalidate_steps({ posPerimeters, posPrepareInfill, posInfill, posIroning, posSupportMaterial });
 		invalidated |= m_print->invalidate_steps({ psSkirt, psBrim });
         this->m_slicing_params.valid = false;
     } else if (step == posSupportMaterial) {
@@ -634,9 +648,25 @@ bool PrintObject::invalidate_all_steps()
 	// Then reset some of the depending values.
 	this->m_slicing_params.valid = false;
 	this->region_volumes.clear();
+	this->m_layers_reuse.clear();
 	return result;
 }
 
+bool PrintObject::invalidate_layer_height_profile()
+{
+    // Which steps were finished for all layers before the edit. Called from Print::apply() with the state mutex locked.
+    bool slices_done     = this->is_step_done_unguarded(posSlice);
+    bool perimeters_done = slices_done && this->is_step_done_unguarded(posPerimeters);
+    bool infill_done     = perimeters_done && this->is_step_done_unguarded(posPrepareInfill) && this->is_step_done_unguarded(posInfill);
+    bool invalidated     = this->invalidate_step(posSlice);
+    // Ironing is added to the infill extrusions, it will be recalculated for the reused infill as well.
+    invalidated |= Inherited::invalidate_step(posIroning);
+    m_layers_reuse.slices     = slices_done;
+    m_layers_reuse.perimeters = perimeters_done;
+    m_layers_reuse.infill     = infill_done;
+    return invalidated;
+}
+
 bool PrintObject::has_support_material() const
 {
     return m_config.support_material
@@ -1613,7 +1643,13 @@ void PrintObject::_slice(const std::vector<coordf_t> &layer_height_profile)
 {
     BOOST_LOG_TRIVIAL(info) << "Slicing objects..." << log_memory_info();
 
-    m_typed_slices = false;
+    // Layers kept by invalidate_layer_height_profile() are reused if their Z heights did not change.
+    // The slices of the reused layers may have been typed by detect_surfaces_type().
+    bool reuse_layers = m_layers_reuse.slices && ! m_layers.empty();
+    m_layers_reuse.slices = false;
+    if (! reuse_layers)
+        m_layers_reuse.clear();
+    m_typed_slices = reuse_layers && m_typed_slices;
 
 #ifdef SLIC3R_PROFILE
     // Disable parallelization so the Shiny profiler works
@@ -1622,30 +1658,72 @@ void PrintObject::_slice(const std::vector<coordf_t> &layer_height_profile)
 #endif
 
     // 1) Initialize layers and their slice heights.
-    std::vector<float> slice_zs;
+    std::vector<float>  slice_zs;
+    // Indices of the layers to be sliced, matching slice_zs. All layers are sliced unless some layers are reused.
+    std::vector<size_t> sliced_layers;
     {
-        this->clear_layers();
+        LayerPtrs old_layers;
+        if (reuse_layers) {
+            old_layers = std::move(m_layers);
+            m_layers.clear();
+            m_layers_reuse.old_count = old_layers.size();
+        } else
+            this->clear_layers();
         // Object layers (pairs of bottom/top Z coordinate), without the raft.
         std::vector<coordf_t> object_layers = generate_object_layers(m_slicing_params, layer_height_profile);
         // Reserve object layers for the raft. Last layer of the raft is the contact layer.
         int id = int(m_slicing_params.raft_layers());
         slice_zs.reserve(object_layers.size());
+        sliced_layers.reserve(object_layers.size());
         Layer *prev = nullptr;
+        size_t idx_old_layer = 0;
         for (size_t i_layer = 0; i_layer < object_layers.size(); i_layer += 2) {
             coordf_t lo = object_layers[i_layer];
             coordf_t hi = object_layers[i_layer + 1];
             coordf_t slice_z = 0.5 * (lo + hi);
-            Layer *layer = this->add_layer(id ++, hi - lo, hi + m_slicing_params.object_print_z_min, slice_z);
-            slice_zs.push_back(float(slice_z));
+            coordf_t print_z = hi + m_slicing_params.object_print_z_min;
+            Layer   *layer   = nullptr;
+            if (reuse_layers) {
+                // Find an old layer at the same height. Both the old and the new layers are sorted by print_z.
+                for (; idx_old_layer < old_layers.size() && old_layers[idx_old_layer]->print_z < print_z - EPSILON; ++ idx_old_layer) ;
+                if (idx_old_layer < old_layers.size() && (idx_old_layer == 0) == (m_layers.empty()) &&
+                    std::abs(old_layers[idx_old_layer]->print_z - print_z) < EPSILON && std::abs(old_layers[idx_old_layer]->height - (hi - lo)) < EPSILON) {
+                    layer = old_layers[idx_old_layer];
+                    old_layers[idx_old_layer] = nullptr;
+                    layer->set_id(id ++);
+                    layer->height  = hi - lo;
+                    layer->print_z = print_z;
+                    layer->slice_z = slice_z;
+                    layer->upper_layer = layer->lower_layer = nullptr;
+                    // Bridges are collected again by prepare_infill().
+                    for (LayerRegion *layerm : layer->m_regions) {
+                        layerm->bridged.clear();
+                        layerm->unsupported_bridge_edges.clear();
+                    }
+                    m_layers.emplace_back(layer);
+                    m_layers_reuse.old_index.emplace_back(int(idx_old_layer ++));
+                }
+            }
+            if (layer == nullptr) {
+                layer = this->add_layer(id ++, hi - lo, print_z, slice_z);
+                slice_zs.push_back(float(slice_z));
+                sliced_layers.push_back(m_layers.size() - 1);
+                if (reuse_layers)
+                    m_layers_reuse.old_index.emplace_back(-1);
+                // Make sure all layers contain layer region objects for all regions.
+                for (size_t region_id = 0; region_id < this->region_volumes.size(); ++ region_id)
+                    layer->add_region(this->print()->regions()[region_id]);
+            }
             if (prev != nullptr) {
                 prev->upper_layer = layer;
                 layer->lower_layer = prev;
             }
-            // Make sure all layers contain layer region objects for all regions.
-            for (size_t region_id = 0; region_id < this->region_volumes.size(); ++ region_id)
-                layer->add_region(this->print()->regions()[region_id]);
             prev = layer;
         }
+        for (Layer *layer : old_layers)
+            delete layer;
+        if (reuse_layers)
+            BOOST_LOG_TRIVIAL(debug) << "Slicing objects - reusing " << m_layers.size() - sliced_layers.size() << " layers out of " << m_layers.size();
     }
 
     // Count model parts and modifier meshes, check whether the model parts are of the same region.
@@ -1691,7 +1769,7 @@ void PrintObject::_slice(const std::vector<coordf_t> &layer_height_profile)
             m_print->throw_if_canceled();
             BOOST_LOG_TRIVIAL(debug) << "Slicing objects - append slices " << region_id << " start";
             for (size_t layer_id = 0; layer_id < expolygons_by_layer.size(); ++ layer_id)
-                m_layers[layer_id]->regions()[region_id]->slices.append(std::move(expolygons_by_layer[layer_id]), stInternal);
+                m_layers[sliced_layers[layer_id]]->regions()[region_id]->slices.append(std::move(expolygons_by_layer[layer_id]), stInternal);
             m_print->throw_if_canceled();
             BOOST_LOG_TRIVIAL(debug) << "Slicing objects - append slices " << region_id << " end";
         }
@@ -1735,7 +1813,7 @@ void PrintObject::_slice(const std::vector<coordf_t> &layer_height_profile)
         BOOST_LOG_TRIVIAL(debug) << "Slicing objects - parallel clipping - start";
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, slice_zs.size()),
-            [this, &sliced_volumes, num_modifiers](const tbb::blocked_range<size_t>& range) {
+            [this, &sliced_volumes, &sliced_layers, num_modifiers](const tbb::blocked_range<size_t>& range) {
                 float delta   = float(scale_(m_config.xy_size_compensation.value));
                 // Only upscale together with clipping if there are no modifiers, as the modifiers shall be applied before upscaling
                 // (upscaling may grow the object outside of the modifier mesh).
@@ -1771,7 +1849,7 @@ void PrintObject::_slice(const std::vector<coordf_t> &layer_height_profile)
                         if (num_volumes > 1)
                             // Merge the islands using a positive / negative offset.
                             expolygons = offset_ex(offset_ex(expolygons, float(scale_(EPSILON))), -float(scale_(EPSILON)));
-                        m_layers[layer_id]->regions()[region_id]->slices.append(std::move(expolygons), stInternal);
+                        m_layers[sliced_layers[layer_id]]->regions()[region_id]->slices.append(std::move(expolygons), stInternal);
                     }
                 }
             });
@@ -1792,13 +1870,13 @@ void PrintObject::_slice(const std::vector<coordf_t> &layer_height_profile)
             // loop through the other regions and 'steal' the slices belonging to this one
             BOOST_LOG_TRIVIAL(debug) << "Slicing modifier volumes - stealing " << region_id << " start";
             tbb::parallel_for(
-                tbb::blocked_range<size_t>(0, m_layers.size()),
-				[this, &expolygons_by_layer, region_id](const tbb::blocked_range<size_t>& range) {
+                tbb::blocked_range<size_t>(0, sliced_layers.size()),
+				[this, &expolygons_by_layer, &sliced_layers, region_id](const tbb::blocked_range<size_t>& range) {
                     for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id) {
                         for (size_t other_region_id = 0; other_region_id < this->region_volumes.size(); ++ other_region_id) {
                             if (region_id == other_region_id)
                                 continue;
-                            Layer       *layer = m_layers[layer_id];
+                            Layer       *layer = m_layers[sliced_layers[layer_id]];
                             LayerRegion *layerm = layer->m_regions[region_id];
                             LayerRegion *other_layerm = layer->m_regions[other_region_id];
                             if (layerm == nullptr || other_layerm == nullptr || other_layerm->slices.empty() || expolygons_by_layer[layer_id].empty())
@@ -1828,6 +1906,10 @@ void PrintObject::_slice(const std::vector<coordf_t> &layer_height_profile)
         m_layers.pop_back();
 		if (! m_layers.empty())
 			m_layers.back()->upper_layer = nullptr;
+        if (! m_layers_reuse.old_index.empty())
+            m_layers_reuse.old_index.pop_back();
+        if (! sliced_layers.empty() && sliced_layers.back() == m_layers.size())
+            sliced_layers.pop_back();
     }
     m_print->throw_if_canceled();
 end:
@@ -1844,11 +1926,12 @@ end:
         // Uncompensated slices for the first layer in case the Elephant foot compensation is applied.
 	    ExPolygons  lslices_1st_layer;
 	    tbb::parallel_for(
-	        tbb::blocked_range<size_t>(0, m_layers.size()),
-			[this, upscaled, clipped, xy_compensation_scaled, elephant_foot_compensation_scaled, &lslices_1st_layer]
+	        tbb::blocked_range<size_t>(0, sliced_layers.size()),
+			[this, upscaled, clipped, xy_compensation_scaled, elephant_foot_compensation_scaled, &lslices_1st_layer, &sliced_layers]
 				(const tbb::blocked_range<size_t>& range) {
-	            for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id) {
+	            for (size_t idx_sliced = range.begin(); idx_sliced < range.end(); ++ idx_sliced) {
 	                m_print->throw_if_canceled();
+	                size_t layer_id = sliced_layers[idx_sliced];
 	                Layer *layer = m_layers[layer_id];
 	                // Apply size compensation and perform clipping of multi-part objects.
 	                float elfoot = (layer_id == 0) ? elephant_foot_compensation_scaled : 0.f;
@@ -1920,7 +2003,7 @@ end:
 	                layer->make_slices();
 	            }
 	        });
-	    if (elephant_foot_compensation_scaled > 0.f) {
+	    if (elephant_foot_compensation_scaled > 0.f && ! sliced_layers.empty() && sliced_layers.front() == 0) {
 	    	// The Elephant foot has been compensated, therefore the 1st layer's lslices are shrank with the Elephant foot compensation value.
 	    	// Store the uncompensated value there.
 	    	assert(! m_layers.empty());
@@ -2054,19 +2137,25 @@ std::vector<ExPolygons> PrintObject::slice_support_volumes(const ModelVolumeType
     return this->slice_volumes(zs, SlicingMode::Regular, volumes);
 }
 
-std::vector<ExPolygons> PrintObject::slice_volumes(const std::vector<float> &z, SlicingMode mode, const std::vector<const ModelVolume*> &volumes) const
+const TriangleMeshSlicer* PrintObject::volume_slicer(const std::vector<const ModelVolume*> &volumes) const
 {
-    std::vector<ExPolygons> layers;
-    if (! volumes.empty()) {
+    assert(! volumes.empty());
+    std::vector<ObjectID> key;
+    key.reserve(volumes.size());
+    for (const ModelVolume *volume : volumes)
+        key.emplace_back(volume->id());
+    auto it = m_volume_slicers.find(key);
+    if (it == m_volume_slicers.end()) {
+        std::unique_ptr<VolumeSlicer> volume_slicer(new VolumeSlicer);
         // Compose mesh.
         //FIXME better to perform slicing over each volume separately and then to use a Boolean operation to merge them.
-		TriangleMesh mesh(volumes.front()->mesh());
+        TriangleMesh &mesh = volume_slicer->mesh;
+        mesh = volumes.front()->mesh();
         mesh.transform(volumes.front()->get_matrix(), true);
-		assert(mesh.repaired);
-		if (volumes.size() == 1 && mesh.repaired) {
-			//FIXME The admesh repair function may break the face connectivity, rather refresh it here as the slicing code relies on it.
-			stl_check_facets_exact(&mesh.stl);
-		}
+        if (volumes.size() == 1 && mesh.repaired) {
+            //FIXME The admesh repair function may break the face connectivity, rather refresh it here as the slicing code relies on it.
+            stl_check_facets_exact(&mesh.stl);
+        }
         for (size_t idx_volume = 1; idx_volume < volumes.size(); ++ idx_volume) {
             const ModelVolume &model_volume = *volumes[idx_volume];
             TriangleMesh vol_mesh(model_volume.mesh());
@@ -2077,14 +2166,26 @@ std::vector<ExPolygons> PrintObject::slice_volumes(const std::vector<float> &z,
             mesh.transform(m_trafo, true);
             // apply XY shift
             mesh.translate(- unscale<float>(m_center_offset.x()), - unscale<float>(m_center_offset.y()), 0);
-            // perform actual slicing
             const Print *print = this->print();
-            auto callback = TriangleMeshSlicer::throw_on_cancel_callback_type([print](){print->throw_if_canceled();});
             // TriangleMeshSlicer needs shared vertices, also this calls the repair() function.
             mesh.require_shared_vertices();
-            TriangleMeshSlicer mslicer;
-            mslicer.init(&mesh, callback);
-			mslicer.slice(z, mode, float(m_config.slice_closing_radius.value), &layers, callback);
+            volume_slicer->slicer.init(&mesh, [print](){print->throw_if_canceled();});
+        } else
+            volume_slicer.reset();
+        it = m_volume_slicers.emplace(std::move(key), std::move(volume_slicer)).first;
+    }
+    return it->second ? &it->second->slicer : nullptr;
+}
+
+std::vector<ExPolygons> PrintObject::slice_volumes(const std::vector<float> &z, SlicingMode mode, const std::vector<const ModelVolume*> &volumes) const
+{
+    std::vector<ExPolygons> layers;
+    if (! volumes.empty()) {
+        const TriangleMeshSlicer *mslicer = this->volume_slicer(volumes);
+        if (mslicer != nullptr) {
+            // perform actual slicing
+            const Print *print = this->print();
+            mslicer->slice(z, mode, float(m_config.slice_closing_radius.value), &layers, [print](){print->throw_if_canceled();});
             m_print->throw_if_canceled();
         }
     }
@@ -2094,30 +2195,8 @@ std::vector<ExPolygons> PrintObject::slice_volumes(const std::vector<float> &z,
 std::vector<ExPolygons> PrintObject::slice_volume(const std::vector<float> &z, SlicingMode mode, const ModelVolume &volume) const
 {
     std::vector<ExPolygons> layers;
-    if (! z.empty()) {
-	    // Compose mesh.
-	    //FIXME better to split the mesh into separate shells, perform slicing over each shell separately and then to use a Boolean operation to merge them.
-	    TriangleMesh mesh(volume.mesh());
-	    mesh.transform(volume.get_matrix(), true);
-		if (mesh.repaired) {
-			//FIXME The admesh repair function may break the face connectivity, rather refresh it here as the slicing code relies on it.
-			stl_check_facets_exact(&mesh.stl);
-		}
-	    if (mesh.stl.stats.number_of_facets > 0) {
-	        mesh.transform(m_trafo, true);
-	        // apply XY shift
-	        mesh.translate(- unscale<float>(m_center_offset.x()), - unscale<float>(m_center_offset.y()), 0);
-	        // perform actual slicing
-	        TriangleMeshSlicer mslicer;
-	        const Print *print = this->print();
-	        auto callback = TriangleMeshSlicer::throw_on_cancel_callback_type([print](){print->throw_if_canceled();});
-	        // TriangleMeshSlicer needs the shared vertices.
-	        mesh.require_shared_vertices();
-	        mslicer.init(&mesh, callback);
-	        mslicer.slice(z, mode, float(m_config.slice_closing_radius.value), &layers, callback);
-	        m_print->throw_if_canceled();
-	    }
-	}
+    if (! z.empty())
+        layers = this->slice_volumes(z, mode, { &volume });
     return layers;
 }
 
@@ -2250,6 +2329,9 @@ void PrintObject::simplify_slices(double distance)
         [this, distance](const tbb::blocked_range<size_t>& range) {
             for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                 m_print->throw_if_canceled();
+                if (m_layers_reuse.layer_reused(layer_idx))
+                    // Already simplified.
+                    continue;
                 Layer *layer = m_layers[layer_idx];
                 for (size_t region_idx = 0; region_idx < layer->m_regions.size(); ++ region_idx)
                     layer->m_regions[region_idx]->slices.simplify(distance);
@@ -11,6 +11,7 @@
 #include <libslic3r/ElephantFootCompensation.hpp>
 
 #include <libslic3r/ClipperUtils.hpp>
+#include <libslic3r/Trace.hpp>
 
 // For geometry algorithms with native Clipper types (no copies and conversions)
 #include <libnest2d/backends/clipper/geometries.hpp>
@@ -53,6 +54,22 @@ std::string OBJ_STEP_LABELS(size_t idx)
     return "Out of bounds!";
 }
 
+// Names of the steps in the trace of the slicing process, see Trace.hpp.
+const std::array<const char*, slaposCount> OBJ_STEP_TRACE_NAMES = {
+    "SLAPrint::hollow_model",   // slaposHollowing,
+    "SLAPrint::drill_holes",    // slaposDrillHoles
+    "SLAPrint::slice_model",    // slaposObjectSlice,
+    "SLAPrint::support_points", // slaposSupportPoints,
+    "SLAPrint::support_tree",   // slaposSupportTree,
+    "SLAPrint::generate_pad",   // slaposPad,
+    "SLAPrint::slice_supports", // slaposSliceSupports,
+};
+
+const std::array<const char*, slapsCount> PRINT_STEP_TRACE_NAMES = {
+    "SLAPrint::merge_slices_and_eval_stats", // slapsMergeSlicesAndEval
+    "SLAPrint::rasterize",                   // slapsRasterize
+};
+
 const std::array<unsigned, slapsCount> PRINT_STEP_LEVELS = {
     10, // slapsMergeSlicesAndEval
     90, // slapsRasterize
@@ -841,6 +858,8 @@ void SLAPrint::Steps::rasterize()
     {
         PrintLayer& printlayer = m_print->m_printer_input[idx];
         if(canceled()) return;
+
+        Trace::Scope trace("SLAPrint::rasterize_layer", "layer", idx);
         
         for (const ClipperLib::Polygon& poly : printlayer.transformed_slices())
             raster.draw(poly);
@@ -886,6 +905,7 @@ double SLAPrint::Steps::progressrange(SLAPrintStep step) const
 
 void SLAPrint::Steps::execute(SLAPrintObjectStep step, SLAPrintObject &obj)
 {
+    Trace::Scope trace(step < slaposCount ? OBJ_STEP_TRACE_NAMES[step] : nullptr, "object", obj.id);
     switch(step) {
     case slaposHollowing: hollow_model(obj); break;
     case slaposDrillHoles: drill_holes(obj); break;
@@ -900,6 +920,7 @@ void SLAPrint::Steps::execute(SLAPrintObjectStep step, SLAPrintObject &obj)
 
 void SLAPrint::Steps::execute(SLAPrintStep step)
 {
+    Trace::Scope trace(step < slapsCount ? PRINT_STEP_TRACE_NAMES[step] : nullptr);
     switch (step) {
     case slapsMergeSlicesAndEval: merge_slices_and_eval_stats(); break;
     case slapsRasterize: rasterize(); break;
@@ -15,25 +15,195 @@
 
 namespace Slic3r {
 
+// Minimum number of segments, for which ChainingMode::Fast searches the closest end points with a grid hash instead of a KD tree.
+static constexpr size_t chaining_grid_min_segments = 256;
+
+// Closest point search over the end points of the segments being chained.
+// A KD tree cannot be updated, therefore the end points, which were already connected, stay in the tree and they are rejected
+// by the filter of the search, which slows down the search as the chain grows. The grid hash used by ChainingMode::Fast for larger
+// inputs removes the connected end points, and its search returns the same closest point as the KD tree up to the order of points
+// in the same distance.
+template<typename EndPointType>
+class EndPointSearch
+{
+public:
+	EndPointSearch(const std::vector<EndPointType> &end_points, bool use_grid) :
+		m_kdtree(CoordinateFn{ &end_points }), m_end_points(end_points)
+	{
+		if (use_grid)
+			this->build_grid();
+		else
+			m_kdtree.build(end_points.size());
+	}
+
+	// Remove a connected end point from the search. Only the grid hash removes the end points, the KD tree ignores the call.
+	void remove(size_t idx)
+	{
+		if (m_cell_begin.empty())
+			return;
+		size_t cell = m_cell_of[idx];
+		size_t slot = m_slot_of[idx];
+		if (slot >= m_cell_end[cell])
+			// Already removed.
+			return;
+		size_t last = -- m_cell_end[cell];
+		std::swap(m_slots[slot], m_slots[last]);
+		m_slot_of[m_slots[slot]] = slot;
+		m_slot_of[idx]           = last;
+		-- m_num_valid;
+	}
+
+	// Insert all the removed end points back.
+	void reset()
+	{
+		if (! m_cell_begin.empty()) {
+			std::copy(m_cell_begin.begin() + 1, m_cell_begin.end(), m_cell_end.begin());
+			m_num_valid = m_end_points.size();
+		}
+	}
+
+	// Index of the closest end point accepted by the filter, or size_t(-1) if there is none.
+	template<typename FilterFn>
+	size_t find_closest_point(const Vec2d &pt, FilterFn filter) const
+	{
+		if (m_cell_begin.empty())
+			return Slic3r::find_closest_point(m_kdtree, pt, filter);
+
+		size_t min_idx  = std::numeric_limits<size_t>::max();
+		double min_dist = std::numeric_limits<double>::max();
+		if (m_num_valid == 0)
+			return min_idx;
+		auto visit_cell = [this, &pt, &filter, &min_idx, &min_dist](int col, int row) {
+			size_t cell = size_t(row) * m_cols + size_t(col);
+			for (size_t i = m_cell_begin[cell]; i < m_cell_end[cell]; ++ i) {
+				size_t idx = m_slots[i];
+				if (filter(idx)) {
+					double dist = (m_end_points[idx].pos - pt).squaredNorm();
+					if (dist < min_dist || (dist == min_dist && idx < min_idx)) {
+						min_dist = dist;
+						min_idx  = idx;
+					}
+				}
+			}
+		};
+		int col = std::clamp(int(std::floor((pt.x() - m_origin.x()) / m_cell_size)), 0, m_cols - 1);
+		int row = std::clamp(int(std::floor((pt.y() - m_origin.y()) / m_cell_size)), 0, m_rows - 1);
+		int max_ring = std::max(std::max(col, m_cols - 1 - col), std::max(row, m_rows - 1 - row));
+		// Visit the rings of cells around the cell of pt. The end points outside of the first r rings are at least (r - 1) * m_cell_size far from pt.
+		for (int ring = 0; ring <= max_ring; ++ ring) {
+			if (min_idx != std::numeric_limits<size_t>::max() && min_dist < sqr(double(ring - 1) * m_cell_size))
+				break;
+			int col_min = col - ring;
+			int col_max = col + ring;
+			int row_min = row - ring;
+			int row_max = row + ring;
+			for (int c = std::max(col_min, 0); c <= std::min(col_max, m_cols - 1); ++ c) {
+				if (row_min >= 0)
+					visit_cell(c, row_min);
+				if (ring > 0 && row_max < m_rows)
+					visit_cell(c, row_max);
+			}
+			for (int r = std::max(row_min + 1, 0); r <= std::min(row_max - 1, m_rows - 1); ++ r) {
+				if (col_min >= 0 && ring > 0)
+					visit_cell(col_min, r);
+				if (col_max < m_cols && ring > 0)
+					visit_cell(col_max, r);
+			}
+		}
+		return min_idx;
+	}
+
+private:
+	struct CoordinateFn {
+		const std::vector<EndPointType> *end_points;
+		double operator()(size_t idx, size_t dimension) const { return (*end_points)[idx].pos[dimension]; }
+	};
+
+	void build_grid()
+	{
+		size_t num_points = m_end_points.size();
+		assert(num_points > 0);
+		BoundingBoxf bbox;
+		for (const EndPointType &ep : m_end_points)
+			bbox.merge(ep.pos);
+		Vec2d size = bbox.size();
+		// Aim at two end points per cell.
+		double area = std::max(size.x() * size.y(), sqr(std::max(size.x(), size.y())) / double(num_points));
+		m_cell_size = std::max(std::sqrt(2. * area / double(num_points)), 1.);
+		m_origin    = bbox.min;
+		m_cols      = int(size.x() / m_cell_size) + 1;
+		m_rows      = int(size.y() / m_cell_size) + 1;
+		size_t num_cells = size_t(m_cols) * size_t(m_rows);
+		// Bin the end points into the cells by a counting sort.
+		m_cell_of.assign(num_points, 0);
+		m_cell_begin.assign(num_cells + 1, 0);
+		for (size_t i = 0; i < num_points; ++ i) {
+			const Vec2d &pos = m_end_points[i].pos;
+			int col = std::min(int((pos.x() - m_origin.x()) / m_cell_size), m_cols - 1);
+			int row = std::min(int((pos.y() - m_origin.y()) / m_cell_size), m_rows - 1);
+			m_cell_of[i] = size_t(row) * m_cols + size_t(col);
+			++ m_cell_begin[m_cell_of[i] + 1];
+		}
+		for (size_t i = 1; i <= num_cells; ++ i)
+			m_cell_begin[i] += m_cell_begin[i - 1];
+		m_cell_end.assign(m_cell_begin.begin(), m_cell_begin.end() - 1);
+		m_slots.assign(num_points, 0);
+		m_slot_of.assign(num_points, 0);
+		for (size_t i = 0; i < num_points; ++ i) {
+			size_t slot = m_cell_end[m_cell_of[i]] ++;
+			m_slots[slot] = i;
+			m_slot_of[i]  = slot;
+		}
+		m_num_valid = num_points;
+	}
+
+	KDTreeIndirect<2, double, CoordinateFn> m_kdtree;
+	const std::vector<EndPointType>		   &m_end_points;
+
+	// Grid hash, empty if the KD tree is used.
+	Vec2d								m_origin { 0., 0. };
+	double								m_cell_size { 0. };
+	int									m_cols { 0 };
+	int									m_rows { 0 };
+	// Ranges of m_slots of the cells, the end points of a cell are stored at m_slots[m_cell_begin[cell]] to m_slots[m_cell_end[cell] - 1],
+	// the removed end points of a cell are stored at m_slots[m_cell_end[cell]] to m_slots[m_cell_begin[cell + 1] - 1].
+	std::vector<size_t>					m_cell_begin;
+	std::vector<size_t>					m_cell_end;
+	std::vector<size_t>					m_slots;
+	// Cell and position in m_slots of each end point.
+	std::vector<size_t>					m_cell_of;
+	std::vector<size_t>					m_slot_of;
+	size_t								m_num_valid { 0 };
+};
+
+template<typename EndPointType, typename PointType, typename FilterFn>
+size_t find_closest_point(const EndPointSearch<EndPointType> &search, const PointType &pt, FilterFn filter)
+{
+	return search.find_closest_point(Vec2d(pt), filter);
+}
+
 // Naive implementation of the Traveling Salesman Problem, it works by always taking the next closest neighbor.
 // This implementation will always produce valid result even if some segments cannot reverse.
-template<typename EndPointType, typename KDTreeType, typename CouldReverseFunc>
-std::vector<std::pair<size_t, bool>> chain_segments_closest_point(std::vector<EndPointType> &end_points, KDTreeType &kdtree, CouldReverseFunc &could_reverse_func, EndPointType &first_point)
+template<typename EndPointType, typename SearchType, typename CouldReverseFunc>
+std::vector<std::pair<size_t, bool>> chain_segments_closest_point(std::vector<EndPointType> &end_points, SearchType &kdtree, CouldReverseFunc &could_reverse_func, EndPointType &first_point)
 {
 	assert((end_points.size() & 1) == 0);
 	size_t num_segments = end_points.size() / 2;
 	assert(num_segments >= 2);
 	for (EndPointType &ep : end_points)
 		ep.chain_id = 0;
+	kdtree.reset();
 	std::vector<std::pair<size_t, bool>> out;
 	out.reserve(num_segments);
 	size_t first_point_idx = &first_point - end_points.data();
 	out.emplace_back(first_point_idx / 2, (first_point_idx & 1) != 0);
 	first_point.chain_id = 1;
+	kdtree.remove(first_point_idx);
 	size_t this_idx = first_point_idx ^ 1;
 	for (int iter = (int)num_segments - 2; iter >= 0; -- iter) {
 		EndPointType &this_point = end_points[this_idx];
     	this_point.chain_id = 1;
+		kdtree.remove(this_idx);
     	// Find the closest point to this end_point, which lies on a different extrusion path (filtered by the lambda).
     	// Ignore the starting point as the starting point is considered to be occupied, no end point coud connect to it.
 		size_t next_idx = find_closest_point(kdtree, this_point.pos,
@@ -43,6 +213,7 @@ std::vector<std::pair<size_t, bool>> chain_segments_closest_point(std::vector<En
 		assert(next_idx < end_points.size());
 		EndPointType &end_point = end_points[next_idx];
 		end_point.chain_id = 1;
+		kdtree.remove(next_idx);
 		assert((next_idx & 1) == 0 || could_reverse_func(next_idx >> 1));
 		out.emplace_back(next_idx / 2, (next_idx & 1) != 0);
 		this_idx = next_idx ^ 1;
@@ -64,7 +235,7 @@ std::vector<std::pair<size_t, bool>> chain_segments_closest_point(std::vector<En
 // is a simple path in the complete graph of cities. At each stage, the algorithm selects the edge of minimal cost that either creates 
 // a new fragment, extends one of the existing paths or creates a cycle of length equal to the number of cities.
 template<typename PointType, typename SegmentEndPointFunc, bool REVERSE_COULD_FAIL, typename CouldReverseFunc>
-std::vector<std::pair<size_t, bool>> chain_segments_greedy_constrained_reversals_(SegmentEndPointFunc end_point_func, CouldReverseFunc could_reverse_func, size_t num_segments, const PointType *start_near)
+std::vector<std::pair<size_t, bool>> chain_segments_greedy_constrained_reversals_(SegmentEndPointFunc end_point_func, CouldReverseFunc could_reverse_func, size_t num_segments, const PointType *start_near, ChainingMode mode)
 {
 	std::vector<std::pair<size_t, bool>> out;
 
@@ -100,9 +271,8 @@ std::vector<std::pair<size_t, bool>> chain_segments_greedy_constrained_reversals
             end_points.emplace_back(end_point_func(i, false).template cast<double>());
 	    }
 
-	    // Construct the closest point KD tree over end points of segments.
-		auto coordinate_fn = [&end_points](size_t idx, size_t dimension) -> double { return end_points[idx].pos[dimension]; };
-		KDTreeIndirect<2, double, decltype(coordinate_fn)> kdtree(coordinate_fn, end_points.size());
+	    // Construct the closest point KD tree over end points of segments, or a grid hash for large inputs chained by ChainingMode::Fast.
+		EndPointSearch<EndPoint> kdtree(end_points, mode == ChainingMode::Fast && num_segments >= chaining_grid_min_segments);
 
 		// Helper to detect loops in already connected paths.
 		// Unique chain IDs are assigned to paths. If paths are connected, end points will not have their chain IDs updated, but the chain IDs
@@ -174,6 +344,7 @@ std::vector<std::pair<size_t, bool>> chain_segments_greedy_constrained_reversals
 			first_point->distance_out = 0.;
 			first_point->chain_id = equivalent_chain.next();
 			first_point_idx = idx;
+			kdtree.remove(idx);
 		}
 		EndPoint *initial_point = first_point;
 		EndPoint *last_point = nullptr;
@@ -289,6 +460,8 @@ std::vector<std::pair<size_t, bool>> chain_segments_greedy_constrained_reversals
 								equivalent_chain.merge(end_point1_other_chain_id, end_point2_other_chain_id));
 				end_point1.chain_id = chain_id;
 				end_point2.chain_id = chain_id;
+				kdtree.remove(&end_point1 - &end_points.front());
+				kdtree.remove(&end_point2 - &end_points.front());
 				assert(validate_graph_and_queue());
 				if (iter == 0) {
 					// Last iteration. There shall be exactly one or two end points waiting to be connected.
@@ -512,8 +685,7 @@ std::vector<std::pair<size_t, bool>> chain_segments_greedy_constrained_reversals
 	    }
 
 	    // Construct the closest point KD tree over end points of segments.
-		auto coordinate_fn = [&end_points](size_t idx, size_t dimension) -> double { return end_points[idx].pos[dimension]; };
-		KDTreeIndirect<2, double, decltype(coordinate_fn)> kdtree(coordinate_fn, end_points.size());
+		EndPointSearch<EndPoint> kdtree(end_points, false);
 
 	    // Chained segments with their sum of connection lengths.
 	    // The chain supports flipping all the segments, connecting the segments at the opposite ends.
@@ -973,16 +1145,16 @@ std::vector<std::pair<size_t, bool>> chain_segments_greedy_constrained_reversals
 }
 
 template<typename PointType, typename SegmentEndPointFunc, typename CouldReverseFunc>
-std::vector<std::pair<size_t, bool>> chain_segments_greedy_constrained_reversals(SegmentEndPointFunc end_point_func, CouldReverseFunc could_reverse_func, size_t num_segments, const PointType *start_near)
+std::vector<std::pair<size_t, bool>> chain_segments_greedy_constrained_reversals(SegmentEndPointFunc end_point_func, CouldReverseFunc could_reverse_func, size_t num_segments, const PointType *start_near, ChainingMode mode = ChainingMode::Default)
 {
-	return chain_segments_greedy_constrained_reversals_<PointType, SegmentEndPointFunc, true, CouldReverseFunc>(end_point_func, could_reverse_func, num_segments, start_near);
+	return chain_segments_greedy_constrained_reversals_<PointType, SegmentEndPointFunc, true, CouldReverseFunc>(end_point_func, could_reverse_func, num_segments, start_near, mode);
 }
 
 template<typename PointType, typename SegmentEndPointFunc>
-std::vector<std::pair<size_t, bool>> chain_segments_greedy(SegmentEndPointFunc end_point_func, size_t num_segments, const PointType *start_near)
+std::vector<std::pair<size_t, bool>> chain_segments_greedy(SegmentEndPointFunc end_point_func, size_t num_segments, const PointType *start_near, ChainingMode mode = ChainingMode::Default)
 {
 	auto could_reverse_func = [](size_t /* idx */) -> bool { return true; };
-	return chain_segments_greedy_constrained_reversals_<PointType, SegmentEndPointFunc, false, decltype(could_reverse_func)>(end_point_func, could_reverse_func, num_segments, start_near);
+	return chain_segments_greedy_constrained_reversals_<PointType, SegmentEndPointFunc, false, decltype(could_reverse_func)>(end_point_func, could_reverse_func, num_segments, start_near, mode);
 }
 
 template<typename PointType, typename SegmentEndPointFunc, typename CouldReverseFunc>
@@ -998,11 +1170,11 @@ std::vector<std::pair<size_t, bool>> chain_segments_greedy2(SegmentEndPointFunc
 	return chain_segments_greedy_constrained_reversals2_<PointType, SegmentEndPointFunc, false, decltype(could_reverse_func)>(end_point_func, could_reverse_func, num_segments, start_near);
 }
 
-std::vector<std::pair<size_t, bool>> chain_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near)
+std::vector<std::pair<size_t, bool>> chain_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near, ChainingMode mode)
 {
 	auto segment_end_point = [&entities](size_t idx, bool first_point) -> const Point& { return first_point ? entities[idx]->first_point() : entities[idx]->last_point(); };
 	auto could_reverse = [&entities](size_t idx) { const ExtrusionEntity *ee = entities[idx]; return ee->is_loop() || ee->can_reverse(); };
-	std::vector<std::pair<size_t, bool>> out = chain_segments_greedy_constrained_reversals<Point, decltype(segment_end_point), decltype(could_reverse)>(segment_end_point, could_reverse, entities.size(), start_near);
+	std::vector<std::pair<size_t, bool>> out = chain_segments_greedy_constrained_reversals<Point, decltype(segment_end_point), decltype(could_reverse)>(segment_end_point, could_reverse, entities.size(), start_near, mode);
 	for (std::pair<size_t, bool> &segment : out) {
 		ExtrusionEntity *ee = entities[segment.first];
 		if (ee->is_loop())
@@ -1028,15 +1200,15 @@ void reorder_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const s
     entities.swap(out);
 }
 
-void chain_and_reorder_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near)
+void chain_and_reorder_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near, ChainingMode mode)
 {
-	reorder_extrusion_entities(entities, chain_extrusion_entities(entities, start_near));
+	reorder_extrusion_entities(entities, chain_extrusion_entities(entities, start_near, mode));
 }
 
-std::vector<std::pair<size_t, bool>> chain_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const Point *start_near)
+std::vector<std::pair<size_t, bool>> chain_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const Point *start_near, ChainingMode mode)
 {
 	auto segment_end_point = [&extrusion_paths](size_t idx, bool first_point) -> const Point& { return first_point ? extrusion_paths[idx].first_point() : extrusion_paths[idx].last_point(); };
-	return chain_segments_greedy<Point, decltype(segment_end_point)>(segment_end_point, extrusion_paths.size(), start_near);
+	return chain_segments_greedy<Point, decltype(segment_end_point)>(segment_end_point, extrusion_paths.size(), start_near, mode);
 }
 
 void reorder_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const std::vector<std::pair<size_t, bool>> &chain)
@@ -1052,9 +1224,9 @@ void reorder_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const
     extrusion_paths.swap(out);
 }
 
-void chain_and_reorder_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const Point *start_near)
+void chain_and_reorder_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const Point *start_near, ChainingMode mode)
 {
-	reorder_extrusion_paths(extrusion_paths, chain_extrusion_paths(extrusion_paths, start_near));
+	reorder_extrusion_paths(extrusion_paths, chain_extrusion_paths(extrusion_paths, start_near, mode));
 }
 
 std::vector<size_t> chain_points(const Points &points, Point *start_near)
@@ -1903,7 +2075,7 @@ static inline void improve_ordering_by_two_exchanges_with_segment_flipping(Polyl
 #endif /* NDEBUG */
 }
 
-Polylines chain_polylines(Polylines &&polylines, const Point *start_near)
+Polylines chain_polylines(Polylines &&polylines, const Point *start_near, ChainingMode mode)
 {
 #ifdef DEBUG_SVG_OUTPUT
 	static int iRun = 0;
@@ -1914,14 +2086,16 @@ Polylines chain_polylines(Polylines &&polylines, const Point *start_near)
 	Polylines out;
 	if (! polylines.empty()) {
 		auto segment_end_point = [&polylines](size_t idx, bool first_point) -> const Point& { return first_point ? polylines[idx].first_point() : polylines[idx].last_point(); };
-		std::vector<std::pair<size_t, bool>> ordered = chain_segments_greedy2<Point, decltype(segment_end_point)>(segment_end_point, polylines.size(), start_near);
+		std::vector<std::pair<size_t, bool>> ordered = (mode == ChainingMode::Fast) ?
+			chain_segments_greedy<Point, decltype(segment_end_point)>(segment_end_point, polylines.size(), start_near, mode) :
+			chain_segments_greedy2<Point, decltype(segment_end_point)>(segment_end_point, polylines.size(), start_near);
 		out.reserve(polylines.size()); 
 		for (auto &segment_and_reversal : ordered) {
 			out.emplace_back(std::move(polylines[segment_and_reversal.first]));
 			if (segment_and_reversal.second)
 				out.back().reverse();
 		}
-		if (out.size() > 1 && start_near == nullptr) {
+		if (out.size() > 1 && start_near == nullptr && mode != ChainingMode::Fast) {
 			improve_ordering_by_two_exchanges_with_segment_flipping(out, start_near != nullptr);
 			//improve_ordering_by_segment_flipping(out, start_near != nullptr);
 		}
@@ -12,18 +12,34 @@ namespace ClipperLib { class PolyNode; }
 
 namespace Slic3r {
 
+// Trade-off between the length of the travel moves and the time spent ordering the extrusions.
+enum class ChainingMode {
+	// Greedy chaining searching the closest end points with a KD tree,
+	// chain_polylines() improves the chain by two exchanges with segment flipping.
+	Default,
+	// Greedy chaining, for large inputs searching the closest end points with a grid hash, from which the connected end points are removed.
+	// chain_polylines() uses the simple greedy chaining and skips the exchanges.
+	Fast,
+};
+
+// With the fast_extrusion_ordering option enabled, the fill and the support generators chain by ChainingMode::Fast from this number
+// of polylines or extrusions on. The two exchanges of chain_polylines() take time quadratic in the number of polylines, they dominate
+// the infill generation of large layers. Chaining the extrusions by ChainingMode::Fast returns the same order.
+static constexpr size_t chaining_fast_min_segments = 2048;
+inline ChainingMode chaining_mode(bool fast, size_t num_segments) { return fast && num_segments >= chaining_fast_min_segments ? ChainingMode::Fast : ChainingMode::Default; }
+
 std::vector<size_t> 				 chain_points(const Points &points, Point *start_near = nullptr);
 
-std::vector<std::pair<size_t, bool>> chain_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near = nullptr);
+std::vector<std::pair<size_t, bool>> chain_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near = nullptr, ChainingMode mode = ChainingMode::Default);
 void                                 reorder_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const std::vector<std::pair<size_t, bool>> &chain);
-void                                 chain_and_reorder_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near = nullptr);
+void                                 chain_and_reorder_extrusion_entities(std::vector<ExtrusionEntity*> &entities, const Point *start_near = nullptr, ChainingMode mode = ChainingMode::Default);
 
-std::vector<std::pair<size_t, bool>> chain_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const Point *start_near = nullptr);
+std::vector<std::pair<size_t, bool>> chain_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const Point *start_near = nullptr, ChainingMode mode = ChainingMode::Default);
 void                                 reorder_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, std::vector<std::pair<size_t, bool>> &chain);
-void                                 chain_and_reorder_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const Point *start_near = nullptr);
+void                                 chain_and_reorder_extrusion_paths(std::vector<ExtrusionPath> &extrusion_paths, const Point *start_near = nullptr, ChainingMode mode = ChainingMode::Default);
 
-Polylines 							 chain_polylines(Polylines &&src, const Point *start_near = nullptr);
-inline Polylines 					 chain_polylines(const Polylines& src, const Point* start_near = nullptr) { Polylines tmp(src); return chain_polylines(std::move(tmp), start_near); }
+Polylines 							 chain_polylines(Polylines &&src, const Point *start_near = nullptr, ChainingMode mode = ChainingMode::Default);
+inline Polylines 					 chain_polylines(const Polylines& src, const Point* start_near = nullptr, ChainingMode mode = ChainingMode::Default) { Polylines tmp(src); return chain_polylines(std::move(tmp), start_near, mode); }
 
 std::vector<ClipperLib::PolyNode*>	 chain_clipper_polynodes(const Points &points, const std::vector<ClipperLib::PolyNode*> &items);
 
@@ -0,0 +1,260 @@
+#include "SliceCache.hpp"
+#include "Layer.hpp"
+#include "Model.hpp"
+#include "Print.hpp"
+
+#include "libslic3r_version.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/uuid/detail/sha1.hpp>
+
+namespace Slic3r {
+
+namespace SliceCache {
+
+// Increase with any change of the file format or of the data hashed into the key.
+static const uint32_t   format_version = 1;
+static const char       file_magic[4]  = { 'P', 'S', 'S', 'C' };
+
+class KeyHasher
+{
+public:
+    void add(const void *data, size_t size) { m_sha1.process_bytes(data, size); }
+    template<typename T> void add(const T &value)
+        { static_assert(std::is_arithmetic<T>::value, "KeyHasher::add(): Only scalars are hashed by value"); this->add(&value, sizeof(T)); }
+    // Strings are prefixed with their length, so that a sequence of strings hashes differently from their concatenation.
+    void add(const std::string &str) { this->add(uint64_t(str.size())); this->add(str.data(), str.size()); }
+    void add(const char *str) { this->add(std::string(str)); }
+
+    void add_config(const ConfigBase &config) {
+        for (const t_config_option_key &opt_key : config.keys()) {
+            this->add(opt_key);
+            this->add(config.opt_serialize(opt_key));
+        }
+    }
+
+    std::string hex_digest() {
+        boost::uuids::detail::sha1::digest_type digest;
+        m_sha1.get_digest(digest);
+        char buf[41];
+        for (int i = 0; i < 5; ++ i)
+            sprintf(buf + 8 * i, "%08x", (unsigned int)digest[i]);
+        return std::string(buf, 40);
+    }
+
+private:
+    boost::uuids::detail::sha1 m_sha1;
+};
+
+std::string key(const PrintObject &object, const std::vector<coordf_t> &layer_height_profile)
+{
+    KeyHasher hasher;
+    hasher.add(SLIC3R_VERSION);
+    hasher.add(format_version);
+    hasher.add(uint32_t(sizeof(coord_t)));
+
+    // The object placement and the slicing heights.
+    hasher.add(object.trafo().data(), sizeof(double) * 16);
+    hasher.add(object.center_offset().x());
+    hasher.add(object.center_offset().y());
+    hasher.add(uint64_t(layer_height_profile.size()));
+    hasher.add(layer_height_profile.data(), sizeof(coordf_t) * layer_height_profile.size());
+
+    // The print options invalidating posSlice, see print_step_dependency().
+    const PrintConfig &print_config = object.print()->config();
+    for (const t_config_option_key &opt_key : print_config.keys()) {
+        const PrintStepDependency *dependency = print_step_dependency(opt_key);
+        if (dependency == nullptr || std::find(dependency->object_steps.begin(), dependency->object_steps.end(), posSlice) != dependency->object_steps.end()) {
+            hasher.add(opt_key);
+            hasher.add(print_config.opt_serialize(opt_key));
+        }
+    }
+    // Any change of the object or region configuration is conservatively considered to change the slices.
+    hasher.add_config(object.config());
+
+    // The regions and their volumes, the same ModelVolume may be split to regions by the layer height ranges.
+    const ModelObject &model_object = *object.model_object();
+    hasher.add(uint64_t(object.region_volumes.size()));
+    for (size_t region_id = 0; region_id < object.region_volumes.size(); ++ region_id) {
+        hasher.add_config(object.print()->regions()[region_id]->config());
+        hasher.add(uint64_t(object.region_volumes[region_id].size()));
+        for (const std::pair<t_layer_height_range, int> &volume_and_range : object.region_volumes[region_id]) {
+            hasher.add(volume_and_range.first.first);
+            hasher.add(volume_and_range.first.second);
+            hasher.add(volume_and_range.second);
+        }
+    }
+    hasher.add(uint64_t(model_object.volumes.size()));
+    for (const ModelVolume *volume : model_object.volumes) {
+        hasher.add(int(volume->type()));
+        hasher.add(volume->get_matrix().data(), sizeof(double) * 16);
+        const stl_file &stl = volume->mesh().stl;
+        hasher.add(uint64_t(stl.facet_start.size()));
+        for (const stl_facet &facet : stl.facet_start)
+            hasher.add(facet.vertex, sizeof(facet.vertex));
+    }
+    return hasher.hex_digest();
+}
+
+static boost::filesystem::path cache_file_path(const std::string &dir, const std::string &key)
+{
+    return boost::filesystem::path(dir) / (key + ".slices");
+}
+
+template<typename T> static void write_value(std::ostream &os, const T &value) { os.write((const char*)&value, sizeof(T)); }
+
+static void write_expolygons(std::ostream &os, const ExPolygons &expolygons)
+{
+    auto write_polygon = [&os](const Polygon &polygon) {
+        write_value(os, uint64_t(polygon.points.size()));
+        os.write((const char*)polygon.points.data(), sizeof(Point) * polygon.points.size());
+    };
+    write_value(os, uint64_t(expolygons.size()));
+    for (const ExPolygon &expolygon : expolygons) {
+        write_polygon(expolygon.contour);
+        write_value(os, uint64_t(expolygon.holes.size()));
+        for (const Polygon &hole : expolygon.holes)
+            write_polygon(hole);
+    }
+}
+
+template<typename T> static T read_value(std::istream &is)
+{
+    T value;
+    if (! is.read((char*)&value, sizeof(T)))
+        throw std::runtime_error("Truncated slice cache file");
+    return value;
+}
+
+// Sizes are limited by the size of the file to fail early on a corrupted file instead of allocating a huge amount of memory.
+static size_t read_size(std::istream &is, size_t max_size)
+{
+    uint64_t size = read_value<uint64_t>(is);
+    if (size > max_size)
+        throw std::runtime_error("Corrupted slice cache file");
+    return size_t(size);
+}
+
+static ExPolygons read_expolygons(std::istream &is, size_t file_size)
+{
+    auto read_polygon = [&is, file_size](Polygon &polygon) {
+        polygon.points.assign(read_size(is, file_size / sizeof(Point)), Point());
+        if (! is.read((char*)polygon.points.data(), sizeof(Point) * polygon.points.size()))
+            throw std::runtime_error("Truncated slice cache file");
+    };
+    ExPolygons expolygons(read_size(is, file_size));
+    for (ExPolygon &expolygon : expolygons) {
+        read_polygon(expolygon.contour);
+        expolygon.holes.assign(read_size(is, file_size), Polygon());
+        for (Polygon &hole : expolygon.holes)
+            read_polygon(hole);
+    }
+    return expolygons;
+}
+
+// A layer read from the cache file, before it is added to the PrintObject.
+struct CachedLayer
+{
+    int                     id;
+    coordf_t                height;
+    coordf_t                print_z;
+    coordf_t                slice_z;
+    std::vector<ExPolygons> region_slices;
+    ExPolygons              lslices;
+};
+
+bool load(const std::string &dir, const std::string &key, PrintObject &object)
+{
+    boost::filesystem::path path = cache_file_path(dir, key);
+    boost::system::error_code ec;
+    if (! boost::filesystem::exists(path, ec))
+        return false;
+    // Read and validate the whole file first, the layers of the object are only replaced once the file is known to be valid.
+    std::vector<CachedLayer> layers;
+    size_t                   num_regions = object.region_volumes.size();
+    try {
+        size_t                  file_size = size_t(boost::filesystem::file_size(path));
+        boost::nowide::ifstream is(path.string(), std::ios::in | std::ios::binary);
+        char                    magic[4];
+        if (! is.read(magic, 4) || memcmp(magic, file_magic, 4) != 0 || read_value<uint32_t>(is) != format_version)
+            throw std::runtime_error("Invalid slice cache file");
+        layers.assign(read_size(is, file_size), CachedLayer());
+        if (read_size(is, file_size) != num_regions)
+            throw std::runtime_error("Invalid slice cache file");
+        for (CachedLayer &layer : layers) {
+            layer.id      = read_value<int>(is);
+            layer.height  = read_value<coordf_t>(is);
+            layer.print_z = read_value<coordf_t>(is);
+            layer.slice_z = read_value<coordf_t>(is);
+            layer.region_slices.reserve(num_regions);
+            for (size_t region_id = 0; region_id < num_regions; ++ region_id)
+                layer.region_slices.emplace_back(read_expolygons(is, file_size));
+            layer.lslices = read_expolygons(is, file_size);
+        }
+        if (! is.read(magic, 4) || memcmp(magic, file_magic, 4) != 0)
+            throw std::runtime_error("Truncated slice cache file");
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(warning) << "Failed to load the slices from " << path.string() << ": " << ex.what();
+        return false;
+    }
+
+    object.clear_layers();
+    Layer *prev = nullptr;
+    for (CachedLayer &cached_layer : layers) {
+        Layer *layer = object.add_layer(cached_layer.id, cached_layer.height, cached_layer.print_z, cached_layer.slice_z);
+        for (size_t region_id = 0; region_id < num_regions; ++ region_id)
+            layer->add_region(object.print()->regions()[region_id])->slices.append(std::move(cached_layer.region_slices[region_id]), stInternal);
+        layer->lslices = std::move(cached_layer.lslices);
+        if (prev != nullptr) {
+            prev->upper_layer = layer;
+            layer->lower_layer = prev;
+        }
+        prev = layer;
+    }
+    BOOST_LOG_TRIVIAL(info) << "Loaded " << object.layer_count() << " layers from the slice cache " << path.string();
+    return true;
+}
+
+void store(const std::string &dir, const std::string &key, const PrintObject &object)
+{
+    boost::filesystem::path path = cache_file_path(dir, key);
+    // Write into a temporary file first, then rename it: Other slicer processes sharing the cache never see a partially written file.
+    boost::filesystem::path path_tmp = path.parent_path() / boost::filesystem::unique_path(key + "-%%%%-%%%%.tmp");
+    try {
+        boost::filesystem::create_directories(path.parent_path());
+        {
+            boost::nowide::ofstream os(path_tmp.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+            os.write(file_magic, 4);
+            write_value(os, format_version);
+            write_value(os, uint64_t(object.layer_count()));
+            write_value(os, uint64_t(object.region_volumes.size()));
+            for (const Layer *layer : object.layers()) {
+                write_value(os, int(layer->id()));
+                write_value(os, layer->height);
+                write_value(os, layer->print_z);
+                write_value(os, layer->slice_z);
+                assert(layer->region_count() == object.region_volumes.size());
+                for (const LayerRegion *layerm : layer->regions())
+                    write_expolygons(os, to_expolygons(layerm->slices.surfaces));
+                write_expolygons(os, layer->lslices);
+            }
+            os.write(file_magic, 4);
+            if (! os)
+                throw std::runtime_error("Failed writing the file");
+        }
+        boost::filesystem::rename(path_tmp, path);
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(warning) << "Failed to store the slices to " << path.string() << ": " << ex.what();
+        boost::system::error_code ec;
+        boost::filesystem::remove(path_tmp, ec);
+    }
+}
+
+} // namespace SliceCache
+
+} // namespace Slic3r
@@ -0,0 +1,36 @@
+#ifndef slic3r_SliceCache_hpp_
+#define slic3r_SliceCache_hpp_
+
+#include "libslic3r.h"
+#include <string>
+#include <vector>
+
+namespace Slic3r {
+
+class PrintObject;
+
+// Persistent cache of the results of PrintObject::slice(), shared by all the slicer processes using the same directory.
+// The sliced layers are stored in a file named by a hash of the inputs of the slicing step:
+// The meshes and transformations of the volumes, the layer height profile, the PrintObjectConfig,
+// the PrintRegionConfigs of the regions of the object and the PrintConfig options the slicing depends on.
+// The cache is not bounded: The files are never evicted, it is up to the user to clean up the directory.
+// Only the command line slicer enables the cache (the --slice-cache option sets Print::set_slice_cache_dir()),
+// the BackgroundSlicingProcess of the GUI does not use it.
+// Only posSlice is cached. The perimeters, the infill and the support material are generated again after the layers
+// are loaded from the cache, as their extrusions are not serialized.
+namespace SliceCache {
+
+// Hash of the inputs of PrintObject::slice() as a hex string.
+std::string key(const PrintObject &object, const std::vector<coordf_t> &layer_height_profile);
+
+// Replace the layers of the object with the layers stored under the key: Their region slices and lslices, their lslices_bboxes are not filled in.
+// Returns false if the key was not found or the file is not valid, the layers of the object are left untouched then.
+bool        load(const std::string &dir, const std::string &key, PrintObject &object);
+// Store the sliced layers of the object under the key. Failing to write the cache is reported to the log only.
+void        store(const std::string &dir, const std::string &key, const PrintObject &object);
+
+} // namespace SliceCache
+
+} // namespace Slic3r
+
+#endif /* slic3r_SliceCache_hpp_ */
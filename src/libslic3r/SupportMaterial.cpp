@@ -1093,9 +1093,11 @@ PrintObjectSupportMaterial::MyLayersPtr PrintObjectSupportMaterial::top_contact_
     	                            // Offset the support regions back to a full overhang, restrict them to the full overhang.
     	                            // This is done to increase size of the supporting columns below, as they are calculated by 
     	                            // propagating these contact surfaces downwards.
-    	                            diff_polygons = diff(
-    	                                intersection(offset(diff_polygons, lower_layer_offset, SUPPORT_SURFACES_OFFSET_PARAMETERS), layerm_polygons), 
-    	                                lower_layer_polygons);
+    	                            diff_polygons = ClipperContext(diff_polygons)
+    	                                .offset(lower_layer_offset, SUPPORT_SURFACES_OFFSET_PARAMETERS)
+    	                                .intersection(layerm_polygons)
+    	                                .diff(lower_layer_polygons)
+    	                                .polygons();
     							}
                             }
                             if (! enforcers.empty()) {
@@ -1125,9 +1127,9 @@ PrintObjectSupportMaterial::MyLayersPtr PrintObjectSupportMaterial::top_contact_
                             // spanning just the projection between the two slices.
                             // Subtracting them as they are may leave unwanted narrow
                             // residues of diff_polygons that would then be supported.
-                            diff_polygons = diff(diff_polygons,
-                                offset(union_(to_polygons(std::move(blockers[layer_id]))),
-                                       1000.*SCALED_EPSILON));
+                            diff_polygons = ClipperContext(diff_polygons)
+                                .diff(ClipperContext(blockers[layer_id]).union_().offset(1000.*SCALED_EPSILON))
+                                .polygons();
                         }
 
                         #ifdef SLIC3R_DEBUG
@@ -3014,6 +3016,8 @@ void PrintObjectSupportMaterial::generate_toolpaths(
             std::unique_ptr<Fill> filler_support   = std::unique_ptr<Fill>(Fill::new_from_type(infill_pattern));
             filler_interface->set_bounding_box(bbox_object);
             filler_support->set_bounding_box(bbox_object);
+            filler_interface->fast_chaining = m_print_config->fast_extrusion_ordering.value;
+            filler_support->fast_chaining   = m_print_config->fast_extrusion_ordering.value;
 
             // Print the support base below the support columns, or the support base for the support columns plus the contacts.
             if (support_layer_id > 0) {
@@ -3117,6 +3121,8 @@ void PrintObjectSupportMaterial::generate_toolpaths(
         std::unique_ptr<Fill> filler_support   = std::unique_ptr<Fill>(Fill::new_from_type(infill_pattern));
         filler_interface->set_bounding_box(bbox_object);
         filler_support->set_bounding_box(bbox_object);
+        filler_interface->fast_chaining = m_print_config->fast_extrusion_ordering.value;
+        filler_support->fast_chaining   = m_print_config->fast_extrusion_ordering.value;
         for (size_t support_layer_id = range.begin(); support_layer_id < range.end(); ++ support_layer_id)
         {
             SupportLayer &support_layer = *object.support_layers()[support_layer_id];
@@ -0,0 +1,102 @@
+#include "Trace.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/nowide/fstream.hpp>
+
+namespace Slic3r {
+
+namespace Trace {
+
+std::atomic<bool> g_enabled { false };
+
+struct Event
+{
+    const char *name;
+    const char *arg_name;
+    int64_t     arg_value;
+    int64_t     time_start;
+    int64_t     time_end;
+};
+
+struct ThreadEvents
+{
+    // Thread ID as shown by the trace viewer, the threads are numbered in the order of recording their first event.
+    size_t              tid;
+    std::vector<Event>  events;
+};
+
+static std::chrono::steady_clock::time_point s_time_start;
+// Buffers of all the threads, which recorded an event. The buffers are never released, as they are referenced
+// by the thread local pointers: There are as many buffers as threads, which ever recorded an event.
+static std::mutex                                   s_threads_mutex;
+static std::vector<std::unique_ptr<ThreadEvents>>   s_threads;
+static thread_local ThreadEvents                   *t_events = nullptr;
+
+static ThreadEvents& thread_events()
+{
+    if (t_events == nullptr) {
+        std::lock_guard<std::mutex> lock(s_threads_mutex);
+        s_threads.emplace_back(new ThreadEvents);
+        t_events = s_threads.back().get();
+        t_events->tid = s_threads.size();
+    }
+    return *t_events;
+}
+
+void start()
+{
+    {
+        std::lock_guard<std::mutex> lock(s_threads_mutex);
+        for (std::unique_ptr<ThreadEvents> &thread : s_threads)
+            thread->events.clear();
+    }
+    s_time_start = std::chrono::steady_clock::now();
+    g_enabled.store(true, std::memory_order_release);
+}
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_time_start).count();
+}
+
+void add_event(const char *name, int64_t time_start, int64_t time_end, const char *arg_name, int64_t arg_value)
+{
+    thread_events().events.push_back({ name, arg_name, arg_value, time_start, time_end });
+}
+
+bool finish(const std::string &path)
+{
+    g_enabled.store(false, std::memory_order_release);
+    boost::nowide::ofstream out(path);
+    if (! out)
+        return false;
+    // Timestamps and durations are in microseconds.
+    auto microseconds = [](int64_t ns) { char buf[64]; sprintf(buf, "%.3f", double(ns) * 0.001); return std::string(buf); };
+    std::lock_guard<std::mutex> lock(s_threads_mutex);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const std::unique_ptr<ThreadEvents> &thread : s_threads) {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->tid
+            << ",\"args\":{\"name\":\"thread " << thread->tid << "\"}}";
+        first = false;
+        for (const Event &event : thread->events) {
+            out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->tid
+                << ",\"ts\":" << microseconds(event.time_start) << ",\"dur\":" << microseconds(event.time_end - event.time_start);
+            if (event.arg_name != nullptr)
+                out << ",\"args\":{\"" << event.arg_name << "\":" << event.arg_value << "}";
+            out << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    out.close();
+    return ! out.fail();
+}
+
+} // namespace Trace
+
+} // namespace Slic3r
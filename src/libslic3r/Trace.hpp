@@ -0,0 +1,56 @@
+#ifndef slic3r_Trace_hpp_
+#define slic3r_Trace_hpp_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace Slic3r {
+
+// Lightweight tracing of the slicing process into the Chrome trace event format, to be viewed with chrome://tracing
+// or https://ui.perfetto.dev. Contrary to the Shiny profiler enabled by SLIC3R_PROFILE, the tracing is compiled in
+// and enabled at runtime, the command line slicer enables it with the --trace option or the SLIC3R_TRACE environment variable.
+// The events are collected into per thread buffers, thus the threads do not synchronize while tracing.
+// While the tracing is disabled, a Trace::Scope costs a single atomic load.
+namespace Trace {
+
+extern std::atomic<bool> g_enabled;
+
+inline bool enabled() { return g_enabled.load(std::memory_order_acquire); }
+
+// Start collecting the trace events, the events of a previous trace are discarded.
+void    start();
+// Stop collecting the trace events and write them into a file. Returns false if the file could not be written.
+// Neither start() nor finish() may be called while other threads are recording events.
+bool    finish(const std::string &path);
+
+// Time since start() in nanoseconds.
+int64_t now();
+// Record an event of the calling thread. The names are not copied, they are expected to be string literals.
+void    add_event(const char *name, int64_t time_start, int64_t time_end, const char *arg_name, int64_t arg_value);
+
+// Records the execution of a block of code as an event of the calling thread,
+// optionally with a single integer argument, for example the index of the layer processed.
+class Scope
+{
+public:
+    explicit Scope(const char *name, const char *arg_name = nullptr, int64_t arg_value = 0) :
+        m_name(enabled() ? name : nullptr), m_arg_name(arg_name), m_arg_value(arg_value), m_time_start(m_name ? now() : 0) {}
+    ~Scope() { if (m_name != nullptr) add_event(m_name, m_time_start, now(), m_arg_name, m_arg_value); }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    // nullptr if the tracing was disabled when entering the scope.
+    const char *m_name;
+    const char *m_arg_name;
+    int64_t     m_arg_value;
+    int64_t     m_time_start;
+};
+
+} // namespace Trace
+
+} // namespace Slic3r
+
+#endif /* slic3r_Trace_hpp_ */
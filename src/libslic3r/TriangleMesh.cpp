@@ -2,6 +2,7 @@
 #include "ClipperUtils.hpp"
 #include "Geometry.hpp"
 #include "Tesselate.hpp"
+#include "Trace.hpp"
 #include <libqhullcpp/Qhull.h>
 #include <libqhullcpp/QhullFacetList.h>
 #include <libqhullcpp/QhullVertexSet.h>
@@ -13,6 +14,7 @@
 #include <map>
 #include <utility>
 #include <algorithm>
+#include <limits>
 #include <math.h>
 #include <type_traits>
 
@@ -764,14 +766,55 @@ void TriangleMeshSlicer::init(const TriangleMesh *_mesh, throw_on_cancel_callbac
         if ((i & 0x0ffff) == 0)
             throw_on_cancel();
     }
+
+    throw_on_cancel();
+    this->build_z_index(throw_on_cancel);
+}
+
+void TriangleMeshSlicer::build_z_index(throw_on_cancel_callback_type throw_on_cancel)
+{
+    const size_t num_facets = this->mesh->stl.stats.number_of_facets;
+    std::vector<std::pair<float, float>> extents(num_facets);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, num_facets),
+        [&extents, this](const tbb::blocked_range<size_t>& range) {
+            for (size_t facet_idx = range.begin(); facet_idx < range.end(); ++ facet_idx) {
+                const stl_facet &facet = m_use_quaternion ? this->mesh->stl.facet_start[facet_idx].rotated(m_quaternion) : this->mesh->stl.facet_start[facet_idx];
+                extents[facet_idx].first  = fminf(facet.vertex[0](2), fminf(facet.vertex[1](2), facet.vertex[2](2)));
+                extents[facet_idx].second = fmaxf(facet.vertex[0](2), fmaxf(facet.vertex[1](2), facet.vertex[2](2)));
+            }
+        });
+
+    m_facets_by_min_z.assign(num_facets, 0);
+    for (size_t i = 0; i < num_facets; ++ i)
+        m_facets_by_min_z[i] = int(i);
+    throw_on_cancel();
+    std::sort(m_facets_by_min_z.begin(), m_facets_by_min_z.end(), [&extents](int i1, int i2) { return extents[i1].first < extents[i2].first || (extents[i1].first == extents[i2].first && i1 < i2); });
+
+    m_facets_min_z.assign(num_facets, 0.f);
+    m_facets_max_z_running.assign(num_facets, 0.f);
+    float max_z = - std::numeric_limits<float>::max();
+    for (size_t i = 0; i < num_facets; ++ i) {
+        const std::pair<float, float> &e = extents[m_facets_by_min_z[i]];
+        m_facets_min_z[i]         = e.first;
+        m_facets_max_z_running[i] = max_z = std::max(max_z, e.second);
+    }
 }
 
 
 
 void TriangleMeshSlicer::set_up_direction(const Vec3f& up)
 {
+    if (m_use_quaternion && up == m_up)
+        // MeshClipper sets the up direction before each slice.
+        return;
+    m_up = up;
     m_quaternion.setFromTwoVectors(up, Vec3f::UnitZ());
     m_use_quaternion = true;
+    // The z extents of the facets changed.
+    m_facets_by_min_z.clear();
+    m_facets_min_z.clear();
+    m_facets_max_z_running.clear();
 }
 
 
@@ -779,6 +822,7 @@ void TriangleMeshSlicer::set_up_direction(const Vec3f& up)
 void TriangleMeshSlicer::slice(const std::vector<float> &z, SlicingMode mode, std::vector<Polygons>* layers, throw_on_cancel_callback_type throw_on_cancel) const
 {
     BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::slice";
+    Trace::Scope trace("TriangleMeshSlicer::slice", "layers", z.size());
 
     /*
        This method gets called with a list of unscaled Z coordinates and outputs
@@ -809,15 +853,54 @@ void TriangleMeshSlicer::slice(const std::vector<float> &z, SlicingMode mode, st
     
     BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::_slice_do";
     std::vector<IntersectionLines> lines(z.size());
-    {
-        boost::mutex lines_mutex;
+    if (! z.empty()) {
+        size_t     facets_begin = 0;
+        size_t     facets_end   = this->mesh->stl.stats.number_of_facets;
+        // Order of the facets to visit, nullptr to visit the facets in their mesh order.
+        const int *facets_order = nullptr;
+        if (! m_facets_by_min_z.empty()) {
+            // Only the facets spanning the sliced z range are visited: Those with the minimum z below the top slicing plane,
+            // starting with the first facet, whose maximum z (or a maximum z of any preceding facet) reaches the bottom slicing plane.
+            const float min_slice_z = *std::min_element(z.begin(), z.end());
+            const float max_slice_z = *std::max_element(z.begin(), z.end());
+            facets_begin = std::lower_bound(m_facets_max_z_running.begin(), m_facets_max_z_running.end(), min_slice_z) - m_facets_max_z_running.begin();
+            facets_end   = std::max(facets_begin, size_t(std::upper_bound(m_facets_min_z.begin(), m_facets_min_z.end(), max_slice_z) - m_facets_min_z.begin()));
+            if (facets_begin == 0 && facets_end == m_facets_by_min_z.size())
+                // All facets span the sliced z range, visit them in their mesh order.
+                facets_end = this->mesh->stl.stats.number_of_facets;
+            else
+                facets_order = m_facets_by_min_z.data();
+        }
+        // The facets are split into fixed size chunks, each chunk collects its intersection lines into its own buffer,
+        // so that no locking is needed while slicing. The chunk size does not depend on the number of threads,
+        // therefore the order of the merged lines does not depend on the scheduling.
+        const size_t facets_per_chunk = 0x04000;
+        std::vector<std::vector<LayerIntersectionLine>> chunk_lines((facets_end - facets_begin + facets_per_chunk - 1) / facets_per_chunk);
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, chunk_lines.size()),
+            [&chunk_lines, facets_begin, facets_end, facets_order, facets_per_chunk, &z, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
+                for (size_t chunk_idx = range.begin(); chunk_idx < range.end(); ++ chunk_idx) {
+                    throw_on_cancel();
+                    Trace::Scope trace("TriangleMeshSlicer::slice_facets", "chunk", chunk_idx);
+                    std::vector<LayerIntersectionLine> &out = chunk_lines[chunk_idx];
+                    for (size_t i = facets_begin + chunk_idx * facets_per_chunk; i < std::min(facets_end, facets_begin + (chunk_idx + 1) * facets_per_chunk); ++ i)
+                        this->_slice_do(facets_order ? facets_order[i] : i, &out, z);
+                    // Group the lines by layer, keep the facet order inside a layer.
+                    std::stable_sort(out.begin(), out.end(), [](const LayerIntersectionLine &l1, const LayerIntersectionLine &l2) { return l1.first < l2.first; });
+                }
+            }
+        );
+        throw_on_cancel();
+        // Merge the chunks layer by layer.
         tbb::parallel_for(
-            tbb::blocked_range<int>(0,this->mesh->stl.stats.number_of_facets),
-            [&lines, &lines_mutex, &z, throw_on_cancel, this](const tbb::blocked_range<int>& range) {
-                for (int facet_idx = range.begin(); facet_idx < range.end(); ++ facet_idx) {
-                    if ((facet_idx & 0x0ffff) == 0)
-                        throw_on_cancel();
-                    this->_slice_do(facet_idx, &lines, &lines_mutex, z);
+            tbb::blocked_range<size_t>(0, z.size()),
+            [&chunk_lines, &lines](const tbb::blocked_range<size_t>& range) {
+                auto lower = [](const LayerIntersectionLine &l, uint32_t layer_idx) { return l.first < layer_idx; };
+                for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                    IntersectionLines &layer_lines = lines[layer_idx];
+                    for (const std::vector<LayerIntersectionLine> &chunk : chunk_lines)
+                        for (auto it = std::lower_bound(chunk.begin(), chunk.end(), uint32_t(layer_idx), lower); it != chunk.end() && it->first == layer_idx; ++ it)
+                            layer_lines.emplace_back(it->second);
                 }
             }
         );
@@ -832,6 +915,7 @@ void TriangleMeshSlicer::slice(const std::vector<float> &z, SlicingMode mode, st
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, z.size()),
         [&lines, &layers, mode, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
+            Trace::Scope trace("TriangleMeshSlicer::make_loops", "layer", range.begin());
             for (size_t line_idx = range.begin(); line_idx < range.end(); ++ line_idx) {
                 if ((line_idx & 0x0ffff) == 0)
                     throw_on_cancel();
@@ -902,8 +986,7 @@ void TriangleMeshSlicer::slice(const std::vector<float> &z, SlicingMode mode, st
 #endif
 }
 
-void TriangleMeshSlicer::_slice_do(size_t facet_idx, std::vector<IntersectionLines>* lines, boost::mutex* lines_mutex, 
-    const std::vector<float> &z) const
+void TriangleMeshSlicer::_slice_do(size_t facet_idx, std::vector<LayerIntersectionLine>* lines, const std::vector<float> &z) const
 {
     const stl_facet &facet = m_use_quaternion ? (this->mesh->stl.facet_start.data() + facet_idx)->rotated(m_quaternion) : *(this->mesh->stl.facet_start.data() + facet_idx);
     
@@ -931,11 +1014,10 @@ void TriangleMeshSlicer::_slice_do(size_t facet_idx, std::vector<IntersectionLin
         std::vector<float>::size_type layer_idx = it - z.begin();
         IntersectionLine il;
         if (this->slice_facet(*it / SCALING_FACTOR, facet, facet_idx, min_z, max_z, &il) == TriangleMeshSlicer::Slicing) {
-            boost::lock_guard<boost::mutex> l(*lines_mutex);
             if (il.edge_type == feHorizontal) {
                 // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
             } else
-                (*lines)[layer_idx].emplace_back(il);
+                lines->emplace_back(uint32_t(layer_idx), il);
         }
     }
 }
@@ -201,8 +201,22 @@ private:
     Eigen::Quaternion<float, Eigen::DontAlign> m_quaternion;
     // Whether or not the above quaterion should be used
     bool                     m_use_quaternion = false;
+    // Up direction the quaternion was calculated from.
+    Vec3f                    m_up = Vec3f::UnitZ();
+    // Index of the facets by their z extents, built by init(). set_up_direction() drops the index, as the z extents
+    // of the facets change with the up direction and the MeshClipper slicing a single plane per direction would not profit from it.
+    // Indices of facets sorted by their minimum z, so that slicing of a z range only visits the facets spanning it.
+    std::vector<int>         m_facets_by_min_z;
+    // Minimum z of the facets in the order of m_facets_by_min_z.
+    std::vector<float>       m_facets_min_z;
+    // Running maximum of the maximum z of the facets in the order of m_facets_by_min_z, thus non-decreasing.
+    std::vector<float>       m_facets_max_z_running;
 
-    void _slice_do(size_t facet_idx, std::vector<IntersectionLines>* lines, boost::mutex* lines_mutex, const std::vector<float> &z) const;
+    void build_z_index(throw_on_cancel_callback_type throw_on_cancel);
+
+    // Intersection line tagged with the index of the layer it belongs to.
+    typedef std::pair<uint32_t, IntersectionLine> LayerIntersectionLine;
+    void _slice_do(size_t facet_idx, std::vector<LayerIntersectionLine>* lines, const std::vector<float> &z) const;
     void make_loops(std::vector<IntersectionLine> &lines, Polygons* loops) const;
     void make_expolygons(const Polygons &loops, const float closing_radius, ExPolygons* slices) const;
     void make_expolygons_simple(std::vector<IntersectionLine> &lines, ExPolygons* slices) const;
@@ -233,6 +233,8 @@ inline typename CONTAINER_TYPE::value_type& next_value_modulo(typename CONTAINER
 }
 
 extern std::string xml_escape(std::string text);
+// Escape a string to be written between the double quotes of a JSON string.
+extern std::string json_escape(const std::string &text);
 
 
 #if defined __GNUC__ && __GNUC__ < 5 && !defined __clang__
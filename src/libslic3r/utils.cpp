@@ -643,6 +643,29 @@ std::string xml_escape(std::string text)
     return text;
 }
 
+std::string json_escape(const std::string &text)
+{
+    std::string out;
+    out.reserve(text.size() + 2);
+    for (char c : text) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                char buf[8];
+                sprintf(buf, "\\u%04x", (unsigned int)c);
+                out += buf;
+            } else
+                out += c;
+        }
+    }
+    return out;
+}
+
 std::string format_memsize_MB(size_t n) 
 {
     std::string out;
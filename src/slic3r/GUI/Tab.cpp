@@ -1470,6 +1470,7 @@ void TabPrint::build()
 
         optgroup = page->new_optgroup(L("Other"));
         optgroup->append_single_option_line("clip_multipart_objects");
+        optgroup->append_single_option_line("fast_extrusion_ordering");
 
     page = add_options_page(L("Output options"), "output+page_white");
         optgroup = page->new_optgroup(L("Sequential printing"));
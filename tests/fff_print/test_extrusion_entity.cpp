@@ -83,3 +83,42 @@ SCENARIO("ExtrusionEntityCollection: Polygon flattening", "[ExtrusionEntity]") {
         }
     }
 }
+
+SCENARIO("ExtrusionEntityCollection: Copying", "[ExtrusionEntity]") {
+    srand(0xDEADBEEF); // consistent seed for test reproducibility.
+    GIVEN("A nested Extrusion Entity Collection") {
+        Slic3r::ExtrusionEntityCollection sub;
+        sub.append(random_paths());
+        Slic3r::ExtrusionEntityCollection sample;
+        sample.append(random_paths(5));
+        sample.append(sub);
+        WHEN("The EEC is cloned") {
+            std::unique_ptr<ExtrusionEntity> copy(sample.clone());
+            const ExtrusionEntityCollection &out = *static_cast<const ExtrusionEntityCollection*>(copy.get());
+            THEN("The clone is a deep copy of the same items") {
+                REQUIRE(out.entities.size() == sample.entities.size());
+                REQUIRE(out.items_count() == sample.items_count());
+                for (size_t i = 0; i < out.entities.size(); ++ i) {
+                    CHECK(out.entities[i] != sample.entities[i]);
+                    CHECK(out.entities[i]->first_point() == sample.entities[i]->first_point());
+                }
+            }
+        }
+        WHEN("The EEC is assigned over a non-empty EEC") {
+            Slic3r::ExtrusionEntityCollection output;
+            output.append(random_paths(3));
+            output = sample;
+            THEN("The entities of the EEC are replaced") {
+                CHECK(output.entities.size() == sample.entities.size());
+                CHECK(output.items_count() == sample.items_count());
+            }
+            AND_WHEN("The EEC is assigned to itself") {
+                const Slic3r::ExtrusionEntityCollection &self = output;
+                output = self;
+                THEN("The EEC is unchanged") {
+                    CHECK(output.items_count() == sample.items_count());
+                }
+            }
+        }
+    }
+}
@@ -7,12 +7,15 @@
 #include "libslic3r/Fill/Fill.hpp"
 #include "libslic3r/Flow.hpp"
 #include "libslic3r/Geometry.hpp"
+#include "libslic3r/Layer.hpp"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/SVG.hpp"
 #include "libslic3r/libslic3r.h"
 
 #include "test_data.hpp"
 
+#include <tbb/task_arena.h>
+
 using namespace Slic3r;
 
 bool test_if_solid_surface_filled(const ExPolygon& expolygon, double flow_spacing, double angle = 0, double density = 1.0);
@@ -476,3 +479,69 @@ bool test_if_solid_surface_filled(const ExPolygon& expolygon, double flow_spacin
 
     return uncovered.empty(); // solid surface is fully filled
 }
+
+SCENARIO("Fill: the regions of a layer are filled in parallel", "[Fill]") {
+    GIVEN("A cube with two modifiers changing the infill, filled by a single thread and by four threads") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize({
+            { "fill_density",       "20%" },
+            { "top_solid_layers",   3 },
+            { "bottom_solid_layers", 3 }
+        });
+        auto process = [&config](int num_threads, Print &print) {
+            Model        model;
+            ModelObject *object = model.add_object();
+            object->name = "cube";
+            object->add_volume(Test::mesh(Test::TestMesh::cube_20x20x20));
+            for (int i = 0; i < 2; ++ i) {
+                TriangleMesh mesh = Test::mesh(Test::TestMesh::cube_20x20x20);
+                mesh.scale(0.4f);
+                mesh.translate(i == 0 ? 1.f : 11.f, 1.f, 0.f);
+                ModelVolume *modifier = object->add_volume(std::move(mesh));
+                modifier->set_type(ModelVolumeType::PARAMETER_MODIFIER);
+                modifier->config.set_deserialize({ { "fill_density", i == 0 ? "60%" : "40%" }, { "fill_pattern", i == 0 ? "gyroid" : "honeycomb" } });
+            }
+            object->add_instance()->set_offset(Vec3d(100., 100., 0.));
+            object->ensure_on_bed();
+            print.apply(model, config);
+            std::string gcode;
+            tbb::task_arena(num_threads).execute([&print, &gcode]() { gcode = Test::gcode(print); });
+            // Drop the time stamp.
+            return gcode.substr(gcode.find('\n'));
+        };
+        WHEN("The print is processed") {
+            Print print_serial, print_parallel;
+            std::string gcode_serial   = process(1, print_serial);
+            std::string gcode_parallel = process(4, print_parallel);
+            THEN("A layer is filled with three different infills") {
+                const Layer *layer = print_serial.objects().front()->get_layer(4);
+                size_t num_fills = 0;
+                for (const LayerRegion *layerm : layer->regions())
+                    num_fills += layerm->fills.entities.size();
+                REQUIRE(layer->region_count() == 3);
+                REQUIRE(num_fills == 3);
+            }
+            THEN("The fills of all layers are the same") {
+                const PrintObject &object_serial   = *print_serial.objects().front();
+                const PrintObject &object_parallel = *print_parallel.objects().front();
+                REQUIRE(object_serial.layer_count() == object_parallel.layer_count());
+                bool fills_equal = true;
+                for (size_t layer_idx = 0; layer_idx < object_serial.layer_count(); ++ layer_idx)
+                    for (size_t region_id = 0; region_id < object_serial.get_layer(layer_idx)->region_count(); ++ region_id) {
+                        const ExtrusionEntityCollection &fills_serial   = object_serial  .get_layer(layer_idx)->get_region(region_id)->fills;
+                        const ExtrusionEntityCollection &fills_parallel = object_parallel.get_layer(layer_idx)->get_region(region_id)->fills;
+                        Polylines polylines_serial, polylines_parallel;
+                        fills_serial.collect_polylines(polylines_serial);
+                        fills_parallel.collect_polylines(polylines_parallel);
+                        fills_equal &= fills_serial.entities.size() == fills_parallel.entities.size() && polylines_serial.size() == polylines_parallel.size() &&
+                            std::equal(polylines_serial.begin(), polylines_serial.end(), polylines_parallel.begin(),
+                                [](const Polyline &pl1, const Polyline &pl2) { return pl1.points == pl2.points; });
+                    }
+                REQUIRE(fills_equal);
+            }
+            THEN("The same G-code is exported") {
+                REQUIRE(gcode_serial == gcode_parallel);
+            }
+        }
+    }
+}
@@ -94,3 +94,35 @@ SCENARIO("set_speed emits values with fixed-point output.", "[GCodeWriter]") {
         }
     }
 }
+
+SCENARIO("Moves are emitted with fixed-point output.", "[GCodeWriter]") {
+
+    GIVEN("GCodeWriter instance with a single extruder") {
+        GCodeWriter writer;
+        writer.set_extruders({ 0 });
+        writer.set_extruder(0);
+        WHEN("travel_to_xy is called") {
+            THEN("Coordinates are rounded to 3 decimal digits, ties to even") {
+                REQUIRE_THAT(writer.travel_to_xy(Vec2d(10.25, -3.0625)), Catch::Equals("G1 X10.250 Y-3.062 F7800.000\n"));
+            }
+        }
+        WHEN("extrude_to_xy is called") {
+            THEN("E is emitted with 5 decimal digits") {
+                REQUIRE_THAT(writer.extrude_to_xy(Vec2d(1., 2.), 0.5), Catch::Equals("G1 X1.000 Y2.000 E0.50000\n"));
+                AND_WHEN("extrude_to_xy is called with an output string") {
+                    std::string gcode = ";_EXTRUDE_SET_SPEED\n";
+                    writer.extrude_to_xy(gcode, Vec2d(1., 2.), 0.25);
+                    THEN("The move is appended to the output string") {
+                        REQUIRE_THAT(gcode, Catch::Equals(";_EXTRUDE_SET_SPEED\nG1 X1.000 Y2.000 E0.75000\n"));
+                    }
+                }
+            }
+        }
+        WHEN("retract and unretract are called") {
+            THEN("The retraction speed is emitted with 5 decimal digits") {
+                REQUIRE_THAT(writer.retract(), Catch::Equals("G1 E-2.00000 F2400.00000\n"));
+                REQUIRE_THAT(writer.unretract(), Catch::Equals("G1 E0.00000 F2400.00000\n"));
+            }
+        }
+    }
+}
@@ -3,9 +3,16 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/SliceCache.hpp"
+#include "libslic3r/Trace.hpp"
 
 #include "test_data.hpp"
 
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+#include <tbb/task_arena.h>
+
 using namespace Slic3r;
 using namespace Slic3r::Test;
 
@@ -126,3 +133,374 @@ SCENARIO("Print: Brim generation", "[Print]") {
         }
     }
 }
+
+static std::string export_gcode_released(Print &print)
+{
+	boost::filesystem::path temp = boost::filesystem::unique_path();
+    print.export_gcode(temp.string(), nullptr, nullptr, true);
+	std::ifstream t(temp.string());
+	std::string str((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
+	boost::nowide::remove(temp.string().c_str());
+	// Drop the time stamp.
+	return str.substr(str.find('\n'));
+}
+
+SCENARIO("Print: The objects are processed concurrently", "[Print]") {
+    GIVEN("An overhang and a step with support material, a cube and a pyramid") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize({
+            { "support_material",   1 },
+            { "raft_layers",        2 },
+            { "fill_density",       "30%" },
+            { "top_solid_layers",   4 }
+        });
+        auto process = [&config](int num_threads) {
+            std::string gcode;
+            tbb::task_arena(num_threads).execute([&config, &gcode]() {
+                gcode = Slic3r::Test::slice({ TestMesh::overhang, TestMesh::step, TestMesh::cube_20x20x20, TestMesh::pyramid }, config);
+            });
+            // Drop the time stamp.
+            return gcode.substr(gcode.find('\n'));
+        };
+        WHEN("The print is processed by a single thread and by four threads") {
+            std::string serial   = process(1);
+            std::string parallel = process(4);
+            THEN("The same G-code is exported") {
+                REQUIRE(serial == parallel);
+            }
+        }
+    }
+}
+
+SCENARIO("Print: Memory usage and release of the exported layers", "[Print]") {
+    GIVEN("20mm cube and default config") {
+        Slic3r::Print print;
+        Slic3r::Test::init_and_process_print({TestMesh::cube_20x20x20}, print, {});
+        const PrintObject &object = *print.objects().front();
+        WHEN("The print is processed") {
+            LayerMemoryUsage usage = object.memory_usage();
+            THEN("The memory of the slices, islands and extrusions is reported") {
+                REQUIRE(usage.slices > 0);
+                REQUIRE(usage.lslices > 0);
+                REQUIRE(usage.perimeters > 0);
+                REQUIRE(usage.fills > 0);
+                REQUIRE(usage.support == 0);
+                REQUIRE(usage.total() == print.memory_usage().total());
+            }
+        }
+        WHEN("The G-code is exported with the layer data released") {
+            Slic3r::Print print_reference;
+            Slic3r::Test::init_and_process_print({TestMesh::cube_20x20x20}, print_reference, {});
+            std::string gcode = Slic3r::Test::gcode(print_reference);
+            std::string gcode_released = export_gcode_released(print);
+            LayerMemoryUsage usage = object.memory_usage();
+            THEN("The same G-code is exported") {
+                REQUIRE(gcode_released == gcode.substr(gcode.find('\n')));
+            }
+            THEN("The extrusions and fill surfaces are released") {
+                REQUIRE(usage.perimeters == 0);
+                REQUIRE(usage.fills == 0);
+                REQUIRE(usage.fill_surfaces == 0);
+                REQUIRE(usage.fill_expolygons == 0);
+            }
+            THEN("The print is sliced again by the next process() call") {
+                REQUIRE(! object.is_step_done(posSlice));
+                print.process();
+                REQUIRE(export_gcode_released(print) == gcode_released);
+            }
+        }
+    }
+}
+
+// An overhang and a cube with support material, or printed sequentially with two instances each.
+static void init_and_process_overhang_and_cube(Print &print, Model &model, bool sequential)
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    if (sequential)
+        config.set_deserialize({ { "complete_objects", 1 } });
+    else
+        config.set_deserialize({ { "support_material", 1 }, { "top_solid_layers", 4 } });
+    Slic3r::Test::init_print({ TestMesh::overhang, TestMesh::cube_20x20x20 }, print, model, config);
+    if (sequential) {
+        int idx = 0;
+        for (ModelObject *object : model.objects) {
+            object->clear_instances();
+            for (int i = 0; i < 2; ++ i, ++ idx)
+                object->add_instance()->set_offset(Vec3d(40 + (idx % 2) * 80, 40 + (idx / 2) * 80, 0));
+            object->ensure_on_bed();
+        }
+        print.apply(model, config);
+    }
+    print.process();
+}
+
+SCENARIO("Print: Releasing the extrusions during the G-code export", "[Print]") {
+    for (bool sequential : { false, true })
+        GIVEN((sequential ? "An overhang and a cube printed sequentially with two instances each" : "An overhang and a cube with support material")) {
+            Slic3r::Print print_reference, print;
+            Slic3r::Model model_reference, model;
+            init_and_process_overhang_and_cube(print_reference, model_reference, sequential);
+            init_and_process_overhang_and_cube(print, model, sequential);
+            std::string gcode = Slic3r::Test::gcode(print_reference);
+            gcode = gcode.substr(gcode.find('\n'));
+            WHEN("The G-code is exported with the extrusions released") {
+                std::string gcode_released = export_gcode_released(print);
+                THEN("The same G-code is exported as without releasing the extrusions") {
+                    REQUIRE(gcode_released == gcode);
+                }
+                THEN("The extrusions of all objects are released and their steps are invalidated") {
+                    for (const PrintObject *object : print.objects()) {
+                        LayerMemoryUsage usage = object->memory_usage();
+                        REQUIRE(usage.perimeters == 0);
+                        REQUIRE(usage.fills == 0);
+                        for (const SupportLayer *layer : object->support_layers())
+                            REQUIRE(layer->support_fills.empty());
+                        REQUIRE(! object->is_step_done(posPerimeters));
+                        REQUIRE(! object->is_step_done(posSupportMaterial));
+                    }
+                }
+                THEN("The extrusions are generated again by process() and the same G-code is exported") {
+                    std::string gcode_again = Slic3r::Test::gcode(print);
+                    REQUIRE(gcode_again.substr(gcode_again.find('\n')) == gcode);
+                }
+            }
+        }
+}
+
+static std::string gcode_with_slice_cache(std::initializer_list<Slic3r::ConfigBase::SetDeserializeItem> config_items, const std::string &slice_cache_dir)
+{
+    Slic3r::Print print;
+    Slic3r::Model model;
+    Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config_items);
+    print.set_slice_cache_dir(slice_cache_dir);
+    std::string gcode = Slic3r::Test::gcode(print);
+    // Drop the time stamp.
+    return gcode.substr(gcode.find('\n'));
+}
+
+static size_t num_files(const boost::filesystem::path &dir)
+{
+    return size_t(std::distance(boost::filesystem::directory_iterator(dir), boost::filesystem::directory_iterator()));
+}
+
+SCENARIO("Print: Slice cache", "[Print]") {
+    GIVEN("20mm cube, default config and an empty slice cache") {
+        boost::filesystem::path cache_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        std::string gcode = gcode_with_slice_cache({}, std::string());
+        WHEN("The cube is sliced twice with the slice cache") {
+            std::string gcode_stored = gcode_with_slice_cache({}, cache_dir.string());
+            std::string gcode_loaded = gcode_with_slice_cache({}, cache_dir.string());
+            THEN("The slices are stored once") {
+                REQUIRE(num_files(cache_dir) == 1);
+            }
+            THEN("The same G-code is exported as without the slice cache") {
+                REQUIRE(gcode_stored == gcode);
+                REQUIRE(gcode_loaded == gcode);
+            }
+        }
+        WHEN("The cube is sliced with a different layer height") {
+            gcode_with_slice_cache({}, cache_dir.string());
+            gcode_with_slice_cache({ { "layer_height", 0.2 } }, cache_dir.string());
+            THEN("The slices are stored under a different key") {
+                REQUIRE(num_files(cache_dir) == 2);
+            }
+        }
+        WHEN("The stored slices are corrupted") {
+            gcode_with_slice_cache({}, cache_dir.string());
+            boost::filesystem::path path = boost::filesystem::directory_iterator(cache_dir)->path();
+            uintmax_t file_size = boost::filesystem::file_size(path);
+            boost::filesystem::resize_file(path, file_size / 2);
+            THEN("The cube is sliced again, the slices are stored again and the same G-code is exported") {
+                REQUIRE(gcode_with_slice_cache({}, cache_dir.string()) == gcode);
+                REQUIRE(boost::filesystem::file_size(path) == file_size);
+            }
+        }
+        WHEN("A corrupted file is loaded into a sliced object") {
+            Slic3r::Print print;
+            Slic3r::Model model;
+            Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, {});
+            print.set_slice_cache_dir(cache_dir.string());
+            print.process();
+            boost::filesystem::path path = boost::filesystem::directory_iterator(cache_dir)->path();
+            boost::filesystem::resize_file(path, boost::filesystem::file_size(path) - 4);
+            PrintObject &object = *print.get_object(0);
+            const size_t layer_count = object.layer_count();
+            const Layer *first_layer = object.get_layer(0);
+            THEN("Loading fails and the layers of the object are kept") {
+                REQUIRE(! SliceCache::load(cache_dir.string(), path.stem().string(), object));
+                REQUIRE(object.layer_count() == layer_count);
+                REQUIRE(object.get_layer(0) == first_layer);
+            }
+        }
+        boost::filesystem::remove_all(cache_dir);
+    }
+}
+
+// Export the G-code of a print, which was already exported with a different config, after applying the modified config.
+static std::string gcode_after_apply(Print &print, Model &model, const DynamicPrintConfig &config)
+{
+    print.apply(model, config);
+    std::string gcode = Slic3r::Test::gcode(print);
+    // Drop the time stamp.
+    return gcode.substr(gcode.find('\n'));
+}
+
+static std::string gcode_sliced_anew(const DynamicPrintConfig &config)
+{
+    std::string gcode = Slic3r::Test::slice({TestMesh::cube_20x20x20}, config);
+    return gcode.substr(gcode.find('\n'));
+}
+
+SCENARIO("Print: Invalidation by a change of the config", "[Print]") {
+    GIVEN("20mm cube with ironing enabled, the G-code exported") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize({ { "ironing", 1 } });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        Slic3r::Test::gcode(print);
+        const PrintObject &object = *print.objects().front();
+        std::vector<PrintStateBase::TimeStamp> timestamps;
+        for (int step = 0; step < int(posCount); ++ step)
+            timestamps.emplace_back(object.step_state_with_timestamp(PrintObjectStep(step)).timestamp);
+        for (const std::pair<std::string, std::string> &opt : std::vector<std::pair<std::string, std::string>> {
+                { "perimeter_speed", "35" }, { "infill_speed", "60" }, { "first_layer_speed", "20" }, { "travel_speed", "100" },
+                { "temperature", "215" }, { "first_layer_temperature", "220" }, { "bed_temperature", "65" },
+                { "max_fan_speed", "80" }, { "retract_length", "1.5" } }) {
+            WHEN("The speed or temperature " + opt.first + " is changed") {
+                config.set_deserialize(opt.first, opt.second);
+                std::string gcode = gcode_after_apply(print, model, config);
+                THEN("The steps of the object were not executed again") {
+                    for (int step = 0; step < int(posCount); ++ step)
+                        REQUIRE(object.step_state_with_timestamp(PrintObjectStep(step)).timestamp == timestamps[step]);
+                }
+                THEN("The same G-code is exported as if sliced anew") {
+                    REQUIRE(gcode == gcode_sliced_anew(config));
+                }
+            }
+        }
+        WHEN("The infill pattern is changed") {
+            config.set_deserialize("fill_pattern", "gyroid");
+            THEN("The infill is regenerated together with the ironing, the same G-code is exported as if sliced anew") {
+                REQUIRE(gcode_after_apply(print, model, config) == gcode_sliced_anew(config));
+            }
+        }
+    }
+}
+
+// The steps of the print and of its objects, which are not done.
+static std::pair<std::vector<PrintStep>, std::vector<PrintObjectStep>> steps_not_done(const Print &print)
+{
+    std::pair<std::vector<PrintStep>, std::vector<PrintObjectStep>> out;
+    for (int step = 0; step < int(psCount); ++ step)
+        if (! print.is_step_done(PrintStep(step)))
+            out.first.emplace_back(PrintStep(step));
+    for (int step = 0; step < int(posCount); ++ step)
+        if (std::any_of(print.objects().begin(), print.objects().end(), [step](const PrintObject *object) { return ! object->is_step_done(PrintObjectStep(step)); }))
+            out.second.emplace_back(PrintObjectStep(step));
+    return out;
+}
+
+SCENARIO("Print: Steps invalidated by a change of the config", "[Print]") {
+    struct Change {
+        std::string                     opt_key;
+        std::string                     value;
+        std::vector<PrintStep>          print_steps;
+        std::vector<PrintObjectStep>    object_steps;
+    };
+    // A representative option of each group of the print_step_dependency() table. The object steps invalidate
+    // the depending object steps, the skirt, the brim, the wipe tower and the G-code export.
+    const std::vector<PrintStep> print_steps_by_objects { psSkirt, psBrim, psWipeTower, psGCodeExport };
+    GIVEN("20mm cube with ironing enabled, the G-code exported") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize({ { "ironing", 1 } });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        Slic3r::Test::gcode(print);
+        REQUIRE(steps_not_done(print) == std::make_pair(std::vector<PrintStep>(), std::vector<PrintObjectStep>()));
+        for (const Change &change : std::vector<Change> {
+                { "travel_speed",                   "100",      { psGCodeExport }, {} },
+                { "infill_speed",                   "60",       { psGCodeExport }, {} },
+                // Without a wipe tower, the temperatures are only read by the G-code generator.
+                { "temperature",                    "215",      { psGCodeExport }, {} },
+                { "skirt_distance",                 "8",        { psSkirt, psBrim, psGCodeExport }, {} },
+                { "brim_width",                     "3",        { psSkirt, psBrim, psGCodeExport }, {} },
+                { "z_offset",                       "0.1",      { psSkirt, psBrim, psWipeTower, psGCodeExport }, {} },
+                { "wipe_into_infill",               "1",        { psWipeTower, psGCodeExport }, {} },
+                { "first_layer_extrusion_width",    "0.5",      print_steps_by_objects, { posPerimeters, posPrepareInfill, posInfill, posIroning, posSupportMaterial } },
+                { "layer_height",                   "0.2",      print_steps_by_objects, { posSlice, posPerimeters, posPrepareInfill, posInfill, posIroning, posSupportMaterial } },
+                { "perimeters",                     "4",        print_steps_by_objects, { posPerimeters, posPrepareInfill, posInfill, posIroning } },
+                // The perimeters and the supports are invalidated, the perimeters cascade into the infill and the ironing.
+                { "extrusion_width",                "0.5",      print_steps_by_objects, { posPerimeters, posPrepareInfill, posInfill, posIroning, posSupportMaterial } },
+                { "top_solid_layers",               "5",        print_steps_by_objects, { posPrepareInfill, posInfill, posIroning } },
+                { "fill_pattern",                   "gyroid",   print_steps_by_objects, { posInfill, posIroning } },
+                { "ironing_spacing",                "0.2",      print_steps_by_objects, { posInfill, posIroning } },
+                { "fast_extrusion_ordering",        "1",        print_steps_by_objects, { posInfill, posIroning, posSupportMaterial } },
+                { "support_material_angle",         "45",       print_steps_by_objects, { posSupportMaterial } } }) {
+            WHEN(change.opt_key + " is changed") {
+                config.set_deserialize(change.opt_key, change.value);
+                print.apply(model, config);
+                THEN("Only the steps depending on " + change.opt_key + " are invalidated") {
+                    auto not_done = steps_not_done(print);
+                    REQUIRE(not_done.first  == change.print_steps);
+                    REQUIRE(not_done.second == change.object_steps);
+                }
+            }
+        }
+    }
+    GIVEN("20mm cube printed by a two extruder printer with the wipe tower, the G-code exported") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize({
+            { "nozzle_diameter",            "0.4,0.4" },
+            { "temperature",                "200,200" },
+            { "first_layer_temperature",    "200,200" },
+            { "wipe_tower",                 1 },
+            { "use_relative_e_distances",   1 }
+        });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        Slic3r::Test::gcode(print);
+        REQUIRE(print.has_wipe_tower());
+        for (const char *opt_key : { "temperature", "first_layer_temperature" }) {
+            WHEN(std::string(opt_key) + " is changed") {
+                config.set_deserialize(opt_key, "215,215");
+                print.apply(model, config);
+                THEN("The wipe tower, which reads the temperatures, is invalidated") {
+                    auto not_done = steps_not_done(print);
+                    REQUIRE(not_done.first  == std::vector<PrintStep>({ psWipeTower, psGCodeExport }));
+                    REQUIRE(not_done.second.empty());
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Print: Trace of the slicing process", "[Print]") {
+    GIVEN("20mm cube and default config") {
+        boost::filesystem::path trace_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        WHEN("The cube is sliced with the tracing enabled") {
+            Trace::start();
+            std::string gcode = Slic3r::Test::slice({TestMesh::cube_20x20x20}, {});
+            bool        written = Trace::finish(trace_path.string());
+            std::ifstream t(trace_path.string());
+            std::string trace((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
+            t.close();
+            THEN("The trace is written in the Chrome trace event format") {
+                REQUIRE(written);
+                REQUIRE(trace.find("{\"traceEvents\":[") == 0);
+                REQUIRE(trace.find("\"ph\":\"X\"") != std::string::npos);
+            }
+            THEN("The trace contains the steps of the object, the layer tasks and the G-code generation") {
+                for (const char *name : { "PrintObject::slice", "TriangleMeshSlicer::slice", "PrintObject::make_perimeters", "Layer::make_perimeters",
+                                          "PrintObject::infill", "Layer::make_fills", "Print::export_gcode", "GCode::process_layer" })
+                    REQUIRE(trace.find(std::string("\"name\":\"") + name + "\"") != std::string::npos);
+            }
+            THEN("Nothing is traced after the trace is finished") {
+                REQUIRE(! Trace::enabled());
+            }
+        }
+        boost::nowide::remove(trace_path.string().c_str());
+    }
+}
@@ -2,11 +2,16 @@
 
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/GCodeReader.hpp"
+#include "libslic3r/GCodeTimeEstimator.hpp"
+#include "libslic3r/GCode/Analyzer.hpp"
+#include "libslic3r/GCode/PreviewData.hpp"
 
 #include "test_data.hpp"
 
 #include <algorithm>
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/regex.hpp>
+#include <tbb/task_arena.h>
 
 using namespace Slic3r;
 using namespace Slic3r::Test;
@@ -201,6 +206,77 @@ SCENARIO( "PrintGCode basic functionality", "[PrintGCode]") {
                 REQUIRE(gcode.find("M107") != std::string::npos);
             }
         }
+        WHEN("remaining times are enabled") {
+			std::string gcode = ::Test::slice({ TestMesh::cube_20x20x20 }, {
+				{ "remaining_times",            true },
+                { "gcode_flavor",               "marlin" },
+                { "silent_mode",                false }
+                });
+            THEN("The time estimator placeholders are replaced") {
+                REQUIRE(gcode.find("_TE_") == std::string::npos);
+                REQUIRE(gcode.find("M73 Q") == std::string::npos);
+            }
+            THEN("The remaining times decrease from the estimated print time to zero") {
+                std::vector<std::pair<int, int>> progress;
+                for (size_t pos = gcode.find("M73 P"); pos != std::string::npos; pos = gcode.find("M73 P", pos + 1)) {
+                    int percent = -1, remaining = -1;
+                    REQUIRE((sscanf(gcode.data() + pos, "M73 P%d R%d", &percent, &remaining) == 2));
+                    progress.emplace_back(percent, remaining);
+                }
+                REQUIRE(progress.size() > 2);
+                REQUIRE(progress.front().first == 0);
+                REQUIRE(progress.front().second > 0);
+                REQUIRE(progress.back() == std::make_pair(100, 0));
+                for (size_t i = 1; i < progress.size(); ++ i) {
+                    REQUIRE(progress[i].first >= progress[i - 1].first);
+                    REQUIRE(progress[i].second <= progress[i - 1].second);
+                }
+            }
+            THEN("The M73 lines are not padded, the first one precedes the first extrusion, the others follow a G1 move with an E word") {
+                std::vector<std::string> lines;
+                for (size_t begin = 0; begin < gcode.size();) {
+                    size_t end = std::min(gcode.find('\n', begin), gcode.size());
+                    lines.emplace_back(gcode.substr(begin, end - begin));
+                    begin = end + 1;
+                }
+                boost::regex M73_regex("M73 P[0-9]+ R[0-9]+");
+                boost::regex extrusion_regex("G1 .*E[-0-9.]+.*");
+                std::vector<size_t> M73_lines;
+                for (size_t i = 0; i < lines.size(); ++ i)
+                    if (boost::starts_with(lines[i], "M73 P"))
+                        M73_lines.emplace_back(i);
+                REQUIRE(M73_lines.size() > 2);
+                REQUIRE(lines[M73_lines.back()] == "M73 P100 R0");
+                REQUIRE(boost::starts_with(lines[M73_lines.front()], "M73 P0 R"));
+                size_t first_extrusion = std::find_if(lines.begin(), lines.end(), [&extrusion_regex](const std::string &line) { return boost::regex_match(line, extrusion_regex); }) - lines.begin();
+                REQUIRE(M73_lines.front() < first_extrusion);
+                for (size_t i = 0; i < M73_lines.size(); ++ i) {
+                    REQUIRE(boost::regex_match(lines[M73_lines[i]], M73_regex));
+                    if (i > 0 && i + 1 < M73_lines.size())
+                        REQUIRE(boost::regex_match(lines[M73_lines[i] - 1], extrusion_regex));
+                }
+            }
+            THEN("The G-code without the M73 lines is the G-code exported without the remaining times") {
+                std::string gcode_no_times = ::Test::slice({ TestMesh::cube_20x20x20 }, {
+                    { "remaining_times",            false },
+                    { "gcode_flavor",               "marlin" },
+                    { "silent_mode",                false }
+                    });
+                // Drop the time stamp, the M73 lines and the remaining_times config value.
+                auto strip = [](const std::string &gcode) {
+                    std::string out;
+                    for (size_t begin = gcode.find('\n') + 1; begin < gcode.size();) {
+                        size_t end = std::min(gcode.find('\n', begin), gcode.size());
+                        std::string line = gcode.substr(begin, end - begin);
+                        if (! boost::starts_with(line, "M73 ") && ! boost::starts_with(line, "; remaining_times = "))
+                            out += line + "\n";
+                        begin = end + 1;
+                    }
+                    return out;
+                };
+                REQUIRE(strip(gcode) == strip(gcode_no_times));
+            }
+        }
         WHEN("end_gcode exists with layer_num and layer_z") {
 			std::string gcode = ::Test::slice({ TestMesh::cube_20x20x20 }, {
 				{ "end_gcode",              "; Layer_num [layer_num]\n; Layer_z [layer_z]" },
@@ -268,3 +344,197 @@ SCENARIO( "PrintGCode basic functionality", "[PrintGCode]") {
         }
     }
 }
+
+// Export the G-code with the given number of threads, drop the first line with the time stamp.
+static std::string slice_with_threads(std::initializer_list<TestMesh> meshes, const DynamicPrintConfig &config, int num_threads)
+{
+    std::string gcode;
+    tbb::task_arena(num_threads).execute([meshes, &config, &gcode]() { gcode = Slic3r::Test::slice(meshes, config); });
+    return gcode.substr(gcode.find('\n') + 1);
+}
+
+SCENARIO("PrintGCode: the layers pipeline does not depend on the number of threads", "[PrintGCode]") {
+    GIVEN("A multi-layer two extruder print of a bridge and a cube with cooling of the first extruder and the bridge fan enabled") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_num_extruders(2);
+        config.set_deserialize({
+            { "perimeter_extruder",         1 },
+            { "infill_extruder",            2 },
+            { "solid_infill_extruder",      2 },
+            { "cooling",                    "1,0" },
+            { "fan_always_on",              "0,1" },
+            { "min_fan_speed",              "20,40" },
+            { "max_fan_speed",              "80,100" },
+            { "bridge_fan_speed",           "100,90" },
+            { "disable_fan_first_layers",   "2,3" },
+            { "fan_below_layer_time",       "100,60" },
+            { "slowdown_below_layer_time",  "15,10" },
+            { "layer_height",               0.3 },
+            { "first_layer_height",         0.3 }
+        });
+        WHEN("the G-code is exported by a single thread and by four threads") {
+            std::string serial   = slice_with_threads({ TestMesh::bridge, TestMesh::cube_20x20x20 }, config, 1);
+            std::string parallel = slice_with_threads({ TestMesh::bridge, TestMesh::cube_20x20x20 }, config, 4);
+            THEN("both extruders are used and the fan is controlled") {
+                REQUIRE(serial.find("\nT1\n") != std::string::npos);
+                REQUIRE(serial.find("\nM106 S") != std::string::npos);
+                REQUIRE(serial.find("\nM107") != std::string::npos);
+            }
+            THEN("the G-code is identical") {
+                REQUIRE(serial == parallel);
+            }
+        }
+    }
+}
+
+SCENARIO("PrintGCode: the seams prepared ahead of the G-code generator do not depend on the number of threads", "[PrintGCode]") {
+    GIVEN("A multi-layer print of a bridge and a cube with aligned seams and avoid crossing perimeters") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize({
+            { "seam_position",              "aligned" },
+            { "avoid_crossing_perimeters",  true },
+            { "perimeters",                 3 },
+            { "layer_height",               0.3 },
+            { "first_layer_height",         0.3 }
+        });
+        WHEN("the G-code is exported by a single thread and by four threads") {
+            std::string serial   = slice_with_threads({ TestMesh::bridge, TestMesh::cube_20x20x20 }, config, 1);
+            std::string parallel = slice_with_threads({ TestMesh::bridge, TestMesh::cube_20x20x20 }, config, 4);
+            THEN("the G-code is identical") {
+                REQUIRE(! serial.empty());
+                REQUIRE(serial == parallel);
+            }
+        }
+    }
+}
+
+SCENARIO("PrintGCode: the normal and the silent time estimators", "[PrintGCode]") {
+    GIVEN("A multi-layer print for a Marlin printer with remaining times") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize({
+            { "gcode_flavor",       "marlin" },
+            { "remaining_times",    true },
+            { "layer_height",       0.3 },
+            { "first_layer_height", 0.3 }
+        });
+        // Export the G-code with the given number of threads, return the estimated times and the G-code without the time stamp.
+        auto estimate = [&config](bool silent_mode, int num_threads) {
+            config.set_deserialize({ { "silent_mode", silent_mode } });
+            Slic3r::Print print;
+            Slic3r::Model model;
+            std::string   gcode;
+            tbb::task_arena(num_threads).execute([&config, &print, &model, &gcode]() {
+                Slic3r::Test::init_print({ TestMesh::bridge, TestMesh::cube_20x20x20 }, print, model, config);
+                gcode = Slic3r::Test::gcode(print);
+            });
+            return std::make_tuple(print.print_statistics().estimated_normal_print_time, print.print_statistics().estimated_silent_print_time, 
+                gcode.substr(gcode.find('\n') + 1));
+        };
+        WHEN("the silent mode is enabled and the G-code is exported by one and by four threads") {
+            auto [normal_serial,   silent_serial,   gcode_serial]   = estimate(true, 1);
+            auto [normal_parallel, silent_parallel, gcode_parallel] = estimate(true, 4);
+            auto [normal_only,     silent_unused,   gcode_normal]   = estimate(false, 4);
+            THEN("both modes are estimated and the silent mode is emitted") {
+                REQUIRE(! normal_serial.empty());
+                REQUIRE(! silent_serial.empty());
+                REQUIRE(gcode_serial.find("M73 Q") != std::string::npos);
+                REQUIRE(gcode_normal.find("M73 Q") == std::string::npos);
+            }
+            THEN("the times and the G-code do not depend on the number of threads") {
+                REQUIRE(normal_parallel == normal_serial);
+                REQUIRE(silent_parallel == silent_serial);
+                REQUIRE(gcode_parallel == gcode_serial);
+            }
+            THEN("the normal time equals the time estimated by the normal estimator alone") {
+                REQUIRE(normal_serial == normal_only);
+            }
+        }
+    }
+}
+
+SCENARIO("PrintGCode: the time estimator is reset", "[PrintGCode]") {
+    GIVEN("An estimator, which processed an extrusion and a G92 without axes setting the origin of the E axis") {
+        const std::string moves =
+            "G1 X10 Y10 F3000\n"
+            "G1 X20 Y10 E5 F1200\n"
+            "G1 X20 Y20 E10\n";
+        GCodeTimeEstimator estimator_fresh(GCodeTimeEstimator::Normal);
+        estimator_fresh.add_gcode_block(moves);
+        estimator_fresh.calculate_time(true);
+        GCodeTimeEstimator estimator(GCodeTimeEstimator::Normal);
+        estimator.add_gcode_block("G1 E500 F600\nG92\n");
+        estimator.calculate_time(true);
+        REQUIRE(estimator.get_axis_origin(GCodeTimeEstimator::E) == 500.f);
+        WHEN("the estimator is reset and the same moves are estimated as by a new estimator") {
+            estimator.reset();
+            estimator.add_gcode_block(moves);
+            estimator.calculate_time(true);
+            THEN("the origin of the E axis is reset") {
+                REQUIRE(estimator.get_axis_origin(GCodeTimeEstimator::E) == 0.f);
+            }
+            THEN("the estimated time is the same as the time estimated by the new estimator") {
+                REQUIRE(estimator.get_time() == Approx(estimator_fresh.get_time()));
+            }
+        }
+    }
+}
+
+SCENARIO("PrintGCode: the analyzer and the time estimators parse the G-code once", "[PrintGCode]") {
+    GIVEN("The G-code of a multi-layer print") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ TestMesh::bridge, TestMesh::cube_20x20x20 }, print, model, {
+            { "gcode_flavor",       "marlin" },
+            { "layer_height",       0.3 },
+            { "first_layer_height", 0.3 }
+        });
+        std::string gcode = Slic3r::Test::gcode(print);
+        // The silent mode estimator with lower machine limits than the normal one.
+        auto init_silent = [](GCodeTimeEstimator &estimator) {
+            estimator.set_acceleration(500.f);
+            estimator.set_max_acceleration(500.f);
+            estimator.set_axis_max_feedrate(GCodeTimeEstimator::X, 100.f);
+            estimator.set_axis_max_feedrate(GCodeTimeEstimator::Y, 100.f);
+        };
+        WHEN("the lines parsed by the analyzer are passed to the normal and the silent time estimators") {
+            GCodeAnalyzer      analyzer;
+            GCodeTimeEstimator normal(GCodeTimeEstimator::Normal);
+            GCodeTimeEstimator silent(GCodeTimeEstimator::Silent);
+            init_silent(silent);
+            std::string gcode_out = analyzer.process_gcode(gcode.c_str(), [&normal, &silent](const GCodeReader::GCodeLine &line) {
+                normal.add_gcode_line(line);
+                silent.add_gcode_line(line);
+            });
+            normal.calculate_time(false);
+            silent.calculate_time(false);
+            GCodePreviewData preview;
+            analyzer.calc_gcode_preview_data(preview);
+
+            GCodeAnalyzer      analyzer_separate;
+            GCodeTimeEstimator normal_separate(GCodeTimeEstimator::Normal);
+            GCodeTimeEstimator silent_separate(GCodeTimeEstimator::Silent);
+            init_silent(silent_separate);
+            std::string gcode_out_separate = analyzer_separate.process_gcode(gcode);
+            normal_separate.add_gcode_block(gcode);
+            silent_separate.add_gcode_block(gcode);
+            normal_separate.calculate_time(false);
+            silent_separate.calculate_time(false);
+            GCodePreviewData preview_separate;
+            analyzer_separate.calc_gcode_preview_data(preview_separate);
+
+            THEN("the estimated times equal the times of the estimators parsing the G-code by themselves") {
+                REQUIRE(normal.get_time() > 0.f);
+                REQUIRE(silent.get_time() > normal.get_time());
+                REQUIRE(normal.get_time() == normal_separate.get_time());
+                REQUIRE(silent.get_time() == silent_separate.get_time());
+            }
+            THEN("the analyzer output and preview equal the ones of the analyzer parsing the G-code alone") {
+                REQUIRE(gcode_out == gcode_out_separate);
+                REQUIRE(! preview.extrusion.layers.empty());
+                REQUIRE(preview.extrusion.layers.size() == preview_separate.extrusion.layers.size());
+                REQUIRE(preview.travel.polylines.size() == preview_separate.travel.polylines.size());
+                REQUIRE(preview.retraction.positions.size() == preview_separate.retraction.positions.size());
+            }
+        }
+    }
+}
@@ -87,3 +87,98 @@ SCENARIO("PrintObject: object layer heights", "[PrintObject]") {
 #endif
     }
 }
+
+static bool surfaces_equal(const Surfaces &surfaces1, const Surfaces &surfaces2)
+{
+    return std::equal(surfaces1.begin(), surfaces1.end(), surfaces2.begin(), surfaces2.end(), [](const Surface &s1, const Surface &s2) {
+        return s1.surface_type == s2.surface_type && s1.thickness == s2.thickness && s1.thickness_layers == s2.thickness_layers &&
+               s1.bridge_angle == s2.bridge_angle && s1.extra_perimeters == s2.extra_perimeters && s1.expolygon == s2.expolygon;
+    });
+}
+
+SCENARIO("PrintObject: layers are reused after the layer height profile is edited", "[PrintObject]") {
+    GIVEN("20mm cube with 0.2mm layers and six top solid layers") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize({
+            { "first_layer_height",         0.2 },
+            { "layer_height",               0.2 },
+            { "top_solid_layers",           6 },
+            { "top_solid_min_thickness",    0 },
+            { "fill_density",               "20%" }
+        });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        Slic3r::Test::gcode(print);
+        const PrintObject &object = *print.objects().front();
+        // Layers, perimeters and fill surfaces before the edit, indexed by the layer ID.
+        std::vector<const Layer*>                  old_layers(object.layers().begin(), object.layers().end());
+        std::vector<const ExtrusionEntity*>        old_perimeters;
+        std::vector<const ExtrusionEntity*>        old_fills;
+        std::vector<Surfaces>                      old_fill_surfaces;
+        for (const Layer *layer : object.layers()) {
+            const LayerRegion *layerm = layer->regions().front();
+            old_perimeters.emplace_back(layerm->perimeters.entities.empty() ? nullptr : layerm->perimeters.entities.front());
+            old_fills.emplace_back(layerm->fills.entities.empty() ? nullptr : layerm->fills.entities.front());
+            old_fill_surfaces.emplace_back(layerm->fill_surfaces.surfaces);
+        }
+        REQUIRE(old_layers.size() == 100);
+
+        WHEN("the layers between 19mm and 19.6mm are replaced by two thicker layers and the object is sliced again") {
+            // The band of two 0.3mm layers replaces three 0.2mm layers, therefore the kept layer at 18.8mm moves
+            // from the seventh to the sixth layer from the top and its fill surfaces become solid.
+            model.objects.front()->layer_height_profile = { 0., 0.2, 19., 0.2, 19., 0.3, 19.6, 0.3, 19.6, 0.2, 20., 0.2 };
+            print.apply(model, config);
+            std::string gcode_edited = Slic3r::Test::gcode(print);
+
+            Slic3r::Print print_fresh;
+            Slic3r::Model model_fresh(model);
+            print_fresh.apply(model_fresh, config);
+            std::string gcode_fresh = Slic3r::Test::gcode(print_fresh);
+            const PrintObject &object_fresh = *print_fresh.objects().front();
+
+            THEN("the layers below and above the band are reused") {
+                REQUIRE(object.layers().size() == 99);
+                for (size_t i = 0; i < 95; ++ i)
+                    REQUIRE(object.layers()[i] == old_layers[i]);
+                REQUIRE(object.layers()[97] == old_layers[98]);
+                REQUIRE(object.layers()[98] == old_layers[99]);
+            }
+            THEN("the perimeters and infill are reused away from the band") {
+                for (size_t i = 0; i < 90; ++ i) {
+                    const LayerRegion *layerm = object.layers()[i]->regions().front();
+                    REQUIRE(layerm->perimeters.entities.front() == old_perimeters[i]);
+                    REQUIRE(layerm->fills.entities.front() == old_fills[i]);
+                }
+            }
+            THEN("the infill of the layer at 18.8mm is regenerated for its new fill surfaces") {
+                const Layer *layer = object.layers()[93];
+                REQUIRE(layer == old_layers[93]);
+                REQUIRE(layer->print_z == Approx(18.8));
+                REQUIRE(layer->regions().front()->perimeters.entities.front() == old_perimeters[93]);
+                REQUIRE(! surfaces_equal(layer->regions().front()->fill_surfaces.surfaces, old_fill_surfaces[93]));
+                REQUIRE(surfaces_equal(layer->regions().front()->fill_surfaces.surfaces, object_fresh.layers()[93]->regions().front()->fill_surfaces.surfaces));
+            }
+            THEN("the layers equal the layers of a fresh slicing of the edited profile") {
+                REQUIRE(object.layers().size() == object_fresh.layers().size());
+                for (size_t i = 0; i < object.layers().size(); ++ i) {
+                    const Layer       *layer        = object.layers()[i];
+                    const Layer       *layer_fresh  = object_fresh.layers()[i];
+                    const LayerRegion *layerm       = layer->regions().front();
+                    const LayerRegion *layerm_fresh = layer_fresh->regions().front();
+                    REQUIRE(layer->id() == layer_fresh->id());
+                    REQUIRE(layer->print_z == Approx(layer_fresh->print_z));
+                    REQUIRE(layer->height == Approx(layer_fresh->height));
+                    REQUIRE(layer->lslices == layer_fresh->lslices);
+                    REQUIRE(surfaces_equal(layerm->fill_surfaces.surfaces, layerm_fresh->fill_surfaces.surfaces));
+                    REQUIRE(layerm->perimeters.entities.size() == layerm_fresh->perimeters.entities.size());
+                    REQUIRE(layerm->fills.entities.size() == layerm_fresh->fills.entities.size());
+                }
+            }
+            THEN("the G-code equals the G-code of a fresh slicing of the edited profile") {
+                // Skip the first line with the time stamp.
+                REQUIRE(gcode_edited.substr(gcode_edited.find('\n')) == gcode_fresh.substr(gcode_fresh.find('\n')));
+            }
+        }
+    }
+}
@@ -10,6 +10,8 @@
 #include <future>
 #include <chrono>
 
+#include <tbb/task_arena.h>
+
 //#include "test_options.hpp"
 #include "test_data.hpp"
 
@@ -228,6 +230,65 @@ SCENARIO( "TriangleMesh: slice behavior.") {
     }
 }
 
+SCENARIO( "TriangleMeshSlicer: Slicing does not depend on the number of threads.") {
+    GIVEN( "A finely tessellated sphere") {
+        TriangleMesh sphere = make_sphere(10., 2. * PI / 180.);
+        sphere.require_shared_vertices();
+        std::vector<float> z;
+        for (float h = -9.95f; h < 10.f; h += 0.1f)
+            z.emplace_back(h);
+        WHEN( "it is sliced by a single thread and by all threads") {
+            TriangleMeshSlicer slicer(&sphere);
+            std::vector<Polygons> serial, parallel;
+            tbb::task_arena(1).execute([&slicer, &z, &serial]() { slicer.slice(z, SlicingMode::Regular, &serial, [](){}); });
+            slicer.slice(z, SlicingMode::Regular, &parallel, [](){});
+            THEN( "the slices are identical") {
+                REQUIRE(serial.size() == z.size());
+                REQUIRE(serial == parallel);
+            }
+        }
+        WHEN( "only a band of the layers is sliced") {
+            TriangleMeshSlicer slicer(&sphere);
+            std::vector<Polygons> all, band;
+            slicer.slice(z, SlicingMode::Regular, &all, [](){});
+            slicer.slice(std::vector<float>(z.begin() + 50, z.begin() + 70), SlicingMode::Regular, &band, [](){});
+            THEN( "the slices match the slices of the whole object") {
+                REQUIRE(band.size() == 20);
+                REQUIRE(band == std::vector<Polygons>(all.begin() + 50, all.begin() + 70));
+            }
+        }
+        WHEN( "single layers are sliced") {
+            TriangleMeshSlicer slicer(&sphere);
+            std::vector<Polygons> all;
+            slicer.slice(z, SlicingMode::Regular, &all, [](){});
+            THEN( "the slices match the slices of the whole object") {
+                for (size_t i : { 0, 50, 100, 199 }) {
+                    std::vector<Polygons> single;
+                    slicer.slice({ z[i] }, SlicingMode::Regular, &single, [](){});
+                    REQUIRE(single.size() == 1);
+                    REQUIRE(single.front() == all[i]);
+                }
+            }
+        }
+        WHEN( "the up direction is changed and restored") {
+            TriangleMeshSlicer slicer(&sphere);
+            std::vector<Polygons> all, tilted, tilted_again, restored;
+            slicer.slice(z, SlicingMode::Regular, &all, [](){});
+            slicer.set_up_direction(Vec3f(1.f, 1.f, 1.f).normalized());
+            slicer.slice(z, SlicingMode::Regular, &tilted, [](){});
+            slicer.set_up_direction(Vec3f(1.f, 1.f, 1.f).normalized());
+            slicer.slice(z, SlicingMode::Regular, &tilted_again, [](){});
+            slicer.set_up_direction(Vec3f::UnitZ());
+            slicer.slice(z, SlicingMode::Regular, &restored, [](){});
+            THEN( "the slices follow the up direction") {
+                REQUIRE(tilted != all);
+                REQUIRE(tilted_again == tilted);
+                REQUIRE(restored == all);
+            }
+        }
+    }
+}
+
 SCENARIO( "make_xxx functions produce meshes.") {
     GIVEN("make_cube() function") {
         WHEN("make_cube() is called with arguments 20,20,20") {
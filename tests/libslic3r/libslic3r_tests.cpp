@@ -38,4 +38,12 @@ TEST_CASE("string_printf", "[utils]") {
     }
 }
 
+TEST_CASE("json_escape", "[utils]") {
+    REQUIRE(Slic3r::json_escape("object.stl") == "object.stl");
+    REQUIRE(Slic3r::json_escape("a \"b\" \\ c") == "a \\\"b\\\" \\\\ c");
+    REQUIRE(Slic3r::json_escape("line\nline\r\ttab") == "line\\nline\\r\\ttab");
+    REQUIRE(Slic3r::json_escape(std::string("\x01\x1f", 2)) == "\\u0001\\u001f");
+    REQUIRE(Slic3r::json_escape("P\xc5\x99\xc3\xadklad") == "P\xc5\x99\xc3\xadklad");
+}
+
 }
@@ -225,6 +225,90 @@ SCENARIO("Various Clipper operations - t/clipper.t", "[ClipperUtils]") {
     }
 }
 
+SCENARIO("ClipperContext chains Clipper operations", "[ClipperUtils]") {
+    GIVEN("overlapping squares with a hole, a triangle and an expolygon") {
+        Slic3r::Polygon   square  { { 0, 0 }, { 4000000, 0 }, { 4000000, 4000000 }, { 0, 4000000 } };
+        Slic3r::Polygon   square2 { { 2500000, 1000000 }, { 6000000, 1000000 }, { 6000000, 3000000 }, { 2500000, 3000000 } };
+        Slic3r::Polygon   hole    { { 1000000, 1000000 }, { 1000000, 2000000 }, { 2000000, 2000000 }, { 2000000, 1000000 } };
+        Slic3r::Polygon   triangle { { -1000000, -1000000 }, { 3000000, -500000 }, { 1500000, 2500000 } };
+        Polygons          polygons { square, square2, hole };
+        ExPolygons        expolygons { ExPolygon(square, hole) };
+        WHEN("offset, intersection and diff are chained") {
+            Polygons result = ClipperContext(polygons).offset(123456.f, jtMiter, 3.).intersection(Polygons{ triangle }).diff(Polygons{ hole }).polygons();
+            THEN("the result matches the chain of the Polygons functions") {
+                REQUIRE(! result.empty());
+                REQUIRE(result == diff(intersection(offset(polygons, 123456.f, jtMiter, 3.), { triangle }), { hole }));
+            }
+        }
+        WHEN("union and square offset of expolygons are chained") {
+            Polygons result = ClipperContext(expolygons).union_().offset(-100000.f, jtSquare, 0.).polygons();
+            THEN("the result matches the chain of the Polygons functions") {
+                REQUIRE(result == offset(union_(to_polygons(expolygons)), -100000.f, jtSquare, 0.));
+            }
+        }
+        WHEN("a context is subtracted from another context") {
+            ClipperContext clip(expolygons);
+            clip.offset(50000.f);
+            ExPolygons result = ClipperContext(polygons).union_().diff(clip).expolygons();
+            THEN("the result matches the chain of the Polygons functions") {
+                REQUIRE(result == union_ex(diff(union_(polygons), offset(to_polygons(expolygons), 50000.f))));
+            }
+        }
+        WHEN("a round offset is followed by an intersection with expolygons") {
+            Polygons result = ClipperContext(Polygons{ triangle }).offset(200000.f, jtRound, 10000.).intersection(expolygons).polygons();
+            THEN("the result matches the chain of the Polygons functions") {
+                REQUIRE(result == intersection(offset(Polygons{ triangle }, 200000.f, jtRound, 10000.), to_polygons(expolygons)));
+            }
+        }
+    }
+}
+
+SCENARIO("Parallel union and offset of large polygon sets", "[ClipperUtils]") {
+    GIVEN("a grid of rings, some of them overlapping, with holes") {
+        // The rings of a row are shifted in Y by a small amount for their lowest points not to share the same Y,
+        // thus the Clipper library orders the serial output uniquely.
+        Polygons polygons;
+        for (int row = 0; row < 30; ++ row)
+            for (int col = 0; col < 30; ++ col) {
+                // Neighbor rings of every third column overlap, the other rings are 2mm apart.
+                Point center(col * 6000000 - (col % 3 == 1 ? 2500000 : 0), row * 6000000 + col * 1000);
+                Polygon outer, hole;
+                for (int i = 0; i < 24; ++ i) {
+                    double angle = 2. * M_PI * i / 24.;
+                    outer.points.emplace_back(center + Point(coord_t(2000000. * cos(angle)), coord_t(2000000. * sin(angle))));
+                    hole .points.emplace_back(center + Point(coord_t(800000. * cos(- angle)), coord_t(800000. * sin(- angle))));
+                }
+                polygons.emplace_back(std::move(outer));
+                polygons.emplace_back(std::move(hole));
+            }
+        WHEN("united in parallel") {
+            THEN("the result matches the serial union") {
+                Polygons serial = union_(polygons);
+                REQUIRE(serial.size() > 1000);
+                REQUIRE(union_parallel(polygons) == serial);
+            }
+            THEN("the result with a second set of polygons matches the serial union") {
+                Polygons polygons2 { Polygon::new_scale({ { 0, 0 }, { 20, 0 }, { 20, 20 }, { 0, 20 } }) };
+                REQUIRE(union_parallel(polygons, polygons2) == union_(polygons, polygons2));
+            }
+            THEN("the ExPolygons result matches the serial union") {
+                REQUIRE(union_parallel_ex(polygons) == union_ex(polygons));
+            }
+        }
+        WHEN("offsetted in parallel") {
+            THEN("the outer mitered offset matches the serial offset") {
+                REQUIRE(offset_parallel(polygons, 300000.f) == offset(polygons, 300000.f));
+            }
+            THEN("the outer square offset matches the serial offset") {
+                REQUIRE(offset_parallel(polygons, 400000.f, jtSquare) == offset(polygons, 400000.f, jtSquare));
+            }
+            THEN("the inner offset matches the serial offset") {
+                REQUIRE(offset_parallel(polygons, -200000.f) == offset(polygons, -200000.f));
+            }
+        }
+    }
+}
+
 template<e_ordering o = e_ordering::OFF, class P, class Tree> 
 double polytree_area(const Tree &tree, std::vector<P> *out)
 {
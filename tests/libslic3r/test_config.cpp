@@ -2,6 +2,8 @@
 
 #include "libslic3r/PrintConfig.hpp"
 
+#include <boost/algorithm/string/predicate.hpp>
+
 using namespace Slic3r;
 
 SCENARIO("Generic config validation performs as expected.", "[Config]") {
@@ -201,3 +203,27 @@ SCENARIO("Config ini load/save interface", "[Config]") {
         }
     }
 }
+
+SCENARIO("Print step dependencies of the config options", "[Config]") {
+    GIVEN("The options of the PrintConfig, PrintObjectConfig and PrintRegionConfig") {
+        t_config_option_keys keys = PrintConfig().keys();
+        append(keys, PrintObjectConfig().keys());
+        append(keys, PrintRegionConfig().keys());
+        THEN("The steps to be invalidated on a change are known for each option") {
+            for (const t_config_option_key &opt_key : keys) {
+                INFO("Option " << opt_key);
+                REQUIRE(print_step_dependency(opt_key) != nullptr);
+            }
+        }
+        THEN("The options of the speeds and temperatures only invalidate the G-code export or the wipe tower") {
+            for (const t_config_option_key &opt_key : keys)
+                if (boost::ends_with(opt_key, "_speed") || boost::ends_with(opt_key, "temperature")) {
+                    INFO("Option " << opt_key);
+                    const PrintStepDependency *dependency = print_step_dependency(opt_key);
+                    // Gap fill is disabled by a zero gap_fill_speed, the regions are ironed together if ironed with the same speed.
+                    if (opt_key != "gap_fill_speed" && opt_key != "ironing_speed")
+                        REQUIRE(dependency->object_steps.empty());
+                }
+        }
+    }
+}
@@ -8,6 +8,7 @@
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/ClipperUtils.hpp"
 #include "libslic3r/ShortestPath.hpp"
+#include "libslic3r/EdgeGrid.hpp"
 
 using namespace Slic3r;
 
@@ -321,6 +322,38 @@ SCENARIO("Path chaining", "[Geometry]") {
 			}
 		}
 	}
+	GIVEN("Many random segments") {
+		std::vector<ExtrusionPath> paths;
+		Polylines polylines;
+		unsigned int seed = 1;
+		auto random_coord = [&seed]() { seed = seed * 1103515245 + 12345; return coord_t((seed >> 4) % 100000000); };
+		// Enough segments for the fast chaining to search a grid hash.
+		for (size_t i = 0; i < 300; ++ i) {
+			Point a(random_coord(), random_coord());
+			Point b = a + Point(random_coord() / 20 - 2500000, random_coord() / 20 - 2500000);
+			polylines.push_back(Polyline(a, b));
+			paths.emplace_back(erInternalInfill);
+			paths.back().polyline = polylines.back();
+		}
+		Point start_near(0, 0);
+		THEN("The fast chaining searching a grid hash orders the paths as the default chaining searching a KD tree") {
+			REQUIRE(chain_extrusion_paths(paths, &start_near, ChainingMode::Fast) == chain_extrusion_paths(paths, &start_near));
+		}
+		THEN("Each mode of polyline chaining visits all the polylines") {
+			// End points of the polylines independent of their orientation, sorted.
+			auto end_points = [](const Polylines &polylines) {
+				std::vector<std::pair<Point, Point>> out;
+				for (const Polyline &pl : polylines)
+					out.emplace_back(std::min(pl.first_point(), pl.last_point(), [](const Point &l, const Point &r) { return l.x() < r.x() || (l.x() == r.x() && l.y() < r.y()); }),
+					                 std::max(pl.first_point(), pl.last_point(), [](const Point &l, const Point &r) { return l.x() < r.x() || (l.x() == r.x() && l.y() < r.y()); }));
+				std::sort(out.begin(), out.end(), [](const std::pair<Point, Point> &l, const std::pair<Point, Point> &r) {
+					return std::make_tuple(l.first.x(), l.first.y(), l.second.x(), l.second.y()) < std::make_tuple(r.first.x(), r.first.y(), r.second.x(), r.second.y()); });
+				return out;
+			};
+			for (ChainingMode mode : { ChainingMode::Default, ChainingMode::Fast })
+				REQUIRE(end_points(chain_polylines(polylines, nullptr, mode)) == end_points(polylines));
+		}
+	}
 }
 
 SCENARIO("Line distances", "[Geometry]"){
@@ -452,3 +485,65 @@ SCENARIO("Ported from xs/t/14_geometry.t", "[Geometry]"){
     	REQUIRE(! Slic3r::Geometry::directions_parallel(M_PI /2, PI, M_PI /180));
     }
 }
+
+SCENARIO("EdgeGrid distance queries", "[Geometry]"){
+    GIVEN("a square with a square hole rasterized into an edge grid with a signed distance field") {
+        ExPolygon expoly;
+        expoly.contour = Slic3r::Polygon(Points({ { 0, 0 }, { scaled(20.), 0 }, { scaled(20.), scaled(20.) }, { 0, scaled(20.) } }));
+        expoly.holes.emplace_back(Points({ { scaled(5.), scaled(5.) }, { scaled(5.), scaled(15.) }, { scaled(15.), scaled(15.) }, { scaled(15.), scaled(5.) } }));
+        const coord_t resolution = scaled(1.);
+        EdgeGrid::Grid grid;
+        grid.create(expoly, resolution);
+        grid.calculate_sdf();
+        auto exact_distance = [&expoly](const Point &pt) {
+            double d = std::numeric_limits<double>::max();
+            for (const Line &line : expoly.lines())
+                d = std::min(d, line.distance_to(pt));
+            return expoly.contains(pt) ? d : - d;
+        };
+        THEN("closest_point() and signed_distance() match the exact distance to the contours") {
+            const coord_t search_radius = scaled(2.);
+            // 1 if the sign of the distance inside the material is positive, -1 if negative, 0 if not known yet.
+            int           sign_inside   = 0;
+            bool          all_match     = true;
+            for (double y = -3.13; y < 23.; y += 0.71)
+                for (double x = -3.07; x < 23.; x += 0.67) {
+                    const Point  pt(scaled(x), scaled(y));
+                    const double expected = exact_distance(pt);
+                    EdgeGrid::Grid::ClosestPointResult closest = grid.closest_point(pt, search_radius);
+                    coordf_t     dist;
+                    if (std::abs(expected) < search_radius) {
+                        if (! closest.valid() || ! grid.signed_distance(pt, search_radius, dist) ||
+                            std::abs(std::abs(closest.distance) - std::abs(expected)) > 1. || std::abs(dist - closest.distance) > 1.)
+                            all_match = false;
+                        else if (std::abs(expected) > SCALED_EPSILON) {
+                            // The sign of the distance inside the material is the same everywhere and opposite to the outside.
+                            int sign = ((closest.distance > 0) == (expected > 0)) ? 1 : -1;
+                            if (sign_inside == 0)
+                                sign_inside = sign;
+                            else if (sign != sign_inside)
+                                all_match = false;
+                        }
+                    } else if (std::abs(expected) > search_radius + SCALED_EPSILON && closest.valid())
+                        all_match = false;
+                }
+            REQUIRE(all_match);
+        }
+        THEN("the signed distance field approximates the distance to the contours") {
+            const bool positive_inside = grid.signed_distance_bilinear(Point(scaled(10.), scaled(2.5))) > 0;
+            bool       all_match       = true;
+            for (double y = 0.37; y < 20.; y += 0.71)
+                for (double x = 0.29; x < 20.; x += 0.67) {
+                    const Point  pt(scaled(x), scaled(y));
+                    const double expected = exact_distance(pt);
+                    const float  sdf      = grid.signed_distance_bilinear(pt);
+                    // Outside of the narrow band around the contours, the sign of the distance field is reliable.
+                    if (std::abs(expected) > 2. * resolution && ((sdf > 0) == positive_inside) != (expected > 0))
+                        all_match = false;
+                    if (std::abs(std::abs(sdf) - std::abs(expected)) > resolution)
+                        all_match = false;
+                }
+            REQUIRE(all_match);
+        }
+    }
+}
@@ -1,8 +1,16 @@
 #include <catch2/catch.hpp>
 
 #include "libslic3r/Model.hpp"
+#include "libslic3r/Format/OBJ.hpp"
 #include "libslic3r/Format/STL.hpp"
 
+#include <algorithm>
+#include <array>
+#include <map>
+#include <random>
+
+#include <boost/filesystem/operations.hpp>
+
 using namespace Slic3r;
 
 static inline std::string stl_path(const char* path)
@@ -55,3 +63,205 @@ SCENARIO("Reading an STL file", "[stl]") {
 		}
 	}
 }
+
+static bool stl_files_equal(const stl_file &stl1, const stl_file &stl2)
+{
+	if (stl1.stats.type != stl2.stats.type || stl1.stats.number_of_facets != stl2.stats.number_of_facets ||
+		stl1.stats.original_num_facets != stl2.stats.original_num_facets || memcmp(stl1.stats.header, stl2.stats.header, sizeof(stl1.stats.header)) != 0 ||
+		stl1.stats.min != stl2.stats.min || stl1.stats.max != stl2.stats.max || stl1.stats.size != stl2.stats.size ||
+		stl1.stats.bounding_diameter != stl2.stats.bounding_diameter || stl1.stats.shortest_edge != stl2.stats.shortest_edge ||
+		stl1.facet_start.size() != stl2.facet_start.size() || stl1.neighbors_start.size() != stl2.neighbors_start.size())
+		return false;
+	for (size_t i = 0; i < stl1.facet_start.size(); ++ i) {
+		const stl_facet &f1 = stl1.facet_start[i];
+		const stl_facet &f2 = stl2.facet_start[i];
+		if (f1.normal != f2.normal || f1.vertex[0] != f2.vertex[0] || f1.vertex[1] != f2.vertex[1] || f1.vertex[2] != f2.vertex[2] ||
+			f1.extra[0] != f2.extra[0] || f1.extra[1] != f2.extra[1])
+			return false;
+	}
+	return true;
+}
+
+SCENARIO("Reading a binary STL file through a memory mapping", "[stl]") {
+	GIVEN("a binary STL file written from tests/data/extruder_idler.obj") {
+		Model model;
+		REQUIRE(load_obj((std::string(TEST_DATA_DIR) + "/extruder_idler.obj").c_str(), &model));
+		TriangleMesh mesh = model.objects.front()->raw_mesh();
+		std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.stl")).string();
+		REQUIRE(stl_write_binary(&mesh.stl, path.c_str(), "extruder_idler"));
+		const uintmax_t file_size = boost::filesystem::file_size(path);
+		REQUIRE(mesh.stl.stats.number_of_facets > 100);
+		REQUIRE(file_size == HEADER_SIZE + mesh.stl.stats.number_of_facets * SIZEOF_STL_FACET);
+		WHEN("the file is read") {
+			stl_file stl_mapped, stl_stdio;
+			bool     mapped = stl_open(&stl_mapped, path.c_str());
+			bool     stdio  = stl_open_stdio(&stl_stdio, path.c_str());
+			THEN("the memory mapped file reads the same as the stdio file") {
+				REQUIRE(mapped);
+				REQUIRE(stdio);
+				REQUIRE(stl_mapped.stats.type == binary);
+				REQUIRE(stl_mapped.stats.number_of_facets == mesh.stl.stats.number_of_facets);
+				REQUIRE(stl_files_equal(stl_mapped, stl_stdio));
+			}
+		}
+		WHEN("the file is truncated at a facet boundary") {
+			boost::filesystem::resize_file(path, file_size - 10 * SIZEOF_STL_FACET);
+			stl_file stl_mapped, stl_stdio;
+			bool     mapped = stl_open(&stl_mapped, path.c_str());
+			bool     stdio  = stl_open_stdio(&stl_stdio, path.c_str());
+			THEN("both readers load the facets left in the file, ignoring the number of facets in the header") {
+				REQUIRE(mapped);
+				REQUIRE(stdio);
+				REQUIRE(stl_mapped.stats.number_of_facets == mesh.stl.stats.number_of_facets - 10);
+				REQUIRE(stl_files_equal(stl_mapped, stl_stdio));
+			}
+		}
+		WHEN("the file is truncated inside a facet") {
+			boost::filesystem::resize_file(path, file_size - SIZEOF_STL_FACET / 2);
+			stl_file stl_mapped, stl_stdio;
+			bool     mapped = stl_open(&stl_mapped, path.c_str());
+			bool     stdio  = stl_open_stdio(&stl_stdio, path.c_str());
+			THEN("both readers fail") {
+				REQUIRE(! mapped);
+				REQUIRE(! stdio);
+			}
+		}
+		WHEN("the file is truncated to an empty file") {
+			boost::filesystem::resize_file(path, 0);
+			stl_file stl_mapped;
+			THEN("reading fails") {
+				REQUIRE(! stl_open(&stl_mapped, path.c_str()));
+			}
+		}
+		boost::filesystem::remove(path);
+	}
+}
+
+// Reference of stl_check_facets_exact(), connecting the edges one by one in the order of the facets the way the former hash table
+// of edges did: An edge is connected to the first edge with an equal key, which belongs to another facet and which was not connected yet.
+static void stl_check_facets_exact_serial(stl_file *stl)
+{
+	stl->stats.connected_edges         = 0;
+	stl->stats.connected_facets_1_edge = 0;
+	stl->stats.connected_facets_2_edge = 0;
+	stl->stats.connected_facets_3_edge = 0;
+	for (uint32_t i = 0; i < stl->stats.number_of_facets;) {
+		stl_facet &facet = stl->facet_start[i];
+		if (facet.vertex[0] == facet.vertex[1] || facet.vertex[1] == facet.vertex[2] || facet.vertex[0] == facet.vertex[2]) {
+			facet = stl->facet_start[-- stl->stats.number_of_facets];
+			stl->facet_start.pop_back();
+			stl->neighbors_start.pop_back();
+			stl->stats.facets_removed += 1;
+			stl->stats.degenerate_facets += 1;
+		} else
+			++ i;
+	}
+	for (stl_neighbors &neighbors : stl->neighbors_start)
+		neighbors.reset();
+
+	auto connect = [stl](int facet_a, int which_edge_a, int facet_b, int which_edge_b) {
+		// Facets with both edges stored forward or both backwards are oriented in opposite directions.
+		int flipped = ((which_edge_a < 3) == (which_edge_b < 3)) ? 3 : 0;
+		stl->neighbors_start[facet_a].neighbor[which_edge_a % 3]         = facet_b;
+		stl->neighbors_start[facet_a].which_vertex_not[which_edge_a % 3] = char((which_edge_b + 2) % 3 + flipped);
+		stl->neighbors_start[facet_b].neighbor[which_edge_b % 3]         = facet_a;
+		stl->neighbors_start[facet_b].which_vertex_not[which_edge_b % 3] = char((which_edge_a + 2) % 3 + flipped);
+		stl->stats.connected_edges += 2;
+	};
+	// Edges not connected yet by their key: the lower vertex first, negative zeros switched to positive zeros.
+	std::map<std::array<float, 6>, std::vector<std::pair<int, int>>> unconnected;
+	for (uint32_t i = 0; i < stl->stats.number_of_facets; ++ i) {
+		const stl_facet &facet = stl->facet_start[i];
+		for (int j = 0; j < 3; ++ j) {
+			const stl_vertex *a = &facet.vertex[j];
+			const stl_vertex *b = &facet.vertex[(j + 1) % 3];
+			stl->stats.shortest_edge = std::min(stl->stats.shortest_edge, (*a - *b).cwiseAbs().maxCoeff());
+			int which_edge = j;
+			if (! ((*a)(0) != (*b)(0) ? (*a)(0) < (*b)(0) : (*a)(1) != (*b)(1) ? (*a)(1) < (*b)(1) : (*a)(2) < (*b)(2))) {
+				std::swap(a, b);
+				which_edge += 3;
+			}
+			std::vector<std::pair<int, int>> &edges = unconnected[{ (*a)(0) + 0.f, (*a)(1) + 0.f, (*a)(2) + 0.f, (*b)(0) + 0.f, (*b)(1) + 0.f, (*b)(2) + 0.f }];
+			auto it = std::find_if(edges.begin(), edges.end(), [i](const std::pair<int, int> &edge) { return edge.first != int(i); });
+			if (it == edges.end())
+				edges.emplace_back(int(i), which_edge);
+			else {
+				connect(int(i), which_edge, it->first, it->second);
+				edges.erase(it);
+			}
+		}
+	}
+	for (const stl_neighbors &neighbors : stl->neighbors_start) {
+		int num_neighbors = neighbors.num_neighbors();
+		stl->stats.connected_facets_1_edge += num_neighbors > 0;
+		stl->stats.connected_facets_2_edge += num_neighbors > 1;
+		stl->stats.connected_facets_3_edge += num_neighbors > 2;
+	}
+}
+
+SCENARIO("Connecting the facets by exact edge matching", "[stl]") {
+	GIVEN("tests/data/extruder_idler.obj with holes, degenerate, duplicate and flipped facets") {
+		Model model;
+		REQUIRE(load_obj((std::string(TEST_DATA_DIR) + "/extruder_idler.obj").c_str(), &model));
+		const stl_file &src = model.objects.front()->volumes.front()->mesh().stl;
+		std::vector<stl_facet> facets;
+		for (size_t i = 0; i < src.facet_start.size(); ++ i) {
+			stl_facet facet = src.facet_start[i];
+			if (i % 37 == 0)
+				// Leave a hole.
+				continue;
+			facets.emplace_back(facet);
+			if (i % 41 == 0) {
+				// Degenerate facet.
+				facet.vertex[2] = facet.vertex[0];
+				facets.emplace_back(facet);
+			} else if (i % 43 == 0) {
+				// The same facet twice, the third facet sharing its edges is flipped.
+				facets.emplace_back(facet);
+				std::swap(facet.vertex[1], facet.vertex[2]);
+				facets.emplace_back(facet);
+			}
+		}
+		std::shuffle(facets.begin(), facets.end(), std::mt19937(0));
+		stl_file stl;
+		stl.stats.type             = inmemory;
+		stl.stats.number_of_facets = uint32_t(facets.size());
+		stl.stats.original_num_facets = int(facets.size());
+		stl_allocate(&stl);
+		stl.facet_start = facets;
+		bool first = true;
+		for (const stl_facet &facet : stl.facet_start)
+			stl_facet_stats(&stl, facet, first);
+		stl.stats.shortest_edge = stl.stats.size.maxCoeff();
+		WHEN("the facets are connected in parallel and through the serial hash table") {
+			stl_file stl_parallel = stl;
+			stl_file stl_serial   = stl;
+			stl_check_facets_exact(&stl_parallel);
+			stl_check_facets_exact_serial(&stl_serial);
+			THEN("the mesh has open and degenerate edges") {
+				REQUIRE(stl_serial.stats.degenerate_facets > 0);
+				REQUIRE(stl_serial.stats.connected_edges < int(stl_serial.stats.number_of_facets * 3));
+			}
+			THEN("the statistics are the same") {
+				REQUIRE(stl_parallel.stats.number_of_facets        == stl_serial.stats.number_of_facets);
+				REQUIRE(stl_parallel.stats.degenerate_facets       == stl_serial.stats.degenerate_facets);
+				REQUIRE(stl_parallel.stats.facets_removed          == stl_serial.stats.facets_removed);
+				REQUIRE(stl_parallel.stats.shortest_edge           == stl_serial.stats.shortest_edge);
+				REQUIRE(stl_parallel.stats.connected_edges         == stl_serial.stats.connected_edges);
+				REQUIRE(stl_parallel.stats.connected_facets_1_edge == stl_serial.stats.connected_facets_1_edge);
+				REQUIRE(stl_parallel.stats.connected_facets_2_edge == stl_serial.stats.connected_facets_2_edge);
+				REQUIRE(stl_parallel.stats.connected_facets_3_edge == stl_serial.stats.connected_facets_3_edge);
+			}
+			THEN("the neighbors are the same") {
+				REQUIRE(stl_files_equal(stl_parallel, stl_serial));
+				bool neighbors_equal = true;
+				for (size_t i = 0; i < stl_serial.neighbors_start.size(); ++ i)
+					for (int j = 0; j < 3; ++ j)
+						neighbors_equal &=
+							stl_parallel.neighbors_start[i].neighbor[j]         == stl_serial.neighbors_start[i].neighbor[j] &&
+							stl_parallel.neighbors_start[i].which_vertex_not[j] == stl_serial.neighbors_start[i].which_vertex_not[j];
+				REQUIRE(neighbors_equal);
+			}
+		}
+	}
+}